@@ -0,0 +1,62 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <fmt/format.h>
+#include <args/actions.hpp>
+#include <cov/app/args.hh>
+#include <cov/app/cov_gc_tr.hh>
+#include <cov/app/cov_tr.hh>
+#include <cov/app/errors_tr.hh>
+#include <cov/app/path.hh>
+#include <cov/app/rt_path.hh>
+#include <cov/repository.hh>
+
+namespace cov::app::builtin::gc {
+	struct parser : base_parser<errlng, covlng, gclng> {
+		parser(::args::args_view const& arguments,
+		       str::translator_open_info const& langs);
+
+		cov::repository open_here() const {
+			return cov::app::open_here(*this, tr_);
+		}
+	};
+
+	parser::parser(::args::args_view const& arguments,
+	               str::translator_open_info const& langs)
+	    : base_parser{langs, arguments} {}
+
+	int handle(std::string_view tool, args::arglist args) {
+		using namespace str;
+		parser p{{tool, args},
+		         {platform::locale_dir(), ::lngs::system_locales()}};
+		p.parse();
+		auto repo = p.open_here();
+
+		std::error_code ec{};
+		auto const stats = repo.repack(ec);
+		if (ec) p.error(ec, p.tr());
+
+		// reports added before the graph existed are picked up from all
+		// the branches and tags, and from a detached HEAD
+		if (auto const HEAD = repo.current_head(); HEAD.tip)
+			repo.update_report_graph(*HEAD.tip);
+		auto refs = repo.refs()->iterator();
+		for (auto ref : *refs) {
+			auto const tip = ref->peel_target()->direct_target();
+			if (tip) repo.update_report_graph(*tip);
+		}
+
+		if (!stats.packed_objects) {
+			fmt::print("{}\n", p.tr()(gclng::NOTHING_TO_PACK));
+			return 0;
+		}
+
+		using str::cov_gc::counted;
+		fmt::print("{}\n", fmt::format(fmt::runtime(p.tr()(
+		                                   counted::PACKED_OBJECTS,
+		                                   static_cast<intmax_t>(
+		                                       stats.packed_objects))),
+		                               stats.packed_objects));
+		return 0;
+	}
+}  // namespace cov::app::builtin::gc
@@ -30,8 +30,13 @@ namespace cov::app::builtin::log {
 			return cov::app::open_here(*this, tr_);
 		}
 
+		// with --verbose, tells how well the object cache did, while the
+		// reports were listed
+		void print_cache_stats(cov::repository const& repo) const;
+
 		std::optional<std::string> rev{};
 		std::optional<unsigned> count{};
+		bool verbose{};
 		show_range show{};
 	};
 
@@ -47,6 +52,9 @@ namespace cov::app::builtin::log {
 		parser_.arg(count, "n", "max-count")
 		    .meta(tr_(loglng::NUMBER_META))
 		    .help(tr_(loglng::MAX_COUNT_DESCRIPTION));
+		parser_.set<std::true_type>(verbose, "v", "verbose")
+		    .help(tr_(loglng::VERBOSE_DESCRIPTION))
+		    .opt();
 		show.add_args(parser_, tr_);
 	}
 
@@ -66,6 +74,14 @@ namespace cov::app::builtin::log {
 		return result;
 	}  // GCOV_EXCL_LINE[GCC]
 
+	void parser::print_cache_stats(cov::repository const& repo) const {
+		if (!verbose) return;
+
+		auto const stats = repo.cache_stats();
+		fmt::print("{}\n", tr_.format(loglng::MESSAGE_CACHE_STATS, stats.hits,
+		                              stats.misses, stats.evictions));
+	}
+
 	int handle(std::string_view tool, args::arglist args) {
 		using namespace str;
 		parser p{{tool, args},
@@ -77,6 +93,7 @@ namespace cov::app::builtin::log {
 		}
 
 		p.show.print(info.repo, info.range, p.count);
+		p.print_cache_stats(info.repo);
 		return 0;
 	}
 }  // namespace cov::app::builtin::log
@@ -21,26 +21,30 @@ namespace cov::app::builtin::report {
 		using namespace str;
 		parser p{{tool, args},
 		         {platform::locale_dir(), ::lngs::system_locales()}};
-		auto [repo, report, props] = p.parse();
+		auto parsed = p.parse();
+		auto& repo = parsed.repo;
+		auto const& report = parsed.report();
 
 		std::error_code ec{};
 		auto const commit = git_commit::load(repo.git(), report.git.head, ec);
 		if (ec) {
 			p.data_error(replng::ERROR_CANNOT_LOAD_COMMIT);
 		}
-		auto files = stored_file::from(commit, report.files, p);
+		auto const jobs = p.jobs();
+		// each file is verified and its contents stored once, no matter
+		// how many builds have it
+		auto files = stored_file::from(commit, report.files, p, jobs);
 
-		auto it = files.begin();
-		for (auto const& file : report.files) {
-			auto& compiled = *it++;
-			compiled.store(repo, file, p);
-		}
+		// all the coverage objects of this report go to a single pack
+		repo.begin_batch();
+		stored_file::store(repo, report.files, files, p, jobs);
 
 		git::oid file_coverage{};
 		if (!stored_file::store_tree(file_coverage, repo, report.files,
 		                             files)) {
 			// GCOV_EXCL_START
 			[[unlikely]];
+			repo.rollback_batch();
 			p.data_error(replng::ERROR_CANNOT_WRITE_TO_DB);
 		}  // GCOV_EXCL_STOP
 
@@ -51,11 +55,42 @@ namespace cov::app::builtin::report {
 		auto const now = std::chrono::floor<std::chrono::seconds>(
 		    std::chrono::system_clock::now());
 
-		git::oid build_id{};
-		p.store_build(build_id, repo, file_coverage, now, coverage, props);
-
 		cov::report::builder builds{};
-		builds.add(build_id, props, coverage);
+		for (auto const& input : parsed.inputs) {
+			// a single build is the whole report
+			auto build_coverage = coverage;
+			auto build_files = file_coverage;
+			if (parsed.inputs.size() > 1) {
+				auto stored =
+				    stored_file::from(report.files, files, input.report.files);
+				stored_file::store(repo, input.report.files, stored, p, jobs,
+				                   false);
+				if (!stored_file::store_tree(build_files, repo,
+				                             input.report.files, stored)) {
+					// GCOV_EXCL_START
+					[[unlikely]];
+					repo.rollback_batch();
+					p.data_error(replng::ERROR_CANNOT_WRITE_TO_DB);
+				}  // GCOV_EXCL_STOP
+
+				build_coverage = io::v1::coverage_stats::init();
+				for (auto const& file : stored) {
+					build_coverage += file.stats;
+				}
+			}
+
+			git::oid build_id{};
+			p.store_build(build_id, repo, build_files, now, build_coverage,
+			              input.props);
+			builds.add(build_id, input.props, build_coverage);
+		}
+
+		// the report below needs to see the files and the builds
+		if (repo.commit_batch()) {
+			// GCOV_EXCL_START
+			[[unlikely]];
+			p.data_error(replng::ERROR_CANNOT_WRITE_TO_DB);
+		}  // GCOV_EXCL_STOP
 
 		auto const [branch, current_id, same_report] =
 		    p.update_current_branch(repo, file_coverage, report.git, commit,
@@ -63,6 +98,7 @@ namespace cov::app::builtin::report {
 
 		if (same_report) {
 			fmt::print("{}\n", p.tr()(replng::WARNING_NO_CHANGES_IN_REPORT));
+			p.print_write_stats(repo);
 			return 0;
 		}
 
@@ -74,6 +110,7 @@ namespace cov::app::builtin::report {
 		}  // GCOV_EXCL_STOP
 
 		p.print_report(branch, files.size(), resulting, repo);
+		p.print_write_stats(repo);
 
 		return 0;
 	}
@@ -253,7 +253,8 @@ namespace cov::app::builtin::show {
 			auto const file_cvg = info.repo.lookup<cov::line_coverage>(
 			    file_entry->line_coverage(), ec);
 			if (file_cvg && !ec)
-				cvg = core::cvg_info::from_coverage(file_cvg->coverage());
+				cvg = core::cvg_info::from_coverage(
+				    file_cvg->coverage(), file_entry->stats().lines_total);
 		}
 
 		if (with_functions && !file_entry->function_coverage().is_zero()) {
@@ -262,6 +263,12 @@ namespace cov::app::builtin::show {
 			if (file_cvg && !ec) cvg.add_functions(*file_cvg);
 		}
 
+		if (!file_entry->branch_coverage().is_zero()) {
+			auto const file_cvg = info.repo.lookup<cov::branch_coverage>(
+			    file_entry->branch_coverage(), ec);
+			if (file_cvg && !ec) cvg.add_branches(*file_cvg);
+		}
+
 		cvg.find_chunks();
 
 		auto const data = file_entry->get_contents(info.repo, ec);
@@ -269,7 +276,8 @@ namespace cov::app::builtin::show {
 		cvg.load_syntax(
 		    std::string_view{reinterpret_cast<char const*>(data.data()),
 		                     data.size()},
-		    entries.front().name.display);
+		    entries.front().name.display, file_entry->contents(),
+		    core::highlight_cache::open(info.repo));
 
 		auto clr = p.show.color_type;
 		if (clr == use_feature::automatic) {
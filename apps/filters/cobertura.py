@@ -3,6 +3,7 @@
 import hashlib
 import json
 import os
+import struct
 import subprocess
 import sys
 import xml.etree.ElementTree as ET
@@ -42,6 +43,90 @@ def git_log_format(fmt):
     return output("git", "log", "-1", "--pretty=format:%" + fmt)
 
 
+BINARY_ALGORITHMS = {"md5": 1, "sha": 2, "sha1": 2}
+
+
+def dump_binary(report: dict, stream):
+    # layout is described in docs/objects.md, under REPORT INPUT
+    strings = bytearray()
+    offsets: Dict[str, int] = {}
+
+    def string(value: str) -> int:
+        if value not in offsets:
+            offsets[value] = len(strings)
+            strings.extend(value.encode("UTF-8"))
+            strings.append(0)
+        return offsets[value]
+
+    def u32(value: int) -> int:
+        return max(0, min(value, 0xFFFFFFFF))
+
+    files: List[int] = []
+    functions: List[int] = []
+    lines: List[int] = []
+    branch = string(report["git"]["branch"])
+    head = string(report["git"]["head"])
+    for file in report["files"]:
+        algorithm, digest = file["digest"].split(":", 1)
+        file_lines = sorted(
+            (int(line), hits) for line, hits in file["line_coverage"].items()
+        )
+        file_functions = file.get("functions", [])
+        files.extend(
+            [
+                string(file["name"]),
+                BINARY_ALGORITHMS.get(algorithm, 0),
+                string(digest),
+                len(lines) // 2,
+                len(file_lines),
+                len(functions) // 7,
+                len(file_functions),
+            ]
+        )
+        for line, hits in file_lines:
+            lines.extend([u32(line), u32(hits)])
+        for function in file_functions:
+            start_line = function["start_line"]
+            functions.extend(
+                [
+                    string(function["name"]),
+                    string(function.get("demangled", "")),
+                    u32(function["count"]),
+                    u32(start_line),
+                    u32(function.get("start_column", 0)),
+                    u32(function.get("end_line", start_line)),
+                    u32(function.get("end_column", 0)),
+                ]
+            )
+
+    while len(strings) % 4:
+        strings.append(0)
+    strings_offset = 14
+    files_offset = strings_offset + len(strings) // 4
+    functions_offset = files_offset + len(files)
+    lines_offset = functions_offset + len(functions)
+    header = [
+        0x0001_0000,
+        strings_offset,
+        len(strings) // 4,
+        branch,
+        head,
+        files_offset,
+        7,
+        len(files) // 7,
+        functions_offset,
+        7,
+        len(functions) // 7,
+        lines_offset,
+        len(lines),
+    ]
+    stream.write(b"rpin")
+    stream.write(struct.pack(f"<{len(header)}I", *header))
+    stream.write(strings)
+    values = files + functions + lines
+    stream.write(struct.pack(f"<{len(values)}I", *values))
+
+
 def cov_version():
     exec = os.environ["COV_EXE_PATH"]
     try:
@@ -129,11 +214,13 @@ def cov_from(info: ClassInfo) -> dict:
     }
 
 
-json.dump(
-    {
-        "$schema": f"https://raw.githubusercontent.com/mzdun/cov/v{VERSION}/apps/report-schema.json",
-        "git": {"branch": GIT_BRANCH, "head": GIT_HEAD},
-        "files": [cov_from(collected[name]) for name in sorted(collected.keys())],
-    },
-    sys.stdout,
-)
+report = {
+    "$schema": f"https://raw.githubusercontent.com/mzdun/cov/v{VERSION}/apps/report-schema.json",
+    "git": {"branch": GIT_BRANCH, "head": GIT_HEAD},
+    "files": [cov_from(collected[name]) for name in sorted(collected.keys())],
+}
+
+if "--binary" in sys.argv[1:]:
+    dump_binary(report, sys.stdout.buffer)
+else:
+    json.dump(report, sys.stdout)
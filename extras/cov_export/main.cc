@@ -6,9 +6,15 @@
 #include <cov/format.hh>
 #include <cov/io/file.hh>
 #include <cov/module.hh>
+#include <atomic>
+#include <cov/parallel.hh>
+#include <deque>
+#include <mutex>
 #include <native/path.hh>
+#include <optional>
 #include <set>
 #include <web/link_service.hh>
+#include "manifest.hh"
 #include "parser.hh"
 #include "stage.hh"
 
@@ -86,37 +92,165 @@ namespace cov::app::report_export {
 		}
 	};
 
-	void html_report(web::stage stage, parser& p) {
+	// Pages rendered on many threads finish in any order, but are listed
+	// in the order they were given, as soon as all pages before them are
+	// finished. This way the output is the same for any number of jobs.
+	class ordered_actions {
+	public:
+		explicit ordered_actions(std::vector<web::page const*> const& pages)
+		    : pages_{pages}, results_(pages.size()) {}
+
+		bool failed() const noexcept { return failed_; }
+
+		void finished(size_t index, std::error_code const& ec) {
+			std::lock_guard lock{m_};
+			results_[index] = ec;
+			if (ec) failed_ = true;
+
+			while (reported_ < results_.size() && results_[reported_]) {
+				logger_.on_action(
+				    get_generic_u8path(pages_[reported_]->filename));
+				if (*results_[reported_]) {
+					// nothing past first error is reported
+					reported_ = results_.size();
+					break;
+				}
+				++reported_;
+			}
+		}
+
+		std::optional<std::error_code> first_error() const {
+			for (auto const& result : results_) {
+				if (result && *result) return result;
+			}
+			return std::nullopt;
+		}
+
+		// GCOV_EXCL_START
+		[[noreturn]] void error(parser& p, std::error_code const& ec) {
+			logger_.error(p, ec);
+		}
+		// GCOV_EXCL_STOP
+
+	private:
+		std::vector<web::page const*> const& pages_;
+		std::vector<std::optional<std::error_code>> results_;
+		counted_actions logger_{.count = pages_.size()};
+		std::atomic<bool> failed_{false};
+		size_t reported_{0};
+		std::mutex m_{};
+	};
+
+	std::error_code render_page(web::stage const& stage,
+	                            web::page const& item,
+	                            web::dir_cache& tmplt) {
+		std::error_code ec{};
+		auto state = stage.next_page(item, ec);
+		if (ec) return ec;
+
+		auto ctx = state.create_context(stage, ec);
+		if (ec) return ec;
+
+		auto page_text = tmplt.render(state.template_name, ctx);
+
+		auto out = io::fopen(state.full_path, "wb");
+		if (!out) {
+			// GCOV_EXCL_START
+			auto const error = errno;
+			return std::make_error_code(error ? static_cast<std::errc>(error)
+			                                  : std::errc::permission_denied);
+			// GCOV_EXCL_STOP
+		}  // GCOV_EXCL_LINE[Clang]
+
+		out.store(page_text.c_str(), page_text.size());
+		return {};
+	}
+
+	bool templates_unchanged(web::export_manifest const& manifest,
+	                         web::dir_cache const& tmplt) {
+		for (auto const& [name, ticks] : manifest.templates) {
+			if (tmplt.last_write(name).time_since_epoch().count() != ticks)
+				return false;
+		}
+		return true;
+	}
+
+	void html_report(web::stage stage, parser& p, unsigned jobs) {
 		std::error_code ec{};
 
-		stage.initialize(ec);
+		auto const previous = web::export_manifest::load(stage.out_dir);
+		stage.initialize(previous.has_value(), ec);
 		if (ec) p.error(ec, p.tr());
 
+		// until the new manifest is stored, the pages on disk cannot be
+		// trusted to match any keys
+		if (previous) {
+			std::error_code ignore{};
+			std::filesystem::remove(
+			    stage.out_dir / web::export_manifest::filename, ignore);
+		}
+
 		auto const pages = stage.list_pages_in_report();
-		counted_actions logger{.count = pages.size()};
 
-		for (auto const& item : pages) {
-			logger.on_action(get_generic_u8path(item.filename));
-			auto state = stage.next_page(item, ec);
-			if (ec) logger.error(p, ec);
+		web::export_manifest next{.shared = stage.shared_key()};
+		auto const keys = stage.page_keys(pages, next.shared, ec);
+		if (ec) p.error(ec, p.tr());
+
+		auto const reuse = previous && previous->shared == next.shared &&
+		                   templates_unchanged(*previous, stage.tmplt);
+		if (reuse) next.templates = previous->templates;
+
+		std::vector<web::page const*> changed{};
+		changed.reserve(pages.size());
+		for (size_t index = 0; index < pages.size(); ++index) {
+			auto const& item = pages[index];
+			auto path = get_generic_u8path(item.filename);
+			if (reuse) {
+				auto const it = previous->pages.find(path);
+				std::error_code ignore{};
+				if (it != previous->pages.end() && it->second == keys[index] &&
+				    std::filesystem::is_regular_file(
+				        stage.out_dir / item.filename, ignore)) {
+					next.pages[std::move(path)] = keys[index];
+					continue;
+				}
+			}
+			changed.push_back(&item);
+			next.pages[std::move(path)] = keys[index];
+		}
+
+		if (previous) {
+			for (auto const& [path, key] : previous->pages) {
+				if (next.pages.contains(path)) continue;
+				std::error_code ignore{};
+				std::filesystem::remove(stage.out_dir / make_u8path(path),
+				                        ignore);
+			}
+		}
 
-			auto ctx = state.create_context(stage, ec);
-			if (ec) logger.error(p, ec);
+		if (!changed.empty()) stage.index_files();
 
-			auto page_text = stage.tmplt.render(state.template_name, ctx);
+		auto const workers = parallel_workers(changed.size(), jobs);
+		std::deque<web::dir_cache> templates{};
+		for (unsigned worker = 0; worker < workers; ++worker)
+			templates.emplace_back(web::stage::template_roots(),
+			                       web::stage::template_dir);
 
-			auto out = io::fopen(state.full_path, "wb");
-			if (!out) {
-				// GCOV_EXCL_START
-				auto const error = errno;
-				ec = std::make_error_code(error ? static_cast<std::errc>(error)
-				                                : std::errc::permission_denied);
-				logger.error(p, ec);
-				// GCOV_EXCL_STOP
-			}  // GCOV_EXCL_LINE[Clang]
+		ordered_actions logger{changed};
+		parallel_for(changed.size(), jobs, [&](size_t index, unsigned worker) {
+			if (logger.failed()) return;
+			auto const& item = *changed[index];
+			logger.finished(index, render_page(stage, item, templates[worker]));
+		});
+		if (auto const error = logger.first_error()) logger.error(p, *error);
 
-			out.store(page_text.c_str(), page_text.size());
+		for (auto const& tmplt : templates) {
+			for (auto const& [name, last_write] : tmplt.loaded())
+				next.templates[name] = last_write.time_since_epoch().count();
 		}
+
+		// without the manifest, next export will simply render all pages
+		next.store(stage.out_dir);
 	}
 
 	int handle(args::args_view const& args) {
@@ -145,28 +279,6 @@ namespace cov::app::report_export {
 		auto diff = report_diff(info, ec);
 		if (ec) p.error(ec, p.tr());
 
-		struct mod {
-			std::vector<std::string> prefixes, files;
-		};
-
-		for (auto const& item : diff) {
-			size_t length{};
-			std::string module_name{};
-			for (auto const& entry : mods->entries()) {
-				for (std::string_view prefix : entry.prefixes) {
-					if (!prefix.empty() && prefix.back() == '/')
-						prefix = prefix.substr(0, prefix.length() - 1);
-					if (item.filename.starts_with(prefix) &&
-					    (item.filename.length() == prefix.length() ||
-					     item.filename[prefix.length()] == '/') &&
-					    length < prefix.length()) {
-						length = prefix.length();
-						module_name = entry.name;
-					}
-				}
-			}
-		}
-
 		auto const system = platform::core_extensions::sys_root();
 
 		html_report({.marks = placeholder::environment::rating_from(info.repo),
@@ -178,7 +290,7 @@ namespace cov::app::report_export {
 		             .base = info.range.from,
 		             .replacements = core::load_replacements(system, info.repo,
 		                                                     info.verbose > 0)},
-		            p);
+		            p, info.jobs);
 
 		return 0;
 	}
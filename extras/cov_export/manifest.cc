@@ -0,0 +1,115 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include "manifest.hh"
+#include <fmt/format.h>
+#include <charconv>
+#include <cov/io/file.hh>
+
+using namespace std::literals;
+
+namespace cov::app::web {
+	namespace {
+		constexpr auto header = "cov-export-manifest 1"sv;
+
+		std::pair<std::string_view, std::string_view> split(
+		    std::string_view line) {
+			auto const pos = line.find(' ');
+			if (pos == std::string_view::npos) return {line, {}};
+			return {line.substr(0, pos), line.substr(pos + 1)};
+		}
+	}  // namespace
+
+	page_key& page_key::add(std::string_view text) {
+		add(static_cast<std::uint64_t>(text.size()));
+		calc_.update(git::bytes{text});
+		return *this;
+	}
+
+	page_key& page_key::add(git::oid const& id) {
+		calc_.update({id.id.id, sizeof(id.id.id)});
+		return *this;
+	}
+
+	page_key& page_key::add(std::uint64_t value) {
+		std::byte buffer[sizeof(value)];
+		for (auto& b : buffer) {
+			b = static_cast<std::byte>(value & 0xFF);
+			value >>= 8;
+		}
+		calc_.update({buffer, sizeof(buffer)});
+		return *this;
+	}
+
+	page_key& page_key::add(io::v1::coverage_stats const& stats) {
+		for (auto const value :
+		     {stats.lines_total, stats.lines.relevant, stats.lines.visited,
+		      stats.functions.relevant, stats.functions.visited,
+		      stats.branches.relevant, stats.branches.visited}) {
+			add(std::uint64_t{value});
+		}
+		return *this;
+	}
+
+	std::optional<export_manifest> export_manifest::load(
+	    std::filesystem::path const& out_dir) {
+		auto const in = io::fopen(out_dir / filename, "rb");
+		if (!in) return std::nullopt;
+
+		auto const data = in.read();
+		auto text = std::string_view{
+		    reinterpret_cast<char const*>(data.data()), data.size()};
+
+		export_manifest result{};
+		bool first = true;
+		while (!text.empty()) {
+			auto const pos = text.find('\n');
+			auto const line = text.substr(0, pos);
+			text = pos == std::string_view::npos ? std::string_view{}
+			                                     : text.substr(pos + 1);
+
+			if (first) {
+				if (line != header) return std::nullopt;
+				first = false;
+				continue;
+			}
+
+			auto const [kind, rest] = split(line);
+			auto const [value, name] = split(rest);
+			if (kind == "shared"sv) {
+				result.shared.assign(value);
+			} else if (kind == "template"sv) {
+				std::filesystem::file_time_type::rep ticks{};
+				auto const last = value.data() + value.size();
+				auto const [ptr, ec] =
+				    std::from_chars(value.data(), last, ticks);
+				if (ptr != last || ec != std::errc{}) return std::nullopt;
+				result.templates[{name.data(), name.size()}] = ticks;
+			} else if (kind == "page"sv) {
+				result.pages[{name.data(), name.size()}] = {value.data(),
+				                                            value.size()};
+			} else {
+				return std::nullopt;
+			}
+		}
+
+		if (first) return std::nullopt;
+		return result;
+	}
+
+	bool export_manifest::store(std::filesystem::path const& out_dir) const {
+		std::string text{};
+		text.append(header);
+		text.push_back('\n');
+		fmt::format_to(std::back_inserter(text), "shared {}\n", shared);
+		for (auto const& [name, ticks] : templates)
+			fmt::format_to(std::back_inserter(text), "template {} {}\n", ticks,
+			               name);
+		for (auto const& [name, key] : pages)
+			fmt::format_to(std::back_inserter(text), "page {} {}\n", key, name);
+
+		auto const out = io::fopen(out_dir / filename, "wb");
+		if (!out) return false;
+		return out.store(text.data(), text.size()) == text.size();
+	}
+}  // namespace cov::app::web
@@ -0,0 +1,50 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cov/git2/oid.hh>
+#include <cov/hash/sha1.hh>
+#include <cov/io/types.hh>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cov::app::web {
+	// Digest of everything a page was rendered from. Each value is stored
+	// together with its size, so two different lists of values cannot
+	// give the same stream of bytes.
+	class page_key {
+	public:
+		page_key& add(std::string_view text);
+		page_key& add(git::oid const& id);
+		page_key& add(std::uint64_t value);
+		page_key& add(io::v1::coverage_stats const& stats);
+		std::string str() { return calc_.finalize().str(); }
+
+	private:
+		hash::sha1 calc_{};
+	};
+
+	// Inputs of the pages written by previous export to the same
+	// directory. Pages, whose inputs did not change, are not rendered
+	// again; pages, which are no longer part of the report, are removed.
+	struct export_manifest {
+		static constexpr auto filename = ".cov-export";
+
+		// key of the inputs shared by all pages; when it changes, all the
+		// pages are rendered again
+		std::string shared{};
+		// templates used to render the pages, with their last write times
+		std::map<std::string, std::filesystem::file_time_type::rep>
+		    templates{};
+		// generic path of each page -> page_key
+		std::map<std::string, std::string> pages{};
+
+		static std::optional<export_manifest> load(
+		    std::filesystem::path const& out_dir);
+		bool store(std::filesystem::path const& out_dir) const;
+	};
+}  // namespace cov::app::web
@@ -12,7 +12,7 @@ namespace cov::app::report_export {
 		using namespace str;
 
 		parser_.usage(fmt::format(
-		    "cov export [-h] [{}] (--json {} | --html {})",
+		    "cov export [-h] [{}] (--json {} | --html {}) [-j <number>]",
 		    tr_(covlng::REPORT_META), tr_(str::args::lng::FILE_META),
 		    tr_(str::args::lng::DIR_META)));
 		parser_
@@ -41,6 +41,12 @@ namespace cov::app::report_export {
 		        "html")
 		    .meta(tr_(str::args::lng::DIR_META))
 		    .opt();
+		parser_.arg(jobs, "j", "jobs")
+		    .meta("<number>")
+		    .help(
+		        "renders the pages using up to <number> threads; defaults to "
+		        "the number of processors")
+		    .opt();
 		parser_.custom([&]() { ++verbose; }, "v").opt();
 	}
 
@@ -61,6 +67,7 @@ namespace cov::app::report_export {
 		result.path = path;
 		result.only_json = oper == op::json;
 		result.verbose = verbose;
+		result.jobs = jobs && *jobs ? *jobs : hardware_jobs();
 
 		auto ec = revs::parse(result.repo, *rev, result.range);
 		if (ec) error(ec, tr_);
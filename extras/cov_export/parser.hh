@@ -8,6 +8,7 @@
 #include <cov/app/strings/cov.hh>
 #include <cov/app/strings/errors.hh>
 #include <cov/app/tr.hh>
+#include <cov/parallel.hh>
 #include <cov/repository.hh>
 #include <cov/revparse.hh>
 #include <native/open_here.hh>
@@ -43,6 +44,7 @@ namespace cov::app::report_export {
 			std::string path{};
 			cov::repository repo{};
 			unsigned verbose{};
+			unsigned jobs{1};
 		};
 
 		response parse();
@@ -56,5 +58,6 @@ namespace cov::app::report_export {
 		std::optional<std::string> rev{};
 		std::string path{};
 		unsigned verbose{};
+		std::optional<unsigned> jobs{};
 	};
 }  // namespace cov::app::report_export
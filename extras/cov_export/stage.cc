@@ -2,31 +2,79 @@
 // This code is licensed under MIT license (see LICENSE for details)
 
 #include "stage.hh"
+#include <algorithm>
 #include <cov/module.hh>
+#include <cov/version.hh>
 #include <json/json.hpp>
 #include <native/path.hh>
 #include <set>
 #include <web/components.hh>
+#include "manifest.hh"
 
 using namespace std::literals;
 
 namespace cov::app::web {
-	void stage::initialize(std::error_code& ec) {
-		std::filesystem::remove_all(out_dir, ec);
-		if (ec) return;
+	namespace {
+		ref_ptr<cov::files> files_of(cov::repository const& repo,
+		                             git::oid_view ref,
+		                             std::error_code& ec) {
+			std::error_code ignore{};
+			if (auto const report = repo.lookup<cov::report>(ref, ignore))
+				return repo.lookup<cov::files>(report->file_list_id(), ec);
+			if (auto const build = repo.lookup<cov::build>(ref, ignore))
+				return repo.lookup<cov::files>(build->file_list_id(), ec);
+			return repo.lookup<cov::files>(ref, ignore);
+		}
+
+		struct filename_less {
+			bool operator()(file_stats const* lhs,
+			                file_stats const* rhs) const noexcept {
+				return lhs->filename < rhs->filename;
+			}
+			bool operator()(file_stats const* lhs,
+			                std::string_view rhs) const noexcept {
+				return lhs->filename < rhs;
+			}
+			bool operator()(std::string_view lhs,
+			                file_stats const* rhs) const noexcept {
+				return lhs < rhs->filename;
+			}
+		};
+
+		void add_stats(page_key& key, file_stats const& stat) {
+			key.add(stat.filename)
+			    .add(stat.previous_name)
+			    .add(static_cast<std::uint64_t>(stat.diff_kind))
+			    .add(stat.current)
+			    .add(stat.previous)
+			    .add(stat.current_functions)
+			    .add(stat.previous_functions);
+		}
+	}  // namespace
+
+	void stage::initialize(bool incremental, std::error_code& ec) {
+		if (!incremental) {
+			std::filesystem::remove_all(out_dir, ec);
+			if (ec) return;
+		}
 
 		std::filesystem::create_directories(out_dir, ec);
 		if (ec) return;
 
 		std::filesystem::copy(
 		    platform::core_extensions::sys_root() / directory_info::site_html,
-		    out_dir, std::filesystem::copy_options::recursive, ec);
+		    out_dir,
+		    std::filesystem::copy_options::recursive |
+		        std::filesystem::copy_options::overwrite_existing,
+		    ec);
 		if (ec) return;
 
 		std::tie(commit_ctx, report_ctx) = add_build_info(repo, ref, base, ec);
 		if (ec) return;
 	}
 
+	void stage::index_files() { file_index.emplace(diff, mods.get(), &repo); }
+
 	std::vector<web::page> stage::list_pages_in_report() const {
 		std::set<std::string> modules{}, files{}, dirs{};
 
@@ -80,17 +128,112 @@ namespace cov::app::web {
 		return pages;
 	}
 
+	std::string stage::shared_key() const {
+		page_key key{};
+		key.add(std::string_view{cov::version::ui});
+
+		std::error_code ignore{};
+		if (repo.lookup<cov::report>(ref, ignore)) {
+			// build information of a report is part of every page
+			key.add(std::uint64_t{1}).add(ref.oid()).add(base.oid());
+		} else {
+			key.add(std::uint64_t{0});
+		}
+
+		for (auto const& rating :
+		     {marks.lines, marks.functions, marks.branches}) {
+			key.add(std::uint64_t{rating.incomplete.num})
+			    .add(std::uint64_t{rating.incomplete.den})
+			    .add(std::uint64_t{rating.passing.num})
+			    .add(std::uint64_t{rating.passing.den});
+		}
+
+		if (mods) {
+			key.add(mods->separator()).add(mods->entries().size());
+			for (auto const& module : mods->entries()) {
+				key.add(module.name).add(module.prefixes.size());
+				for (auto const& prefix : module.prefixes)
+					key.add(prefix);
+			}
+		}
+
+		key.add(replacements.size());
+		for (auto const& [from, to] : replacements)
+			key.add(from.str()).add(to.str());
+
+		return key.str();
+	}
+
+	std::vector<std::string> stage::page_keys(
+	    std::vector<web::page> const& pages,
+	    std::string_view shared,
+	    std::error_code& ec) const {
+		auto const files = files_of(repo, ref, ec);
+		if (ec) return {};
+
+		std::vector<file_stats const*> by_name{};
+		by_name.reserve(diff.size());
+		for (auto const& stat : diff)
+			by_name.push_back(&stat);
+		std::stable_sort(by_name.begin(), by_name.end(), filename_less{});
+
+		// listings summarize all the files in the report
+		auto const listing = [&] {
+			page_key key{};
+			key.add(diff.size());
+			for (auto const& stat : diff)
+				add_stats(key, stat);
+			return key.str();
+		}();
+
+		std::vector<std::string> result{};
+		result.reserve(pages.size());
+		for (auto const& pg : pages) {
+			page_key key{};
+			key.add(shared)
+			    .add(get_generic_u8path(pg.filename))
+			    .add(pg.module_filter)
+			    .add(pg.fname_filter);
+
+			auto const [first, last] =
+			    std::equal_range(by_name.begin(), by_name.end(),
+			                     pg.fname_filter, filename_less{});
+			if (!pg.module_filter.empty() || first == last) {
+				key.add(listing);
+				result.push_back(key.str());
+				continue;
+			}
+
+			for (auto it = first; it != last; ++it) {
+				auto const& stat = **it;
+				add_stats(key, stat);
+				auto const* entry =
+				    files ? files->by_path(stat.filename) : nullptr;
+				if (entry) {
+					key.add(entry->contents())
+					    .add(entry->line_coverage())
+					    .add(entry->function_coverage())
+					    .add(entry->branch_coverage());
+				}
+			}
+			result.push_back(key.str());
+		}
+
+		return result;
+	}
+
 	mstch::map stage::page_state::create_context(stage const& stg,
 	                                             std::error_code& ec) {
 		auto view = projection::report_filter{stg.mods.get(), pg.module_filter,
 		                                      pg.fname_filter};
-		auto entries = view.project(stg.diff, &stg.repo);
+		auto entries = stg.file_index ? view.project(*stg.file_index)
+		                              : view.project(stg.diff, &stg.repo);
 
 		mstch::map ctx{};
 		auto const is_standalone =
 		    add_page_context(ctx, view, entries, stg.ref, stg.marks, stg.repo,
 		                     stg.commit_ctx, stg.report_ctx, stg.octicons,
-		                     stg.replacements, true, stg.links, ec);
+		                     stg.replacements, true, links, ec);
 		if (ec) return {};
 
 		template_name = is_standalone ? "file.html"s : "listing.html"s;
@@ -98,15 +241,27 @@ namespace cov::app::web {
 		return ctx;
 	}
 
-	stage::page_state stage::next_page(page const& pg, std::error_code& ec) {
+	stage::page_state stage::next_page(page const& pg,
+	                                   std::error_code& ec) const {
 		auto const [filename, module_filter, fname_filter] = pg;
-		links.adjust_root(pg.filename);
 		page_state state{.pg = pg, .full_path = out_dir / filename};
+		state.links.adjust_root(pg.filename);
 
 		std::filesystem::create_directories(state.full_path.parent_path(), ec);
 		return state;
 	}
 
+	std::vector<std::filesystem::path> stage::template_roots() {
+		return {
+		    installed_site(),
+		    runtime_site(),
+#ifndef NDEBUG
+		    build_site(),
+		    source_site(),
+#endif
+		};
+	}
+
 	std::filesystem::path stage::runtime_site() {
 		return platform::core_extensions::sys_root() / directory_info::site_res;
 	}
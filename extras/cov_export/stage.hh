@@ -8,6 +8,7 @@
 #include <cov/format.hh>
 #include <filesystem>
 #include <native/platform.hh>
+#include <optional>
 #include <vector>
 #include <web/link_service.hh>
 #include <web/mstch_cache.hh>
@@ -31,34 +32,43 @@ namespace cov::app::web {
 		git::oid_view base;
 		cxx_filt::Replacements replacements;
 		export_link_service links{};
-		dir_cache tmplt{
-		    {
-		        installed_site(),
-		        runtime_site(),
-#ifndef NDEBUG
-		        build_site(),
-		        source_site(),
-#endif
-		    },
-		    "templates",
-		};
+		dir_cache tmplt{template_roots(), template_dir};
 		std::shared_ptr<octicon_callback> octicons = octicon_callback::create(
 		    platform::core_extensions::sys_root() / directory_info::site_res /
 		    "octicons.json"sv);
 		mstch::node commit_ctx{}, report_ctx{};
+		// files of the diff, shared by projections of all the pages
+		std::optional<projection::report_index> file_index{};
 
-		void initialize(std::error_code& ec);
+		// with incremental, the pages from previous export are kept in
+		// out_dir, to be overwritten only if their inputs changed
+		void initialize(bool incremental, std::error_code& ec);
+		// loads the stats of all files once, before any page is rendered
+		void index_files();
 		std::vector<web::page> list_pages_in_report() const;
+		std::string shared_key() const;
+		// one key for each page, in the same order as the pages
+		std::vector<std::string> page_keys(std::vector<web::page> const& pages,
+		                                   std::string_view shared,
+		                                   std::error_code& ec) const;
 
+		// pages can be prepared on many threads at once, so anything
+		// depending on the page is kept here, not in the stage
 		struct page_state {
 			page pg;
 			std::filesystem::path full_path;
+			export_link_service links{};
 			std::string template_name{};
 
 			mstch::map create_context(stage const& stg, std::error_code& ec);
 		};
 
-		page_state next_page(page const& pg, std::error_code& ec);
+		page_state next_page(page const& pg, std::error_code& ec) const;
+
+		// mstch::cache is not safe to share between threads, each thread
+		// rendering pages needs its own dir_cache over these
+		static constexpr auto template_dir = "templates"sv;
+		static std::vector<std::filesystem::path> template_roots();
 
 	private:
 		static std::filesystem::path runtime_site();
@@ -3,12 +3,15 @@
 
 #include <fmt/format.h>
 #include <args/parser.hpp>
+#include <cov/app/report.hh>
 #include <cov/git2/commit.hh>
 #include <cov/git2/global.hh>
 #include <cov/git2/odb.hh>
 #include <cov/git2/repository.hh>
 #include <cov/git2/tree.hh>
 #include <cov/io/file.hh>
+#include <cov/io/shared_bytes.hh>
+#include <cov/parallel.hh>
 #include <cov/version.hh>
 #include <json/json.hpp>
 #include <native/path.hh>
@@ -25,38 +28,110 @@
 using namespace std::literals;
 
 namespace cov::app::strip {
-	exclude_result find_excl_blocks(
-	    std::span<std::string_view const> valid_markers,
-	    std::string_view path,
-	    std::filesystem::path src_dir) {
-		std::error_code ec{};
-
-		auto const full_path = src_dir / make_u8path(path);
-		auto const opened = io::fopen(full_path, "rb");
-		if (opened) {
-			auto stg = opened.read();
-			auto const chars = std::string_view{
-			    reinterpret_cast<char const*>(stg.data()), stg.size()};
-			return find_blocks(get_u8path(full_path), valid_markers, chars);
-		}
-
-		return {};
+	struct source_file {
+		json::map* line_coverage{};
+		json::array* functions{};
+		json::map* branches{};
+	};
+
+	struct source_result {
+		std::string messages{};
+		size_t lines{};
+		size_t functions{};
+		size_t branches{};
+		std::vector<exclude_report_line> excluded{};
+	};
+
+	void strip(source_file const& source,
+	           std::span<excl_block const> excludes,
+	           std::set<unsigned> const& empties,
+	           std::string_view text,
+	           bool list_lines,
+	           source_result& result) {
+		auto const lines = number_lines(*source.line_coverage);
+		if (list_lines && !excludes.empty())
+			result.excluded = find_lines(lines, excludes, text);
+
+		result.lines =
+		    erase_lines(*source.line_coverage, lines, excludes, empties);
+		if (source.functions)
+			result.functions =
+			    filter_blocks(source.functions, excludes, empties);
+		if (source.branches)
+			result.branches =
+			    erase_branches(*source.branches, excludes, empties);
 	}
 
-	std::vector<exclude_report_line> find_lines(
-	    json::map& line_coverage,
-	    std::span<excl_block const> const& excludes,
-	    std::string_view path,
-	    std::filesystem::path src_dir) {
-		auto const full_path = src_dir / make_u8path(path);
-		auto const opened = io::fopen(full_path, "rb");
-		if (!opened) return {};
+	// Binary reports are stripped without going through JSON; their
+	// lines start at zero, while the excludes and the masks start at one.
+	void strip(report::file_info& file,
+	           std::span<excl_block const> excludes,
+	           std::set<unsigned> const& empties,
+	           std::string_view text,
+	           bool list_lines,
+	           source_result& result) {
+		line_mask const mask{excludes, empties};
+
+		if (list_lines && !excludes.empty()) {
+			std::vector<std::string> counters(mask.size());
+			for (auto const& [line, hits] : file.line_coverage) {
+				if (mask[line + 1] == line_kind::excluded)
+					counters[line + 1] = fmt::format("{}", hits);
+			}
+			result.excluded = list_excluded(mask, std::move(counters), text);
+		}
 
-		auto stg = opened.read();
-		auto const chars = std::string_view{
-		    reinterpret_cast<char const*>(stg.data()), stg.size()};
+		result.lines = std::erase_if(
+		    file.line_coverage, [&mask](auto const& entry) {
+			    auto const kind = mask[entry.first + 1];
+			    return kind == line_kind::excluded ||
+			           (kind == line_kind::empty && !entry.second);
+		    });
+
+		result.functions = std::erase_if(
+		    file.function_coverage, [&](auto const& function) {
+			    auto const block =
+			        mask_range(function.start.line + 1ll,
+			                   function.end.line + 1ll, excludes, empties);
+			    return block.start > block.end;
+		    });
+
+		for (auto it = file.branch_coverage.begin();
+		     it != file.branch_coverage.end();) {
+			if (mask[it->first + 1] != line_kind::excluded) {
+				++it;
+				continue;
+			}
+			result.branches += it->second.size();
+			it = file.branch_coverage.erase(it);
+		}
+	}
 
-		return find_lines(line_coverage, excludes, chars);
+	// Each source is read once, the listing for the verbose output is
+	// made from the same bytes as the blocks. Only the data of this very
+	// file are changed, so many files can be stripped at once.
+	template <typename Source>
+	source_result strip_source(std::span<std::string_view const> valid_markers,
+	                           std::string const& name,
+	                           Source& source,
+	                           std::filesystem::path const& src_dir,
+	                           bool list_lines) {
+		source_result result{};
+
+		auto const full_path = src_dir / make_u8path(name);
+		auto const contents = io::shared_bytes::map(full_path);
+		if (!contents) return result;
+		auto const bytes = contents->data();
+		auto const text = std::string_view{
+		    reinterpret_cast<char const*>(bytes.data()), bytes.size()};
+
+		auto [excludes, empties] = find_blocks(
+		    get_u8path(full_path), valid_markers, text, result.messages);
+		if (excludes.empty() && empties.empty()) return result;
+
+		std::sort(excludes.begin(), excludes.end());
+		strip(source, excludes, empties, text, list_lines, result);
+		return result;
 	}
 
 	template <typename T>
@@ -91,6 +166,133 @@ namespace cov::app::strip {
 		               fmt::runtime(tr(ExcludesLng::REPORT_MISSING_KEY)), key));
 	}
 
+	// VERBOSE and SUMMARY, in order of the files
+	void print_results(parser const& p,
+	                   std::span<std::string const> names,
+	                   std::span<source_result> results) {
+		size_t line_counter = 0, fn_counter = 0, br_counter = 0;
+
+		std::vector<exclude_report> excluded_lines{};
+		if (p.verbose > detail::stats) {
+			excluded_lines.reserve(names.size());
+		}
+
+		for (size_t index = 0; index < names.size(); ++index) {
+			auto& result = results[index];
+			if (!result.messages.empty())
+				fmt::print(stderr, "{}", result.messages);
+			line_counter += result.lines;
+			fn_counter += result.functions;
+			br_counter += result.branches;
+			if (!result.excluded.empty()) {
+				excluded_lines.emplace_back(names[index],
+				                            std::move(result.excluded));
+			}
+		}
+
+		// VERBOSE
+		// ===========================================================
+
+		size_t counter_width = 0;
+		for (auto const& [filename, lines] : excluded_lines) {
+			for (auto const& [_1, counter, _2] : lines) {
+				counter_width = std::max(counter_width, counter.length());
+			}
+		}
+
+		for (auto const& [filename, lines] : excluded_lines) {
+			unsigned prev{0};
+			auto first{true};
+
+			for (auto const& [line, counter, text] : lines) {
+				if (first || (line - prev) > 1) {
+					fmt::print(stderr, "-- {}:{}\n", filename, line);
+				}
+				first = false;
+				prev = line;
+
+				fmt::print(stderr, "     {:>{}} | \033[2;49;30m{}\033[m\n",
+				           counter, counter_width, text);
+			}
+		}
+
+		// SUMMARY
+		// ===========================================================
+		if (line_counter || fn_counter || br_counter) {
+			std::vector<std::string> stats{};
+			stats.reserve(3);
+			auto const format = [&stats, &tr = p.tr()](ExcludesCounted value,
+			                                           size_t count) {
+				stats.push_back(fmt::format(
+				    fmt::runtime(tr(value, static_cast<intmax_t>(count))),
+				    count));
+			};
+
+			if (line_counter) {
+				format(ExcludesCounted::DETAILS_EXCLUDED_LINES, line_counter);
+			}
+			// GCOV_EXCL_START -- TODO: [FUNCTIONS] Enable for next task
+			if (fn_counter) {
+				format(ExcludesCounted::DETAILS_EXCLUDED_FUNCTIONS, fn_counter);
+			}
+			// GCOV_EXCL_STOP
+			if (br_counter) {
+				format(ExcludesCounted::DETAILS_EXCLUDED_BRANCHES, br_counter);
+			}
+
+			print_all(p.tr(),
+			          fmt::format("strip-excludes: {}",
+			                      p.tr()(ExcludesLng::DETAILS_EXCLUDED)),
+			          stats);
+		} else {
+			fmt::print(stderr, "strip-excludes: {}.\n",
+			           p.tr()(ExcludesLng::DETAILS_NOTHING_EXCLUDED));
+		}
+	}
+
+	template <typename Source>
+	std::vector<source_result> strip_all(
+	    parser const& p,
+	    std::span<std::string_view const> valid_markers,
+	    std::span<std::string const> names,
+	    std::span<Source> sources) {
+		auto const src_dir =
+		    std::filesystem::weakly_canonical(make_u8path(p.src_dir));
+
+		if (p.verbose > detail::none) {
+			fmt::print(stderr, "{}: {}\n", p.tr()(ExcludesLng::DETAILS_SOURCES),
+			           get_u8path(src_dir));
+		}
+
+		std::vector<source_result> results(sources.size());
+		auto const list_lines = p.verbose > detail::stats;
+		parallel_for(sources.size(), p.jobs(), [&](size_t index) {
+			results[index] = strip_source(valid_markers, names[index],
+			                              sources[index], src_dir, list_lines);
+		});
+		return results;
+	}
+
+	int strip_binary(parser const& p,
+	                 std::span<std::string_view const> valid_markers,
+	                 std::string_view input) {
+		report::report_info info{};
+		if (!info.load_from_binary(input)) return 1;
+
+		std::vector<std::string> names{};
+		names.reserve(info.files.size());
+		for (auto const& file : info.files)
+			names.push_back(file.name);
+
+		auto results = strip_all(p, valid_markers, names,
+		                         std::span<report::file_info>{info.files});
+		print_results(p, names, results);
+
+		auto const data = info.to_binary();
+		fwrite(data.data(), 1, data.size(), stdout);
+		return 0;
+	}
+
 	int tool(args::args_view const& arguments) {
 		parser p{arguments,
 		         {platform::filters::locale_dir(), ::lngs::system_locales()}};
@@ -109,10 +311,13 @@ namespace cov::app::strip {
 			          valid_markers);
 		}
 
-		auto root = []() {  // GCOV_EXCL_LINE[GCC]
-			auto const text = platform::read_input();
-			return json::read_json({text.data(), text.size()});
-		}();
+		auto const input = platform::read_input();
+		auto const view = std::string_view{
+		    reinterpret_cast<char const*>(input.data()), input.size()};
+		if (report::report_info::is_binary(view))
+			return strip_binary(p, valid_markers, view);
+
+		auto root = json::read_json({input.data(), input.size()});
 		auto cvg = json::cast<json::map>(root);
 		if (!cvg) return 1;
 
@@ -132,20 +337,10 @@ namespace cov::app::strip {
 			return 1;
 		}
 
-		auto const src_dir =
-		    std::filesystem::weakly_canonical(make_u8path(p.src_dir));
-
-		if (p.verbose > detail::none) {
-			fmt::print(stderr, "{}: {}\n", p.tr()(ExcludesLng::DETAILS_SOURCES),
-			           get_u8path(src_dir));
-		}
-
-		size_t line_counter = 0, fn_counter = 0, br_counter = 0;
-
-		std::vector<exclude_report> excluded_lines{};
-		if (p.verbose > detail::stats) {
-			excluded_lines.reserve(files->size());
-		}
+		std::vector<std::string> names{};
+		std::vector<source_file> sources{};
+		names.reserve(files->size());
+		sources.reserve(files->size());
 
 		auto file_node_counter = std::numeric_limits<unsigned>::max();
 		for (auto& file_node : *files) {
@@ -174,86 +369,26 @@ namespace cov::app::strip {
 				continue;
 			}
 
-			auto const file_name = from_u8s(*json_file_name);
-			auto [excludes, empties] =
-			    find_excl_blocks(valid_markers, file_name, src_dir);
-			if (excludes.empty() && empties.empty()) continue;
-
-			std::sort(excludes.begin(), excludes.end());
-
-			if (p.verbose > detail::stats && !excludes.empty()) {
-				excluded_lines.emplace_back(
-				    file_name,
-				    find_lines(*json_file_lines, excludes, file_name, src_dir));
-			}
-
-			line_counter += erase_lines(*json_file_lines, excludes, empties);
-
-			if (auto json_array = json::cast<json::array>(file, u8"functions");
-			    json_array) {
-				fn_counter += filter_blocks(json_array, excludes, empties);
-			}
-		}
-
-		// VERBOSE
-		// ===========================================================
-
-		size_t counter_width = 0;
-		for (auto const& [filename, lines] : excluded_lines) {
-			for (auto const& [_1, counter, _2] : lines) {
-				counter_width = std::max(counter_width, counter.length());
-			}
-		}
-
-		for (auto const& [filename, lines] : excluded_lines) {
-			unsigned prev{0};
-			auto first{true};
-
-			for (auto const& [line, counter, text] : lines) {
-				if (first || (line - prev) > 1) {
-					fmt::print(stderr, "-- {}:{}\n", filename, line);
-				}
-				first = false;
-				prev = line;
-
-				fmt::print(stderr, "     {:>{}} | \033[2;49;30m{}\033[m\n",
-				           counter, counter_width, text);
-			}
+			names.push_back(from_u8s(*json_file_name));
+			sources.push_back({
+			    .line_coverage = json_file_lines,
+			    .functions = json::cast<json::array>(file, u8"functions"),
+			    .branches = json::cast<json::map>(file, u8"branches"),
+			});
 		}
 
-		// SUMMARY
-		// ===========================================================
-		if (line_counter || fn_counter || br_counter) {
-			std::vector<std::string> stats{};
-			stats.reserve(3);
-			auto const format = [&stats, &tr = p.tr()](ExcludesCounted value,
-			                                           size_t count) {
-				stats.push_back(fmt::format(
-				    fmt::runtime(tr(value, static_cast<intmax_t>(count))),
-				    count));
-			};
-
-			if (line_counter) {
-				format(ExcludesCounted::DETAILS_EXCLUDED_LINES, line_counter);
-			}
-			// GCOV_EXCL_START -- TODO: [FUNCTIONS] Enable for next task
-			if (fn_counter) {
-				format(ExcludesCounted::DETAILS_EXCLUDED_FUNCTIONS, fn_counter);
-			}
-			// GCOV_EXCL_STOP
-			// GCOV_EXCL_START -- TODO: [BRANCHES] Enable for next task
-			if (br_counter) {
-				format(ExcludesCounted::DETAILS_EXCLUDED_BRANCHES, br_counter);
-			}
-			// GCOV_EXCL_STOP
-
-			print_all(p.tr(),
-			          fmt::format("strip-excludes: {}",
-			                      p.tr()(ExcludesLng::DETAILS_EXCLUDED)),
-			          stats);
-		} else {
-			fmt::print(stderr, "strip-excludes: {}.\n",
-			           p.tr()(ExcludesLng::DETAILS_NOTHING_EXCLUDED));
+		auto results = strip_all(p, valid_markers, names,
+		                         std::span<source_file>{sources});
+		print_results(p, names, results);
+
+		if (p.binary) {
+			json::string text{};
+			json::write_json(text, root, json::concise);
+			report::report_info info{};
+			if (!info.load_from_text(from_u8s(text))) return 1;
+			auto const data = info.to_binary();
+			fwrite(data.data(), 1, data.size(), stdout);
+			return 0;
 		}
 
 		json::write_json(stdout, root, json::concise);
@@ -29,6 +29,13 @@ namespace cov::app::strip {
 		parser_.custom([&]() { next(verbose); }, "v")
 		    .help(tr_(ExcludesLng::ARG_VERBOSE))
 		    .opt();
+		parser_.set<std::true_type>(binary, "binary")
+		    .help(tr_(ExcludesLng::ARG_BINARY))
+		    .opt();
+		parser_.arg(jobs_, "j", "jobs")
+		    .meta(tr_(ExcludesLng::ARG_JOBS_META))
+		    .help(tr_(ExcludesLng::ARG_JOBS))
+		    .opt();
 	}
 
 	void parser::parse() {
@@ -7,6 +7,7 @@
 #include <cov/app/strings/cov.hh>
 #include <cov/app/strings/errors.hh>
 #include <cov/app/tr.hh>
+#include <cov/parallel.hh>
 #include <native/str.hh>
 #include <optional>
 #include <string>
@@ -45,10 +46,15 @@ namespace cov::app::strip {
 		       str::translator_open_info const& langs);
 
 		void parse();
+		unsigned jobs() const noexcept {
+			return jobs_ && *jobs_ ? *jobs_ : hardware_jobs();
+		}
 
 		std::string src_dir{".", 1};
 		std::optional<std::string> compiler;
 		std::optional<std::string> os;
 		detail verbose{detail::none};
+		bool binary{false};
+		std::optional<unsigned> jobs_{};
 	};
 }  // namespace cov::app::strip
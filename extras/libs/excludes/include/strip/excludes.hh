@@ -42,8 +42,13 @@ namespace cov::app::strip {
 		std::vector<unsigned> single_lines{};
 		std::vector<excl_block> result{};
 		std::set<unsigned> empties{};
+		// when set, the warnings are appended here instead of stderr
+		std::string* messages{nullptr};
 
 		bool has_any_marker(std::string_view markers);
+		// splits the text into lines, numbered from one; only the lines
+		// with a candidate marker are given to on_line()
+		void on_lines(std::string_view text);
 		void on_line(unsigned line_no, std::string_view text);
 		void after_lines();
 		void exclude(unsigned line);
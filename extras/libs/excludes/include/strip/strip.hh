@@ -5,6 +5,7 @@
 
 #include <filesystem>
 #include <json/json.hpp>
+#include <optional>
 #include <set>
 #include <span>
 #include <string>
@@ -16,20 +17,81 @@ namespace cov::app::strip {
 	exclude_result find_blocks(std::string const& path,
 	                           std::span<std::string_view const> valid_markers,
 	                           std::string_view text);
+	// with the warnings appended to `messages`, for files processed on
+	// many threads, but reported in order
+	exclude_result find_blocks(std::string const& path,
+	                           std::span<std::string_view const> valid_markers,
+	                           std::string_view text,
+	                           std::string& messages);
+
+	enum class line_kind : unsigned char { kept, empty, excluded };
+
+	// kinds of lines, indexed by line number; an excluded line stays
+	// excluded, even if it is also listed as empty
+	class line_mask {
+	public:
+		line_mask(std::span<excl_block const> excludes,
+		          std::set<unsigned> const& empties);
+
+		line_kind operator[](unsigned line) const noexcept {
+			return line < kinds_.size() ? kinds_[line] : line_kind::kept;
+		}
+		size_t size() const noexcept { return kinds_.size(); }
+
+	private:
+		std::vector<line_kind> kinds_{};
+	};
 
 	bool is_line_excluded(unsigned line_no,
 	                      std::span<excl_block const> const& excludes);
 
+	// a line_coverage key, with the line number parsed from it; the
+	// keys are parsed once per file and shared by the functions below
+	struct numbered_line {
+		unsigned line;
+		json::string key;
+		std::optional<long long> hits;
+	};
+
+	std::vector<numbered_line> number_lines(json::map const& line_coverage);
+
 	std::vector<exclude_report_line> find_lines(
 	    json::map& line_coverage,
 	    std::span<excl_block const> const& excludes,
 	    std::string_view text);
+	std::vector<exclude_report_line> find_lines(
+	    std::span<numbered_line const> lines,
+	    std::span<excl_block const> excludes,
+	    std::string_view text);
+
+	// the excluded lines of the text, with the counters indexed by line
+	// number; missing counters are listed as empty
+	std::vector<exclude_report_line> list_excluded(
+	    line_mask const& mask,
+	    std::vector<std::string>&& counters,
+	    std::string_view text);
 
 	enum which_lines { soft = false, hard = true };
 
 	unsigned erase_lines(json::map& line_coverage,
 	                     std::span<excl_block const> excludes,
 	                     std::set<unsigned> const& empties);
+	unsigned erase_lines(json::map& line_coverage,
+	                     std::span<numbered_line const> lines,
+	                     std::span<excl_block const> excludes,
+	                     std::set<unsigned> const& empties);
+
+	// returns the number of branches erased, not the number of lines
+	unsigned erase_branches(json::map& branches,
+	                        std::span<excl_block const> excludes,
+	                        std::set<unsigned> const& empties);
+
+	// the part of the range left after the excludes and the empty lines
+	// are cut from both of its ends; start > end, if nothing is left
+	excl_block mask_range(long long start_line,
+	                      long long end_line,
+	                      std::span<excl_block const> excludes,
+	                      std::set<unsigned> const& empties);
 
 	size_t filter_blocks(json::array* array,
 	                     std::span<excl_block const> excludes,
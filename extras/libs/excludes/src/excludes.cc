@@ -4,6 +4,7 @@
 #include "strip/excludes.hh"
 #include <fmt/format.h>
 #include <algorithm>
+#include <iterator>
 #include <ctre.hpp>
 #include <native/str.hh>
 
@@ -35,6 +36,29 @@ namespace cov::app::strip {
 		return has;
 	}
 
+	// All the markers have "COV_EXCL_" in them. It is found by its 'X',
+	// which is rare in sources, so the scan is mostly a memchr() over the
+	// whole text, vectorized by the C library.
+	static size_t find_marker(std::string_view text, size_t from) {
+		static constexpr auto marker = "COV_EXCL_"sv;
+		static constexpr auto anchor = marker.find('X');
+
+		if (from > text.size()) return std::string_view::npos;
+		auto pos = text.find('X', from + anchor);
+		while (pos != std::string_view::npos) {
+			auto const start = pos - anchor;
+			if (text.substr(start, marker.size()) == marker) return start;
+			pos = text.find('X', pos + 1);
+		}
+		return pos;
+	}
+
+	static bool is_blank(std::string_view text) {
+		return std::all_of(text.begin(), text.end(), [](char c) {
+			return std::isspace(static_cast<unsigned char>(c));
+		});
+	}
+
 	template <typename Match>
 	unsigned column_from(std::string_view text, Match const& matcher) {
 		auto const group0 = matcher.template get<0>().to_view();
@@ -43,9 +67,35 @@ namespace cov::app::strip {
 		return static_cast<unsigned>(std::max(zero, diff) + 1);
 	}
 
+	void excludes::on_lines(std::string_view text) {
+		auto next_marker = find_marker(text, 0);
+		unsigned line_no = 0;
+		size_t pos = 0;
+		while (true) {
+			auto const eol = text.find('\n', pos);
+			auto const end = eol == std::string_view::npos ? text.size() : eol;
+			auto const line = text.substr(pos, end - pos);
+			++line_no;
+
+			if (next_marker < end) {
+				on_line(line_no, line);
+				// markers have no new lines, the next one is past this line
+				next_marker = find_marker(text, end);
+			} else if (is_blank(line)) {
+				empties.insert(empties.end(), line_no);
+			} else if (inside_exclude) {
+				// what on_line() does for a line without any marker
+				exclude(line_no);
+			}
+
+			if (eol == std::string_view::npos) break;
+			pos = eol + 1;
+		}
+	}
+
 	void excludes::on_line(unsigned line_no, std::string_view text) {
 		if (trim(text).empty()) {
-			empties.insert(line_no);
+			empties.insert(empties.end(), line_no);
 			return;
 		}
 
@@ -130,8 +180,14 @@ namespace cov::app::strip {
 	                       unsigned column,
 	                       std::string_view tag,
 	                       std::string_view msg) {
-		fmt::print(stderr, "\033[1;37m{}:{}:{}:\033[m {}:\033[m {}\n", path,
-		           line, column, tag, msg);
+		static constexpr auto format =
+		    "\033[1;37m{}:{}:{}:\033[m {}:\033[m {}\n"sv;
+		if (messages) {
+			fmt::format_to(std::back_inserter(*messages), format, path, line,
+			               column, tag, msg);
+			return;
+		}
+		fmt::print(stderr, format, path, line, column, tag, msg);
 	}
 
 	std::string excludes::stop_for(std::string_view start,
@@ -5,7 +5,8 @@
 #include <fmt/format.h>
 #include <cov/io/file.hh>
 #include <native/str.hh>
-#include <numeric>
+#include <algorithm>
+#include <charconv>
 
 using namespace std::literals;
 
@@ -13,15 +14,53 @@ namespace cov::app::strip {
 	exclude_result find_blocks(std::string const& path,
 	                           std::span<std::string_view const> valid_markers,
 	                           std::string_view text) {
-		excludes builder{.path = path, .valid_markers = valid_markers};
+		std::string messages{};
+		auto result = find_blocks(path, valid_markers, text, messages);
+		if (!messages.empty()) fmt::print(stderr, "{}", messages);
+		return result;
+	}
 
-		split(text, '\n', [&](unsigned line_no, std::string_view text) {
-			builder.on_line(line_no, text);
-		});
+	exclude_result find_blocks(std::string const& path,
+	                           std::span<std::string_view const> valid_markers,
+	                           std::string_view text,
+	                           std::string& messages) {
+		excludes builder{.path = path,
+		                 .valid_markers = valid_markers,
+		                 .messages = &messages};
+		builder.on_lines(text);
 		builder.after_lines();
 		return {std::move(builder.result), std::move(builder.empties)};
 	}
 
+	line_mask::line_mask(std::span<excl_block const> excludes,
+	                     std::set<unsigned> const& empties) {
+		unsigned size = empties.empty() ? 0u : *empties.rbegin() + 1;
+		for (auto const& block : excludes) {
+			if (block.start <= block.end) size = std::max(size, block.end + 1);
+		}
+
+		kinds_.assign(size, line_kind::kept);
+		for (auto const line : empties)
+			kinds_[line] = line_kind::empty;
+		for (auto const& [start, end] : excludes) {
+			for (auto line = start; line <= end; ++line)
+				kinds_[line] = line_kind::excluded;
+		}
+	}
+
+	namespace {
+		// the keys are written by the reports as plain decimal numbers;
+		// anything else would not be found by a formatted line number
+		// either
+		bool line_from(json::string const& key, unsigned& line) {
+			auto const first = reinterpret_cast<char const*>(key.data());
+			auto const last = first + key.size();
+			if (key.size() > 1 && *first == '0') return false;
+			auto const [ptr, ec] = std::from_chars(first, last, line);
+			return ec == std::errc{} && ptr == last;
+		}
+	}  // namespace
+
 	bool is_line_excluded(unsigned line_no,
 	                      std::span<excl_block const> const& excludes) {
 		for (auto const& [start, end] : excludes) {
@@ -32,36 +71,18 @@ namespace cov::app::strip {
 		return false;
 	}
 
-	std::vector<exclude_report_line> find_lines(
-	    json::map& line_coverage,
-	    std::span<excl_block const> const& excludes,
+	std::vector<exclude_report_line> list_excluded(
+	    line_mask const& mask,
+	    std::vector<std::string>&& counters,
 	    std::string_view text) {
 		std::vector<exclude_report_line> result{};
-
-		size_t size =
-		    std::transform_reduce(excludes.begin(), excludes.end(), size_t{},
-		                          std::plus<>{}, [](auto const& exclude) {
-			                          return exclude.end - exclude.start + 1;
-		                          });
-
-		result.reserve(size);
-
 		split(text, '\n', [&](unsigned line_no, std::string_view text) {
-			if (!is_line_excluded(line_no, excludes)) return;
-
-			auto counter = ""s;
-
-			auto const str = fmt::format("{}", line_no);
-			auto key = to_u8s(str);
-			auto it = line_coverage.find(key);
-
-			if (it != line_coverage.end()) {
-				auto json_counter = cast<long long>(it->second);
-				if (json_counter) counter = fmt::format("{}", *json_counter);
-			}
-
-			result.emplace_back(line_no, std::move(counter),
-			                    std::string{text.data(), text.size()});
+			if (mask[line_no] != line_kind::excluded) return;
+			result.emplace_back(
+			    line_no,
+			    line_no < counters.size() ? std::move(counters[line_no])
+			                              : std::string{},
+			    std::string{text.data(), text.size()});
 		});
 
 		std::sort(result.begin(), result.end());
@@ -69,35 +90,92 @@ namespace cov::app::strip {
 		return result;
 	}  // GCOV_EXCL_LINE[GCC]
 
-	static bool erase_line(json::map& line_coverage,
-	                       unsigned line,
-	                       which_lines intensity) {
-		auto const str = fmt::format("{}", line);
-		auto key = to_u8s(str);
-		auto it = line_coverage.find(key);
-		if (it != line_coverage.end()) {
-			if (intensity == hard || it->second == json::node{0}) {
-				line_coverage.erase(key);
-				return true;
-			}
+	std::vector<numbered_line> number_lines(json::map const& line_coverage) {
+		std::vector<numbered_line> result{};
+		result.reserve(line_coverage.size());
+		for (auto const& [key, value] : line_coverage.items()) {
+			unsigned line{};
+			if (!line_from(key, line)) continue;
+			auto const hits = cast<long long>(value);
+			result.push_back({.line = line,
+			                  .key = key,
+			                  .hits = hits ? std::optional{*hits}
+			                               : std::nullopt});
 		}
-		return false;
+		return result;
+	}
+
+	std::vector<exclude_report_line> find_lines(
+	    json::map& line_coverage,
+	    std::span<excl_block const> const& excludes,
+	    std::string_view text) {
+		return find_lines(number_lines(line_coverage), excludes, text);
+	}
+
+	std::vector<exclude_report_line> find_lines(
+	    std::span<numbered_line const> lines,
+	    std::span<excl_block const> excludes,
+	    std::string_view text) {
+		line_mask const mask{excludes, {}};
+		std::vector<std::string> counters(mask.size());
+		for (auto const& [line, key, hits] : lines) {
+			if (mask[line] != line_kind::excluded || !hits) continue;
+			counters[line] = fmt::format("{}", *hits);
+		}
+
+		return list_excluded(mask, std::move(counters), text);
 	}  // GCOV_EXCL_LINE[GCC]
 
 	unsigned erase_lines(json::map& line_coverage,
 	                     std::span<excl_block const> excludes,
 	                     std::set<unsigned> const& empties) {
-		auto line_counter = 0u;
-		for (auto const [start, stop] : excludes) {
-			for (auto line = start; line <= stop; ++line) {
-				if (erase_line(line_coverage, line, hard)) ++line_counter;
+		return erase_lines(line_coverage, number_lines(line_coverage),
+		                   excludes, empties);
+	}
+
+	// Excluded lines are erased always, empty lines only if they were not
+	// visited.
+	unsigned erase_lines(json::map& line_coverage,
+	                     std::span<numbered_line const> lines,
+	                     std::span<excl_block const> excludes,
+	                     std::set<unsigned> const& empties) {
+		line_mask const mask{excludes, empties};
+
+		unsigned counter{};
+		for (auto const& [line, key, hits] : lines) {
+			auto const kind = mask[line];
+			if (kind == line_kind::excluded ||
+			    (kind == line_kind::empty && hits == 0)) {
+				line_coverage.erase(key);
+				++counter;
 			}
 		}
+		return counter;
+	}
 
-		for (auto const empty : empties) {
-			if (erase_line(line_coverage, empty, soft)) ++line_counter;
+	// Only the excluded lines lose their branches; an empty line with
+	// branches is not empty after all.
+	unsigned erase_branches(json::map& branches,
+	                        std::span<excl_block const> excludes,
+	                        std::set<unsigned> const& empties) {
+		line_mask const mask{excludes, empties};
+
+		std::vector<json::string> erased{};
+		unsigned counter{};
+		for (auto const& [key, value] : branches.items()) {
+			unsigned line{};
+			if (!line_from(key, line) || mask[line] != line_kind::excluded)
+				continue;
+			auto const line_branches = cast<json::array>(value);
+			counter += line_branches
+			               ? static_cast<unsigned>(line_branches->size())
+			               : 0u;
+			erased.push_back(key);
 		}
-		return line_counter;
+
+		for (auto const& key : erased)
+			branches.erase(key);
+		return counter;
 	}
 
 	excl_block mask_range(json::map const& range,
@@ -106,9 +184,15 @@ namespace cov::app::strip {
 		auto json_range_start = cast<long long>(range, u8"start_line");
 		auto json_range_end = cast<long long>(range, u8"end_line");
 		if (!json_range_start) return {.start = 1, .end = 0};
-		auto start_line = *json_range_start;
-		auto end_line = json_range_end ? *json_range_end : start_line;
+		return mask_range(*json_range_start,
+		                  json_range_end ? *json_range_end : *json_range_start,
+		                  excludes, empties);
+	}
 
+	excl_block mask_range(long long start_line,
+	                      long long end_line,
+	                      std::span<excl_block const> excludes,
+	                      std::set<unsigned> const& empties) {
 		for (auto const& block : excludes) {
 			auto const block_start = static_cast<long long>(block.start);
 			auto const block_end = static_cast<long long>(block.end);
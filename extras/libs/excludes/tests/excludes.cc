@@ -89,6 +89,53 @@ namespace cov::app::strip::testing {
 		ASSERT_EQ(expected.erased_lines, actual_counter);
 	}
 
+	TEST(strip_lines, number_lines) {
+		json::map coverage{};
+		coverage.set(u8"1", 5);
+		coverage.set(u8"012", 1);
+		coverage.set(u8"3a", 1);
+		coverage.set(u8"20", json::string{u8"text"});
+
+		std::vector<std::pair<unsigned, std::optional<long long>>> actual{};
+		for (auto const& [line, key, hits] : number_lines(coverage)) {
+			ASSERT_EQ(fmt::format("{}", line), from_u8s(key));
+			actual.emplace_back(line, hits);
+		}
+		std::sort(actual.begin(), actual.end());
+
+		ASSERT_EQ((decltype(actual){{1, 5}, {20, std::nullopt}}), actual);
+	}
+
+	TEST(strip_branches, erase_branches) {
+		auto const line = [](long long taken, long long not_taken) {
+			json::array branches{};
+			json::array branch{};
+			branch.push_back(taken);
+			branch.push_back(not_taken);
+			branches.push_back(branch);
+			branches.push_back(std::move(branch));
+			return branches;
+		};
+
+		json::map branches{};
+		branches.set(u8"2", line(1, 0));
+		branches.set(u8"3", line(0, 1));
+		branches.set(u8"5", line(2, 2));
+		branches.set(u8"7", line(0, 0));
+
+		// line 3 is excluded, line 5 is empty, but has branches anyway
+		std::vector<excl_block> const excludes{{3, 3}, {7, 9}};
+		auto const actual_counter = erase_branches(branches, excludes, {5});
+
+		std::vector<std::string> actual_lines{};
+		for (auto const& [key, value] : branches.items())
+			actual_lines.push_back(from_u8s(key));
+		std::sort(actual_lines.begin(), actual_lines.end());
+
+		ASSERT_EQ((std::vector{"2"s, "5"s}), actual_lines);
+		ASSERT_EQ(4u, actual_counter);
+	}
+
 	static const strip_test tests[] = {
 	    {
 	        .name = "no-blocks"sv,
@@ -158,6 +205,28 @@ text // GRCOV_EXCL_STOP
 	                     .coverage = {{14, 1}},
 	                     .erased_lines = 9},
 	    },
+	    {
+	        .name = "near misses"sv,
+	        .text = R"(EXIT_CODE; // GCOV_EXCL
+text // XCOV_EXCL_LINE
+text // GCOV_EXCL_LINE
+
+text // COV_EXCL_START
+text // GCOV_EXCL_STOP
+)"sv,
+	        .expected = {.blocks = {{{3, 3}}, {4, 7}},
+	                     .lines = {{3, ""s, "text // GCOV_EXCL_LINE"s}},
+	                     .coverage = {{1, 0},
+	                                  {2, 1},
+	                                  {4, 1},
+	                                  {5, 0},
+	                                  {8, 1},
+	                                  {10, 1},
+	                                  {11, 0},
+	                                  {13, 0},
+	                                  {14, 1}},
+	                     .erased_lines = 1},
+	    },
 	    {
 	        .name = "mismatched start-stop"sv,
 	        .text = R"(text // GCOV_EXCL_START
@@ -7,6 +7,7 @@
 #include <map>
 #include <memory>
 #include <mstch/mstch.hpp>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -24,6 +25,15 @@ namespace cov::app::web {
 		bool need_update(std::string const& partial) const override;
 		bool is_valid(std::string const& partial) const override;
 
+		// last write time of the file, which would be loaded for partial
+		std::filesystem::file_time_type last_write(
+		    std::string const& partial) const;
+		// partials loaded so far, with their last write times
+		std::map<std::string, std::filesystem::file_time_type> const& loaded()
+		    const noexcept {
+			return cache_;
+		}
+
 	private:
 		std::vector<std::filesystem::path> roots_;
 		std::filesystem::path res_;
@@ -89,8 +99,10 @@ namespace cov::app::web {
 		}
 	};
 
+	// shared by all pages of an export, which may be rendered concurrently
 	class octicon_callback : public mstch::callback {
 		std::filesystem::path const json_path_;
+		mutable std::mutex m_{};
 		mutable std::map<std::string, mstch::node> storage_;
 
 	public:
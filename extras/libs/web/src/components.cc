@@ -860,7 +860,8 @@ namespace cov::app::web {
 			auto const file_cvg = repo.lookup<cov::line_coverage>(
 			    file_entry->line_coverage(), ec);
 			if (file_cvg && !ec)
-				cvg = core::cvg_info::from_coverage(file_cvg->coverage());
+				cvg = core::cvg_info::from_coverage(
+				    file_cvg->coverage(), file_entry->stats().lines_total);
 		}
 
 		if (with_functions && !file_entry->function_coverage().is_zero()) {
@@ -869,6 +870,12 @@ namespace cov::app::web {
 			if (file_cvg && !ec) cvg.add_functions(*file_cvg);
 		}
 
+		if (!file_entry->branch_coverage().is_zero()) {
+			auto const file_cvg = repo.lookup<cov::branch_coverage>(
+			    file_entry->branch_coverage(), ec);
+			if (file_cvg && !ec) cvg.add_branches(*file_cvg);
+		}
+
 		cvg.find_chunks();
 
 		auto const data = file_entry->get_contents(repo, ec);
@@ -877,7 +884,8 @@ namespace cov::app::web {
 		cvg.load_syntax(
 		    std::string_view{reinterpret_cast<char const*>(data.data()),
 		                     data.size()},
-		    path);
+		    path, file_entry->contents(),
+		    core::highlight_cache::open(repo));
 
 		auto fn = cvg.funcs();
 
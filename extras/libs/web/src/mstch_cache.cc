@@ -196,6 +196,13 @@ namespace cov::app::web {
 
 	bool dir_cache::is_valid(const std::string&) const { return true; }
 
+	std::filesystem::file_time_type dir_cache::last_write(
+	    std::string const& partial) const {
+		auto [last_write, ignore, ec] = find_partial(roots_, res_, partial);
+		if (ec) return std::filesystem::file_time_type::min();
+		return last_write;
+	}
+
 	std::map<std::string_view, lng>& strings() {
 		using namespace std::literals;
 		static std::map<std::string_view, lng> keys = {
@@ -322,6 +329,8 @@ namespace cov::app::web {
 	};
 
 	mstch::node const& octicon_callback::at(std::string const& name) const {
+		// nodes of a std::map stay in place, when other keys are added
+		std::lock_guard lock{m_};
 		auto it = storage_.lower_bound(name);
 		if (it == storage_.end() || it->first != name) {
 			auto const& icons = octicons::get(json_path_);
@@ -0,0 +1,70 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <fmt/format.h>
+#include <chrono>
+#include <cov/hash/md5.hh>
+#include <cov/hash/sha1.hh>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+	using clock_type = std::chrono::steady_clock;
+
+	template <typename Hash>
+	double bytes_per_second(Hash const& prototype,
+	                        std::vector<std::byte> const& content) {
+		static constexpr auto min_time = 200ms;
+		auto const data = git::bytes{content.data(), content.size()};
+
+		size_t rounds{};
+		std::byte sink{};
+		auto const start = clock_type::now();
+		auto elapsed = clock_type::duration{};
+		while (elapsed < min_time) {
+			auto engine = prototype;
+			sink ^= engine.update(data).finalize().data[0];
+			++rounds;
+			elapsed = clock_type::now() - start;
+		}
+
+		if (sink == std::byte{0xFF}) fmt::print(" ");
+		auto const seconds = std::chrono::duration<double>(elapsed).count();
+		return static_cast<double>(rounds * content.size()) / seconds;
+	}
+
+	template <typename Hash>
+	void measure(std::string_view label,
+	             Hash const& prototype,
+	             std::vector<std::byte> const& content) {
+		auto const speed = bytes_per_second(prototype, content);
+		fmt::print("  {:<14} {:>10.1f} MiB/s\n", label,
+		           speed / (1024.0 * 1024.0));
+	}
+}  // namespace
+
+int main() {
+	auto const has_shani =
+	    hash::sha1::best_kernel() == hash::sha1::kernel::shani;
+	fmt::print("sha1 kernel: {}\n", has_shani ? "shani"sv : "portable"sv);
+
+	for (size_t size : {64u, 1024u, 64u * 1024u, 1024u * 1024u}) {
+		std::vector<std::byte> content(size);
+		unsigned seed = 0x1234567u;
+		for (auto& b : content) {
+			seed = seed * 1103515245u + 12345u;
+			b = static_cast<std::byte>(seed >> 16);
+		}
+
+		fmt::print("{} bytes:\n", size);
+		measure("sha1/portable",
+		        hash::sha1{hash::sha1::kernel::portable}, content);
+		if (has_shani) {
+			measure("sha1/shani", hash::sha1{hash::sha1::kernel::shani},
+			        content);
+		}
+		measure("md5", hash::md5{}, content);
+	}
+}
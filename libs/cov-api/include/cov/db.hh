@@ -5,9 +5,21 @@
 #include <cov/counted.hh>
 #include <cov/git2/oid.hh>
 #include <cov/io/db_object.hh>
+#include <cov/io/pack.hh>
 #include <filesystem>
+#include <span>
+#include <system_error>
 
 namespace cov {
+	struct backend_write_stats {
+		size_t written{};
+		size_t skipped{};
+
+		bool operator==(backend_write_stats const&) const noexcept = default;
+	};
+
+	struct write_batch;
+
 	struct backend : public counted {
 		template <typename Object>
 		ref_ptr<Object> lookup(git::oid_view id) {
@@ -15,16 +27,42 @@ namespace cov {
 		}
 		template <typename Object>
 		ref_ptr<Object> lookup(git::oid_view id, size_t character_count) {
-			return as_a<Object>(lookup_object(id, character_count));
+			git::oid found{};
+			if (find_prefix(id, character_count, found) != 1) return {};
+			return as_a<Object>(lookup_object(found));
 		}
-		virtual bool write(git::oid&, ref_ptr<object> const&) = 0;
+		bool write(git::oid& id, ref_ptr<object> const& obj) {
+			return write(id, obj, {});
+		}
+		// Objects, which are already stored here or in any of the `also_in`
+		// backends, are not written again; the id is still reported.
+		virtual bool write(git::oid&,
+		                   ref_ptr<object> const&,
+		                   std::span<backend const* const> also_in) = 0;
+		virtual bool contains(git::oid_view id) const = 0;
+		virtual backend_write_stats write_stats() const = 0;
 
 		static ref_ptr<backend> loose_backend(std::filesystem::path const&);
+		static ref_ptr<backend> pack_backend(std::filesystem::path const&);
+		static ref_ptr<write_batch> pack_batch(std::filesystem::path const&,
+		                                       io::pack_storage storage);
 
 	private:
 		friend struct repository;
 		virtual ref_ptr<object> lookup_object(git::oid_view id) const = 0;
-		virtual ref_ptr<object> lookup_object(git::oid_view id,
-		                                      size_t character_count) const = 0;
+		// returns number of distinct objects matching the prefix, but will
+		// stop counting after second match; the first match is stored in
+		// `found`
+		virtual size_t find_prefix(git::oid_view prefix,
+		                           size_t character_count,
+		                           git::oid& found) const = 0;
+	};
+
+	// Collects written objects into one new pack, which appears in the
+	// pack directory only after a successful commit. Objects written so far
+	// cannot be looked up, until they are committed.
+	struct write_batch : backend {
+		[[nodiscard]] virtual std::error_code commit() = 0;
+		virtual void rollback() = 0;
 	};
 }  // namespace cov
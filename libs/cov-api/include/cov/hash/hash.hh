@@ -125,11 +125,7 @@ namespace hash {
 
 			auto it = data.begin();
 			auto length = data.size();
-
-			auto const lo = count_lo_ + (static_cast<uint32_t>(length) << 3);
-			if (lo < count_lo_) ++count_hi_;
-			count_hi_ += static_cast<uint32_t>(length >> 29);
-			count_lo_ = lo;
+			add_length(length);
 
 			auto const rest = block_byte_size - span_used_;
 			if (length < rest) {
@@ -148,10 +144,10 @@ namespace hash {
 				static_cast<Derived*>(this)->transform(span_);
 			}
 
-			while (length >= block_byte_size) {
-				static_cast<Derived*>(this)->transform(it);
-				std::advance(it, block_byte_size);
-				length -= block_byte_size;
+			if (auto const blocks = length / block_byte_size; blocks) {
+				static_cast<Derived*>(this)->transform_blocks(it, blocks);
+				std::advance(it, blocks * block_byte_size);
+				length -= blocks * block_byte_size;
 			}
 
 			if (length) {
@@ -190,7 +186,42 @@ namespace hash {
 			return Derived{}.update(data).finalize();
 		}
 
+		// Feeds the same number of whole blocks to two hashes, neither of
+		// which may be holding a partial block. Derived may run both
+		// streams side by side with a static transform_lanes().
+		static void update_lanes(Derived& lhs,
+		                         std::byte const* lhs_data,
+		                         Derived& rhs,
+		                         std::byte const* rhs_data,
+		                         size_t count) noexcept {
+			lhs.add_length(count * block_byte_size);
+			rhs.add_length(count * block_byte_size);
+			if constexpr (requires {
+				              Derived::transform_lanes(lhs, lhs_data, rhs,
+				                                       rhs_data, count);
+			              }) {
+				Derived::transform_lanes(lhs, lhs_data, rhs, rhs_data, count);
+			} else {
+				lhs.transform_blocks(lhs_data, count);
+				rhs.transform_blocks(rhs_data, count);
+			}
+		}
+
 	protected:
+		// Derived may hide this with a version, which keeps the state in
+		// registers for the whole run of blocks
+		void transform_blocks(std::byte const* data, size_t count) noexcept {
+			for (; count; --count, data += block_byte_size)
+				static_cast<Derived*>(this)->transform(data);
+		}
+
+		void add_length(size_t length) noexcept {
+			auto const lo = count_lo_ + (static_cast<uint32_t>(length) << 3);
+			if (lo < count_lo_) ++count_hi_;
+			count_hi_ += static_cast<uint32_t>(length >> 29);
+			count_lo_ = lo;
+		}
+
 		static inline uint32_t c2l(const std::byte*& b) noexcept {
 			return host<DataOrder>::c2l(b);
 		}
@@ -10,6 +10,13 @@ namespace hash {
 		md5() = default;
 
 		void transform(std::byte const* block) noexcept;
+		void transform_blocks(std::byte const* data, size_t count) noexcept;
+		// two streams at once, with their rounds interleaved
+		static void transform_lanes(md5& lhs,
+		                            std::byte const* lhs_data,
+		                            md5& rhs,
+		                            std::byte const* rhs_data,
+		                            size_t count) noexcept;
 		digest_type on_result() noexcept;
 
 	private:
@@ -4,19 +4,37 @@
 #pragma once
 #include <algorithm>
 #include <cov/hash/hash.hh>
+#include <cstdint>
 
 namespace hash {
 	struct sha1 : basic_hash<sha1, 64, 20, endian::big> {
+		enum class kernel {
+			// best one this CPU supports, selected once per process
+			automatic,
+			portable,
+			// SHA extensions (SHA-NI) on x86/x64
+			shani,
+		};
+
 		sha1() = default;
+		// kernel::shani on a CPU without SHA extensions (or a build for
+		// another architecture) falls back to kernel::portable
+		explicit sha1(kernel selected) noexcept;
+
+		static kernel best_kernel() noexcept;
 
 		void transform(std::byte const* block) noexcept;
+		void transform_blocks(std::byte const* data, size_t count) noexcept;
 		digest_type on_result() noexcept;
 
 	private:
-		uint32_t A_ = 0x67452301L;
-		uint32_t B_ = 0xEFCDAB89L;
-		uint32_t C_ = 0x98BADCFEL;
-		uint32_t D_ = 0x10325476L;
-		uint32_t E_ = 0xC3D2E1F0L;
+		using blocks_fn = void (*)(std::uint32_t* state,
+		                           std::byte const* data,
+		                           size_t count) noexcept;
+		static blocks_fn kernel_for(kernel selected) noexcept;
+
+		blocks_fn blocks_{kernel_for(kernel::automatic)};
+		std::uint32_t state_[5] = {0x67452301L, 0xEFCDAB89L, 0x98BADCFEL,
+		                           0x10325476L, 0xC3D2E1F0L};
 	};
 }  // namespace hash
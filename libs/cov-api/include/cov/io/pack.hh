@@ -0,0 +1,149 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cov/git2/oid.hh>
+#include <cov/io/safe_stream.hh>
+#include <cov/io/shared_bytes.hh>
+#include <cov/io/types.hh>
+#include <filesystem>
+#include <optional>
+#include <set>
+#include <vector>
+
+namespace cov::io {
+	enum class PACK : std::uint32_t {
+		DATA = "pack"_tag,
+		INDEX = "pidx"_tag,
+	};
+
+	namespace v1 {
+		struct pack_entry {
+			std::uint32_t offset_hi;
+			std::uint32_t offset_lo;
+			std::uint32_t size;
+			std::uint32_t flags;
+
+			// object is stored as-is, at 8-byte aligned offset, so it can
+			// be used directly from mapped pack
+			static constexpr std::uint32_t uncompressed = 0x0000'0001;
+			static constexpr std::uint32_t known_flags = uncompressed;
+
+			std::uint64_t offset() const noexcept {
+				return (static_cast<std::uint64_t>(offset_hi) << 32) |
+				       static_cast<std::uint64_t>(offset_lo);
+			}
+		};
+
+		static_assert(sizeof(pack_entry) == sizeof(std::uint32_t[4]),
+		              "pack_entry does not pack well here");
+
+		struct pack_index {
+			std::uint32_t fanout[256];
+		};
+	}  // namespace v1
+
+	enum class pack_storage { compressed, uncompressed };
+
+	struct repack_stats {
+		size_t loose_objects{};
+		size_t packed_objects{};
+		size_t removed_packs{};
+	};
+
+	class pack_file {
+	public:
+		pack_file() = default;
+
+		static pack_file open(std::filesystem::path const& index_path);
+
+		explicit operator bool() const noexcept { return !index_.empty(); }
+		size_t size() const noexcept { return count_; }
+		std::filesystem::path const& pack_path() const noexcept {
+			return pack_path_;
+		}
+		std::filesystem::path const& index_path() const noexcept {
+			return index_path_;
+		}
+
+		git_oid const& id_at(size_t index) const noexcept {
+			return ids()[index];
+		}
+		v1::pack_entry const& entry_at(size_t index) const noexcept {
+			return entries()[index];
+		}
+
+		// bytes of the object, as they are stored inside the mapped pack;
+		// empty for entries pointing outside the pack or having unknown
+		// flags
+		git::bytes stored(size_t index) const noexcept;
+		ref_ptr<shared_bytes> const& data() const noexcept { return data_; }
+
+		std::optional<size_t> find(git::oid_view id) const noexcept;
+		// returns number of objects matching the prefix, but will stop
+		// counting after second match
+		size_t find_prefix(git::oid_view prefix,
+		                   size_t character_count,
+		                   size_t& index) const noexcept;
+
+	private:
+		std::uint32_t const* fanout() const noexcept;
+		git_oid const* ids() const noexcept;
+		v1::pack_entry const* entries() const noexcept;
+
+		std::filesystem::path pack_path_{};
+		std::filesystem::path index_path_{};
+		std::vector<std::byte> index_{};
+		size_t count_{};
+		ref_ptr<shared_bytes> data_{};
+	};
+
+	class pack_writer {
+	public:
+		explicit pack_writer(std::filesystem::path const& pack_dir);
+		~pack_writer();
+
+		bool opened() const noexcept { return out_.opened(); }
+		size_t size() const noexcept { return entries_.size(); }
+		bool contains(git::oid_view id) const noexcept;
+		bool add(git::oid_view id, git::bytes raw, std::uint32_t flags = 0);
+		std::filesystem::path commit(std::error_code& ec);
+		void rollback();
+
+	private:
+		struct entry {
+			git::oid id{};
+			std::uint64_t offset{};
+			std::uint32_t size{};
+			std::uint32_t flags{};
+		};
+
+		struct oid_less {
+			bool operator()(git::oid const& lhs,
+			                git::oid const& rhs) const noexcept {
+				return git_oid_cmp(&lhs.id, &rhs.id) < 0;
+			}
+		};
+
+		std::filesystem::path pack_dir_{};
+		safe_stream out_;
+		std::uint64_t offset_{};
+		std::vector<entry> entries_{};
+		std::set<git::oid, oid_less> known_{};
+	};
+
+	// paths of the pack indices, without opening any of them
+	std::vector<std::filesystem::path> pack_indices(
+	    std::filesystem::path const& pack_dir);
+	std::vector<pack_file> open_packs(std::filesystem::path const& pack_dir);
+	repack_stats repack(std::filesystem::path const& loose_dir,
+	                    std::filesystem::path const& pack_dir,
+	                    pack_storage storage,
+	                    std::error_code& ec);
+	inline repack_stats repack(std::filesystem::path const& loose_dir,
+	                           std::filesystem::path const& pack_dir,
+	                           std::error_code& ec) {
+		return repack(loose_dir, pack_dir, pack_storage::compressed, ec);
+	}
+}  // namespace cov::io
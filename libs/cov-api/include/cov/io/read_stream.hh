@@ -24,11 +24,19 @@ namespace cov::io {
 
 	class bytes_read_stream : public read_stream {
 		git::bytes in_{};
+		ref_ptr<counted> owner_{};
 
 	public:
 		explicit bytes_read_stream(git::bytes in) : in_{in} {}
+		// with the owner present, view() will share the bytes instead of
+		// copying them
+		bytes_read_stream(git::bytes in, ref_ptr<counted> owner)
+		    : in_{in}, owner_{std::move(owner)} {}
 		explicit operator bool() const noexcept { return true; }
 		bool skip(size_t length) override;
+		bool view(size_t length,
+		          git::bytes& data,
+		          ref_ptr<counted>& owner) override;
 
 	private:
 		size_t read(void* ptr, size_t length) override;
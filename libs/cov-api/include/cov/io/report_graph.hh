@@ -0,0 +1,92 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cov/git2/oid.hh>
+#include <cov/io/shared_bytes.hh>
+#include <cov/io/types.hh>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <vector>
+
+namespace cov::io {
+	enum class GRAPH : std::uint32_t {
+		REPORTS = "rgph"_tag,
+	};
+
+	namespace v1 {
+		struct graph_entry {
+			std::uint32_t parent;
+			timestamp commit;
+			timestamp added;
+			coverage_stats stats;
+
+			// the report is the first one in its history
+			static constexpr std::uint32_t no_parent = 0xFFFF'FFFF;
+			// the parent was not available, when the report was added;
+			// it needs to be looked up through the report object
+			static constexpr std::uint32_t outside = 0xFFFF'FFFE;
+		};
+
+		static_assert(sizeof(graph_entry) == sizeof(std::uint32_t[12]),
+		              "graph_entry does not pack well here");
+
+		struct graph_index {
+			std::uint32_t fanout[256];
+		};
+	}  // namespace v1
+
+	// Parent links, dates and stats of the reports, sorted by their ids and
+	// mapped from a single file, so walking the history does not need to
+	// inflate any of the report objects. Reports are never changed, so the
+	// graph only grows and is always valid for the reports it knows.
+	class report_graph {
+	public:
+		struct node {
+			git::oid id{};
+			git::oid parent{};
+			sys_seconds commit_time{};
+			sys_seconds add_time{};
+			v1::coverage_stats stats{};
+		};
+
+		report_graph() = default;
+
+		static report_graph open(std::filesystem::path const& path);
+
+		explicit operator bool() const noexcept { return !!data_; }
+		size_t size() const noexcept { return count_; }
+
+		git_oid const& id_at(size_t index) const noexcept {
+			return ids()[index];
+		}
+		v1::graph_entry const& entry_at(size_t index) const noexcept {
+			return entries()[index];
+		}
+
+		std::optional<size_t> find(git::oid_view id) const noexcept;
+		// index of the parent of the report at given index; nullopt, if the
+		// report has no parent, or the parent is not in this graph
+		std::optional<size_t> parent_of(size_t index) const noexcept;
+		bool has_parent(size_t index) const noexcept {
+			return entry_at(index).parent != v1::graph_entry::no_parent;
+		}
+
+		// contents of a graph file with all the reports from this graph and
+		// all the added ones, which are not known here yet
+		std::vector<std::byte> merged(std::span<node const> added) const;
+		static std::error_code store(std::filesystem::path const& path,
+		                             git::bytes contents);
+
+	private:
+		std::uint32_t const* fanout() const noexcept;
+		git_oid const* ids() const noexcept;
+		v1::graph_entry const* entries() const noexcept;
+
+		ref_ptr<shared_bytes> data_{};
+		size_t count_{};
+	};
+}  // namespace cov::io
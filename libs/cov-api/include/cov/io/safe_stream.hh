@@ -36,6 +36,8 @@ namespace cov::io {
 		size_t write(git::bytes data) override;
 		bool opened() const noexcept override;
 		std::error_code commit() override;
+		// for outputs named after their own contents
+		std::error_code commit_as(std::filesystem::path const& filename);
 		void rollback() override;
 
 	private:
@@ -0,0 +1,21 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cov/counted.hh>
+#include <cov/git2/bytes.hh>
+#include <filesystem>
+#include <vector>
+
+namespace cov::io {
+	// Read-only memory, which can be shared between the stream reading it
+	// and the objects created from it. It is either mapped directly from
+	// a file, or it is a buffer taken over after inflating an object.
+	struct shared_bytes : counted {
+		virtual git::bytes data() const noexcept = 0;
+
+		static ref_ptr<shared_bytes> map(std::filesystem::path const& path);
+		static ref_ptr<shared_bytes> wrap(std::vector<std::byte>&& buffer);
+	};
+}  // namespace cov::io
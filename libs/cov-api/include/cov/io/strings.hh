@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <cov/git2/bytes.hh>
 #include <cov/io/types.hh>
 #include <functional>
 #include <set>
@@ -114,6 +115,15 @@ namespace cov::io {
 		void resync() noexcept;
 	};
 
+	// strings block viewed in place, e.g. inside a mapped pack; the memory
+	// must outlive this view
+	struct strings_ref : strings_view_base {
+		strings_ref() = default;
+		explicit strings_ref(git::bytes block) noexcept {
+			update(reinterpret_cast<char const*>(block.data()), block.size());
+		}
+	};
+
 	class strings_block : public strings_view_base {
 		std::vector<size_t> offsets_{};
 		std::vector<char> data_{};
@@ -534,6 +534,24 @@ namespace cov::io {
 		static_assert(sizeof(function_coverage) == sizeof(std::uint32_t[5]));
 		static_assert(sizeof(function_coverage::entry) ==
 		              sizeof(std::uint32_t[7]));
+
+		// The table following this header is a byte stream of LEB128
+		// varints: for each line, the distance from the previous line (or
+		// from line zero, for the first one), the number of branches and
+		// the taken and not taken counts of each of them. The stream is
+		// padded with zeros to the `table_size` uints.
+		struct branch_coverage {
+			std::uint32_t line_count;
+			std::uint32_t branch_count;
+			std::uint32_t table_size;
+		};
+		static_assert(sizeof(branch_coverage) == sizeof(std::uint32_t[3]));
+
+		struct branch {
+			std::uint32_t taken;
+			std::uint32_t not_taken;
+			auto operator<=>(branch const&) const noexcept = default;
+		};
 	};  // namespace v1
 
 	ENTRY_TYPE(v1::files, v1::files::basic);
@@ -9,6 +9,7 @@
 #include <cov/object.hh>
 #include <cov/report.hh>
 #include <filesystem>
+#include <map>
 #include <memory>
 #include <span>
 #include <string>
@@ -23,6 +24,38 @@ namespace cov {
 		auto operator<=>(module_info const&) const noexcept = default;
 	};
 
+	// Paths of all the modules, compiled into a tree of path segments.
+	// Looking up a file walks the tree along the file's path, so it costs
+	// as much as the length of the path, no matter how many modules there
+	// are. Module paths may end with a slash, or not.
+	class module_matcher {
+	public:
+		explicit module_matcher(std::vector<module_info> const& mods);
+
+		// modules, which have any path containing given file; path ending
+		// with a slash contains only the files below it, path without one
+		// also names the file itself
+		std::vector<size_t> containing(std::string_view path) const;
+		// modules sharing the longest non-empty path, which either names
+		// given file, or contains it
+		std::vector<size_t> closest(std::string_view path) const;
+
+	private:
+		struct node {
+			std::map<std::string, size_t, std::less<>> children{};
+			// indices of the modules, sorted and unique; for paths without
+			// the slash, matching this directory and everything below it
+			std::vector<size_t> exact{};
+			// for paths with the slash, matching only what is below it
+			std::vector<size_t> below{};
+		};
+
+		template <typename Callback>
+		void walk(std::string_view path, Callback&& callback) const;
+
+		std::vector<node> nodes_{};
+	};
+
 	struct module_view {
 		std::string_view name;
 		std::vector<files::entry const*> items;
@@ -11,6 +11,7 @@ namespace cov {
 	X(files)             \
 	X(line_coverage)     \
 	X(function_coverage) \
+	X(branch_coverage)   \
 	X(blob)              \
 	X(reference)         \
 	X(reference_list)    \
@@ -0,0 +1,64 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+#include <cov/git2/oid.hh>
+#include <cov/object.hh>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace cov {
+	struct object_cache_stats {
+		size_t hits{};
+		size_t misses{};
+		size_t evictions{};
+		size_t objects{};
+		size_t bytes{};
+		size_t budget{};
+
+		bool operator==(object_cache_stats const&) const noexcept = default;
+	};
+
+	// Least recently used objects loaded from the coverage database, kept
+	// until their estimated memory footprint exceeds the budget. Budget of
+	// zero turns the cache off.
+	class object_cache {
+	public:
+		static constexpr size_t default_budget = 32 * 1024 * 1024;
+
+		explicit object_cache(size_t budget = default_budget) noexcept
+		    : budget_{budget} {}
+
+		ref_ptr<object> get(git::oid_view id);
+		void put(git::oid_view id, ref_ptr<object> const& obj);
+		void put(git::oid_view id, ref_ptr<object> const& obj, size_t cost);
+		void resize(size_t budget);
+		void clear();
+		object_cache_stats stats() const;
+
+		static size_t cost_of(object const& obj) noexcept;
+
+	private:
+		struct oid_hash {
+			size_t operator()(git::oid const& id) const noexcept;
+		};
+		struct item {
+			git::oid id;
+			ref_ptr<object> obj;
+			size_t cost;
+		};
+		using list_type = std::list<item>;
+
+		void trim();
+
+		mutable std::mutex m_{};
+		size_t budget_{};
+		size_t bytes_{};
+		size_t hits_{};
+		size_t misses_{};
+		size_t evictions_{};
+		list_type lru_{};
+		std::unordered_map<git::oid, list_type::iterator, oid_hash> index_{};
+	};
+}  // namespace cov
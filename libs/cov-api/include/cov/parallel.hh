@@ -0,0 +1,85 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace cov {
+	inline unsigned hardware_jobs() noexcept {
+		return (std::max)(1u, std::thread::hardware_concurrency());
+	}
+
+	// number of threads parallel_for would use for given arguments
+	inline unsigned parallel_workers(size_t count, unsigned jobs) noexcept {
+		if (jobs > count) jobs = static_cast<unsigned>(count);
+		return (std::max)(1u, jobs);
+	}
+
+	// Calls `callback(index)` for each index in [0, count), using up to
+	// `jobs` threads, the calling one included. Indices are handed out in
+	// order, but may finish in any order; any results should be stored at
+	// their index and reported after this call returns. First exception
+	// thrown by the callback stops handing out new indices and is rethrown
+	// here.
+	//
+	// Callback taking `(index, worker)` is also told, which thread runs
+	// it. Worker is below parallel_workers(count, jobs) and is never used
+	// by two threads, so it can select per-thread state prepared upfront.
+	template <typename Callback>
+	void parallel_for(size_t count, unsigned jobs, Callback&& callback) {
+		auto const call = [&](size_t index, unsigned worker) {
+			if constexpr (std::is_invocable_v<Callback&, size_t, unsigned>)
+				callback(index, worker);
+			else
+				callback(index);
+		};
+
+		jobs = parallel_workers(count, jobs);
+		if (jobs < 2) {
+			for (size_t index = 0; index < count; ++index)
+				call(index, 0);
+			return;
+		}
+
+		std::atomic<size_t> next{0};
+		std::exception_ptr failure{};
+		std::mutex m{};
+
+		auto worker = [&](unsigned id) {
+			try {
+				while (true) {
+					auto const index = next.fetch_add(1);
+					if (index >= count) break;
+					call(index, id);
+				}
+			} catch (...) {
+				std::lock_guard lock{m};
+				if (!failure) failure = std::current_exception();
+				next.store(count);
+			}
+		};
+
+		std::vector<std::thread> threads{};
+		threads.reserve(jobs - 1);
+		for (unsigned thread = 1; thread < jobs; ++thread) {
+			try {
+				threads.emplace_back(worker, thread);
+			} catch (std::system_error const&) {
+				// fewer threads will do the same work
+				break;
+			}
+		}
+		worker(0);
+		for (auto& thread : threads)
+			thread.join();
+
+		if (failure) std::rethrow_exception(failure);
+	}
+}  // namespace cov
@@ -6,7 +6,6 @@
 #include <cov/repository.hh>
 #include <map>
 #include <string>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -83,6 +82,41 @@ namespace cov::projection {
 		}
 	};
 
+	// Files of a report, sorted by name, each with its stats and with the
+	// modules claiming it. Function stats are recalculated from the
+	// repository once, when the index is built. Projections of many pages
+	// of one report can share a single index; after it is built, the
+	// index is only read, so it can be shared between threads, too.
+	class report_index {
+	public:
+		report_index(std::vector<file_stats> const& report,
+		             struct modules const* mods,
+		             cov::repository const* repo = nullptr);
+
+		struct file {
+			file_stats const* source;
+			entry_stats stats{};
+			// modules with the longest path matching this file, as indices
+			// in modules::entries(); empty, if no module claims the file
+			std::vector<size_t> owners{};
+		};
+
+		struct modules const* mods() const noexcept { return mods_; }
+		std::vector<file> const& files() const noexcept { return files_; }
+		// files named either `fname.filter` or starting with
+		// `fname.prefix`, in O(log n) plus the number of files found
+		std::vector<file const*> files_under(prefixed const& fname) const;
+
+	private:
+		friend struct report_filter;
+		report_index(std::vector<file_stats const*> const& report,
+		             struct modules const* mods,
+		             cov::repository const* repo);
+
+		struct modules const* mods_;
+		std::vector<file> files_{};
+	};
+
 	struct report_filter {
 		struct modules const* mods;
 		std::string_view sep{module_separator()};
@@ -96,13 +130,19 @@ namespace cov::projection {
 
 		std::vector<entry> project(std::vector<file_stats> const& report,
 		                           cov::repository const* repo = nullptr) const;
+		// same as above, but with files, stats and modules prepared
+		// upfront; the index must be built over the same modules
+		std::vector<entry> project(report_index const& index) const;
 
 	private:
+		using module_files =
+		    std::map<std::string, std::vector<report_index::file const*>>;
+
 		std::string_view module_separator() const noexcept;
 		std::vector<file_stats const*> file_projection(
 		    std::vector<file_stats> const& report) const;
-		std::pair<std::map<std::string, std::unordered_set<std::string>>,
-		          std::unordered_set<std::string>>
-		modules_projection() const;
+		module_files modules_projection(
+		    report_index const& index,
+		    std::vector<report_index::file const*> const& files) const;
 	};
 }  // namespace cov::projection
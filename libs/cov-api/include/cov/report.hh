@@ -2,6 +2,7 @@
 // This code is licensed under MIT license (see LICENSE for details)
 
 #pragma once
+#include <cov/git2/bytes.hh>
 #include <cov/git2/oid.hh>
 #include <cov/io/types.hh>
 #include <cov/object.hh>
@@ -155,6 +156,7 @@ namespace cov {
 
 		obj_type type() const noexcept override { return obj_files; };
 		bool is_files() const noexcept final { return true; }
+		// sorted by path; create() sorts the list it was given, if needed
 		virtual std::span<std::unique_ptr<entry> const> entries()
 		    const noexcept = 0;
 		virtual entry const* by_path(std::string_view path) const noexcept = 0;
@@ -306,4 +308,65 @@ namespace cov {
 			std::vector<std::unique_ptr<entry>> entries_{};
 		};
 	};
+
+	struct branch_coverage : object {
+		using branch = io::v1::branch;
+
+		// Decodes the table one line at a time; the branches of current
+		// line are only valid until the next call to next().
+		class cursor {
+		public:
+			explicit cursor(branch_coverage const& obj);
+
+			// false after the last line, or when the table is malformed
+			bool next();
+			bool failed() const noexcept { return failed_; }
+			std::uint32_t line() const noexcept { return line_; }
+			std::span<branch const> branches() const noexcept {
+				return branches_;
+			}
+
+		private:
+			std::byte const* pos_{};
+			std::byte const* end_{};
+			std::uint32_t lines_left_{};
+			std::uint32_t line_{};
+			bool failed_{false};
+			std::vector<branch> branches_{};
+		};
+
+		obj_type type() const noexcept override {
+			return obj_branch_coverage;
+		};
+		bool is_branch_coverage() const noexcept final { return true; }
+		virtual std::uint32_t line_count() const noexcept = 0;
+		virtual std::uint32_t branch_count() const noexcept = 0;
+		// varint-encoded table, as described by io::v1::branch_coverage
+		virtual git::bytes table() const noexcept = 0;
+
+		cursor lines() const { return cursor{*this}; }
+		// each branch has two outcomes, each of them is visited, if taken
+		// at least once
+		io::v1::stats summary() const;
+
+		static ref_ptr<branch_coverage> create(std::uint32_t line_count,
+		                                       std::uint32_t branch_count,
+		                                       std::vector<std::byte>&& table);
+
+		class builder {
+		public:
+			// lines must be added in ascending order; lines without
+			// branches are skipped
+			builder& add(std::uint32_t line, std::span<branch const> branches);
+			ref_ptr<branch_coverage> extract();
+
+		private:
+			void put(std::uint32_t value);
+
+			std::vector<std::byte> table_{};
+			std::uint32_t line_count_{};
+			std::uint32_t branch_count_{};
+			std::uint32_t last_line_{};
+		};
+	};
 }  // namespace cov
@@ -10,8 +10,12 @@
 #include <cov/git2/oid.hh>
 #include <cov/git2/repository.hh>
 #include <cov/init.hh>
+#include <cov/io/pack.hh>
+#include <cov/io/report_graph.hh>
+#include <cov/object_cache.hh>
 #include <cov/reference.hh>
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -117,6 +121,8 @@ namespace cov {
 	};
 
 	struct repository {
+		static constexpr unsigned default_auto_pack_limit = 50;
+
 		repository();
 		repository(repository&&);
 		repository& operator=(repository&&);
@@ -191,6 +197,28 @@ namespace cov {
 		bool write(git::oid& out, git::bytes const& bytes) {
 			return git_.write(out, bytes);
 		}
+		// Objects written between begin_batch() and commit_batch() are
+		// stored in one new pack instead of a loose file each; they can be
+		// looked up only after the commit. If the batch cannot be started,
+		// the objects are written as loose files. Once there are more than
+		// pack.autoPackLimit packs after a commit (0 turns it off), all of
+		// them are repacked into one.
+		bool begin_batch();
+		[[nodiscard]] std::error_code commit_batch();
+		void rollback_batch();
+		io::repack_stats repack(std::error_code& ec);
+		// Adds the report and all of its ancestors, which are not there
+		// yet, to the report graph.
+		std::error_code update_report_graph(git::oid_view tip);
+		io::report_graph const& report_graph() const noexcept {
+			return graph_;
+		}
+		// Parent of the report, taken from the report graph, if possible;
+		// zero id for the first report in the history and nullopt for ids
+		// of objects, which are not reports.
+		std::optional<git::oid> parent_report(git::oid_view id) const;
+		backend_write_stats write_stats() const;
+		object_cache_stats cache_stats() const;
 
 		std::map<std::string, commit_file_diff> diff_betwen_commits(
 		    git::oid_view newer,
@@ -219,6 +247,10 @@ namespace cov {
 		ref_ptr<object> lookup_object(git::oid_view id, std::error_code&) const;
 
 	private:
+		void end_batch();
+		void auto_repack();
+		io::pack_storage pack_storage() const;
+
 		struct git_repo {
 			git_repo();
 			void open(std::filesystem::path const& common_dir,
@@ -242,5 +274,10 @@ namespace cov {
 		git_repo git_{};
 		ref_ptr<references> refs_{};
 		ref_ptr<backend> db_{};
+		ref_ptr<backend> packs_{};
+		ref_ptr<write_batch> batch_{};
+		backend_write_stats batched_{};
+		std::unique_ptr<object_cache> cache_{};
+		io::report_graph graph_{};
 	};
 }  // namespace cov
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <concepts>
+#include <cov/counted.hh>
 #include <cov/git2/bytes.hh>
 #include <cov/git2/oid.hh>
 #include <filesystem>
@@ -81,6 +82,13 @@ namespace cov {
 
 		virtual bool skip(size_t length) = 0;
 
+		// Zero-copy alternative to load(). Streams backed by shared memory
+		// will point the view at next `length` bytes and hand out the owner
+		// of that memory; other streams return false and do not move.
+		virtual bool view(size_t length,
+		                  git::bytes& data,
+		                  ref_ptr<counted>& owner);
+
 	private:
 		virtual size_t read(void* ptr, size_t length) = 0;
 	};
@@ -16,9 +16,17 @@ namespace cov {
 			deflate = true,
 		};
 
-		zstream(direction dir);
+		enum wrapper : bool {
+			zlib = false,
+			gzip = true,
+		};
+
+		zstream(direction dir, wrapper wrap = zlib);
 		virtual ~zstream();
 		size_t append(git::bytes data);
+		// true, if the finished stream was read (or written) to its end;
+		// false for truncated and corrupted input
+		bool complete() const noexcept { return complete_; }
 
 	protected:
 		void finish();
@@ -29,6 +37,7 @@ namespace cov {
 
 		z_stream z_{};
 		direction deflating_{};
+		bool complete_{false};
 		static constexpr uInt buffer_min_extra = 8, buffer_size = 8 * 1024;
 	};
 
@@ -48,7 +57,8 @@ namespace cov {
 	struct buffer_zstream : zstream {
 		byte_block buffer;
 
-		buffer_zstream(direction dir) : zstream{dir} {}
+		buffer_zstream(direction dir, wrapper wrap = zlib)
+		    : zstream{dir, wrap} {}
 
 		size_t output(git::bytes data) override { return buffer.append(data); }
 
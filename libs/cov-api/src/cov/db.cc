@@ -3,33 +3,109 @@
 
 #include <fmt/format.h>
 #include <git2/oid.h>
+#include <atomic>
 #include <cov/db.hh>
+#include <cov/hash/sha1.hh>
+#include <cov/io/branch_coverage.hh>
 #include <cov/io/build.hh>
 #include <cov/io/file.hh>
 #include <cov/io/files.hh>
 #include <cov/io/function_coverage.hh>
 #include <cov/io/line_coverage.hh>
+#include <cov/io/pack.hh>
 #include <cov/io/read_stream.hh>
 #include <cov/io/report.hh>
 #include <cov/io/safe_stream.hh>
+#include <cov/io/shared_bytes.hh>
 #include <cov/zstream.hh>
+#include <mutex>
 #include "path-utils.hh"
 
 namespace cov {
 	namespace {
 		using namespace ::std::literals;
 
+		bool inflate(git::bytes bytes, std::vector<std::byte>& output) {
+			buffer_zstream z{zstream::inflate};
+			if (z.append(bytes) != bytes.size()) return false;
+
+			output = z.close().data;
+			return true;
+		}
+
 		bool load_zstream(std::filesystem::path const& filename,
 		                  std::vector<std::byte>& output) {
 			auto const file = io::fopen(filename, "rb");
 			if (!file) return false;
 			auto const bytes = file.read();
-			buffer_zstream z{zstream::inflate};
-			if (z.append({bytes.data(), bytes.size()}) != bytes.size())
-				return false;
+			return inflate({bytes.data(), bytes.size()}, output);
+		}
 
-			output = z.close().data;
-			return true;
+		void add_handlers(io::db_object& io) {
+			io.add_handler<io::OBJECT::REPORT, io::handlers::report>();
+			io.add_handler<io::OBJECT::BUILD, io::handlers::build>();
+			io.add_handler<io::OBJECT::FILES, io::handlers::files>();
+			io.add_handler<io::OBJECT::COVERAGE, io::handlers::line_coverage>();
+			io.add_handler<io::OBJECT::FUNCTIONS,
+			               io::handlers::function_coverage>();
+			io.add_handler<io::OBJECT::BRANCHES,
+			               io::handlers::branch_coverage>();
+		}
+
+		class memory_stream final : public write_stream {
+		public:
+			bool opened() const noexcept override { return true; }
+			git::bytes data() const noexcept {
+				return {data_.data(), data_.size()};
+			}
+
+		private:
+			size_t write(git::bytes bytes) override {
+				data_.insert(data_.end(), bytes.begin(), bytes.end());
+				return bytes.size();
+			}
+
+			std::vector<std::byte> data_{};
+		};
+
+		git::oid oid_of(git::bytes data) {
+			auto const digest = hash::sha1::once(data);
+
+			git::oid result{};
+			static_assert(sizeof(digest.data) == sizeof(result.id.id),
+			              "git::oid and sha1 digest sizes are mismatched");
+			memcpy(&result.id.id, digest.data, sizeof(digest.data));
+			return result;
+		}
+
+		bool stored_in(git::oid_view id,
+		               std::span<backend const* const> backends) {
+			for (auto const* other : backends) {
+				if (other && other->contains(id)) return true;
+			}
+			return false;
+		}
+
+		// objects loaded from the shared bytes may keep them alive and point
+		// into them, instead of copying their contents
+		ref_ptr<object> load_object(io::db_object const& io,
+		                            git::oid_view id,
+		                            git::bytes data,
+		                            ref_ptr<counted> owner) {
+			io::bytes_read_stream stream{data, std::move(owner)};
+			std::error_code ec{};
+			auto result = io.load(id, stream, ec);
+			if (!result || ec || !result->is_object()) return {};
+
+			return ref_ptr{take(static_cast<cov::object*>(result.unlink()))};
+		}
+
+		ref_ptr<object> load_object(io::db_object const& io,
+		                            git::oid_view id,
+		                            std::vector<std::byte>&& bytes) {
+			auto shared = io::shared_bytes::wrap(std::move(bytes));
+			auto const data = shared->data();
+			return load_object(io, id, data, std::move(shared));
 		}
 	}  // namespace
 
@@ -37,90 +113,300 @@ namespace cov {
 	public:
 		loose_backend(std::filesystem::path const&);
 		ref_ptr<object> lookup_object(git::oid_view id) const override;
-		ref_ptr<object> lookup_object(git::oid_view id,
-		                              size_t character_count) const override;
-		bool write(git::oid& id, ref_ptr<object> const& obj) override;
+		size_t find_prefix(git::oid_view prefix,
+		                   size_t character_count,
+		                   git::oid& found) const override;
+		bool write(git::oid& id,
+		           ref_ptr<object> const& obj,
+		           std::span<backend const* const> also_in) override;
+		bool contains(git::oid_view id) const override;
+		backend_write_stats write_stats() const override;
 
 	private:
 		std::filesystem::path root_{};
 		io::db_object io_{};
+		std::atomic<size_t> written_{};
+		std::atomic<size_t> skipped_{};
+	};
+
+	class pack_backend : public counted_impl<backend> {
+	public:
+		pack_backend(std::filesystem::path const&);
+		ref_ptr<object> lookup_object(git::oid_view id) const override;
+		size_t find_prefix(git::oid_view prefix,
+		                   size_t character_count,
+		                   git::oid& found) const override;
+		bool write(git::oid& id,
+		           ref_ptr<object> const& obj,
+		           std::span<backend const* const> also_in) override;
+		bool contains(git::oid_view id) const override;
+		backend_write_stats write_stats() const override { return {}; }
+
+	private:
+		ref_ptr<object> load(io::pack_file const& pack,
+		                     size_t index,
+		                     git::oid_view id) const;
+
+		std::vector<io::pack_file> packs_{};
+		io::db_object io_{};
+	};
+
+	class pack_batch : public counted_impl<write_batch> {
+	public:
+		pack_batch(std::filesystem::path const& pack_dir,
+		           io::pack_storage storage);
+		bool opened() const noexcept { return writer_.opened(); }
+
+		ref_ptr<object> lookup_object(git::oid_view) const override {
+			return {};
+		}
+		size_t find_prefix(git::oid_view, size_t, git::oid&) const override {
+			return 0;
+		}
+		bool write(git::oid& id,
+		           ref_ptr<object> const& obj,
+		           std::span<backend const* const> also_in) override;
+		bool contains(git::oid_view id) const override;
+		backend_write_stats write_stats() const override;
+		std::error_code commit() override;
+		void rollback() override;
+
+	private:
+		mutable std::mutex m_{};
+		io::pack_writer writer_;
+		std::uint32_t flags_{};
+		size_t skipped_{};
+		io::db_object io_{};
 	};
 
 	loose_backend::loose_backend(std::filesystem::path const& root)
 	    : root_{root} {
-		io_.add_handler<io::OBJECT::REPORT, io::handlers::report>();
-		io_.add_handler<io::OBJECT::BUILD, io::handlers::build>();
-		io_.add_handler<io::OBJECT::FILES, io::handlers::files>();
-		io_.add_handler<io::OBJECT::COVERAGE, io::handlers::line_coverage>();
-		io_.add_handler<io::OBJECT::FUNCTIONS,
-		                io::handlers::function_coverage>();
+		add_handlers(io_);
 	}
 
 	ref_ptr<object> loose_backend::lookup_object(git::oid_view id) const {
 		std::vector<std::byte> bytes;
 		if (!load_zstream(root_ / id.path(), bytes)) return {};
-
-		io::bytes_read_stream stream{{bytes.data(), bytes.size()}};
-		std::error_code ec{};
-		auto result = io_.load(id, stream, ec);
-		if (!result || ec || !result->is_object()) return {};
-
-		return ref_ptr{take(static_cast<cov::object*>(result.unlink()))};
+		return load_object(io_, id, std::move(bytes));
 	}
 
-	ref_ptr<object> loose_backend::lookup_object(git::oid_view id_,
-	                                             size_t character_count) const {
-		if (character_count >= GIT_OID_HEXSZ) return lookup_object(id_);
+	size_t loose_backend::find_prefix(git::oid_view prefix,
+	                                  size_t character_count,
+	                                  git::oid& found) const {
+		if (character_count >= GIT_OID_HEXSZ) {
+			if (!contains(prefix)) return 0;
+			found = git::oid{*prefix.ref};
+			return 1;
+		}
 
-		if (character_count < GIT_OID_MINPREFIXLEN) return {};
+		if (character_count < GIT_OID_MINPREFIXLEN) return 0;
 		static_assert(GIT_OID_MINPREFIXLEN > 2);
 
 		char buffer[GIT_OID_HEXSZ];
-		if (git_oid_fmt(buffer, id_.ref)) return {};
+		if (git_oid_fmt(buffer, prefix.ref)) return 0;
 		auto view = std::string_view{buffer, character_count};
 		auto dir = view.substr(0, 2);
 		auto match = view.substr(2);
 
 		std::error_code ec{};
 		auto it = std::filesystem::directory_iterator{root_ / dir, ec};
-		if (ec) return {};
+		if (ec) return 0;
 
-		std::vector<std::filesystem::path> paths{};
-		git::oid id{*id_.ref};
+		size_t count{};
 		for (auto const& entry : it) {
 			auto filename = get_path(entry.path().filename());
 			if (!filename.starts_with(match)) continue;
-			if (!paths.empty()) return {};
-			paths.push_back(entry.path());
+			if (count++) return count;
 			auto const str = fmt::format("{}{}", dir, filename);
-			id = git::oid::from(str);
+			found = git::oid::from(str);
 		}
-		if (paths.empty()) return {};
-
-		std::vector<std::byte> bytes;
-		if (!load_zstream(paths.front(), bytes)) return {};
+		return count;
+	}
 
-		io::bytes_read_stream stream{{bytes.data(), bytes.size()}};
-		auto result = io_.load(id, stream, ec);
-		if (!result || ec || !result->is_object()) return {};
+	bool loose_backend::write(git::oid& id,
+	                          ref_ptr<object> const& obj,
+	                          std::span<backend const* const> also_in) {
+		// the id is the hash of uncompressed data, so there is no need to
+		// compress anything to learn, the object is already stored
+		memory_stream serialized{};
+		if (!io_.store(obj, serialized)) return false;
 
-		return ref_ptr{take(static_cast<cov::object*>(result.unlink()))};
-	}
+		auto const data = serialized.data();
+		auto const known = oid_of(data);
+		if (contains(known) || stored_in(known, also_in)) {
+			++skipped_;
+			id = known;
+			return true;
+		}
 
-	bool loose_backend::write(git::oid& id, ref_ptr<object> const& obj) {
 		io::safe_z_stream output{root_, "object"sv};
-		if (!output.opened()) return false;
-
-		if (!io_.store(obj, output)) {
+		if (!output.opened() || !output.store(data)) {
 			output.rollback();
 			return false;
 		}
 
 		id = output.finish();
+		++written_;
 		return true;
 	}
 
+	bool loose_backend::contains(git::oid_view id) const {
+		std::error_code ec{};
+		return std::filesystem::is_regular_file(root_ / id.path(), ec);
+	}
+
+	backend_write_stats loose_backend::write_stats() const {
+		return {.written = written_.load(), .skipped = skipped_.load()};
+	}
+
+	pack_backend::pack_backend(std::filesystem::path const& pack_dir)
+	    : packs_{io::open_packs(pack_dir)} {
+		add_handlers(io_);
+	}
+
+	ref_ptr<object> pack_backend::lookup_object(git::oid_view id) const {
+		for (auto const& pack : packs_) {
+			if (auto const index = pack.find(id)) return load(pack, *index, id);
+		}
+		return {};
+	}
+
+	size_t pack_backend::find_prefix(git::oid_view prefix,
+	                                 size_t character_count,
+	                                 git::oid& found) const {
+		if (character_count >= GIT_OID_HEXSZ) {
+			if (!contains(prefix)) return 0;
+			found = git::oid{*prefix.ref};
+			return 1;
+		}
+		if (character_count < GIT_OID_MINPREFIXLEN) return 0;
+
+		size_t count{};
+		for (auto const& pack : packs_) {
+			size_t index{};
+			auto const matches =
+			    pack.find_prefix(prefix, character_count, index);
+			if (!matches) continue;
+			if (matches > 1) return matches;
+			// the same object could be stored in more than one pack
+			if (count && found != pack.id_at(index)) return 2;
+			found = git::oid{pack.id_at(index)};
+			count = 1;
+		}
+		return count;
+	}
+
+	bool pack_backend::write(git::oid&,
+	                         ref_ptr<object> const&,
+	                         std::span<backend const* const>) {
+		// packs are only created by repacking the loose objects
+		return false;
+	}
+
+	bool pack_backend::contains(git::oid_view id) const {
+		for (auto const& pack : packs_) {
+			if (pack.find(id)) return true;
+		}
+		return false;
+	}
+
+	ref_ptr<object> pack_backend::load(io::pack_file const& pack,
+	                                   size_t index,
+	                                   git::oid_view id) const {
+		auto const stored = pack.stored(index);
+		if (stored.empty()) return {};
+		if (pack.entry_at(index).flags & io::v1::pack_entry::uncompressed)
+			return load_object(io_, id, stored, pack.data());
+
+		std::vector<std::byte> bytes;
+		if (!inflate(stored, bytes)) return {};
+		return load_object(io_, id, std::move(bytes));
+	}
+
+	pack_batch::pack_batch(std::filesystem::path const& pack_dir,
+	                       io::pack_storage storage)
+	    : writer_{pack_dir}
+	    , flags_{storage == io::pack_storage::uncompressed
+	                 ? io::v1::pack_entry::uncompressed
+	                 : 0u} {
+		add_handlers(io_);
+	}
+
+	bool pack_batch::write(git::oid& id,
+	                       ref_ptr<object> const& obj,
+	                       std::span<backend const* const> also_in) {
+		memory_stream serialized{};
+		if (!io_.store(obj, serialized)) return false;
+
+		auto const data = serialized.data();
+		auto const known = oid_of(data);
+		if (stored_in(known, also_in)) {
+			std::lock_guard lock{m_};
+			++skipped_;
+			id = known;
+			return true;
+		}
+
+		// compress outside of the lock, only the pack output is shared
+		byte_block compressed{};
+		auto stored = data;
+		if (!(flags_ & io::v1::pack_entry::uncompressed)) {
+			buffer_zstream z{zstream::deflate};
+			if (z.append(data) != data.size()) return false;
+			compressed = z.close();
+			stored = compressed.bytes();
+		}
+
+		std::lock_guard lock{m_};
+		if (writer_.contains(known)) {
+			++skipped_;
+		} else if (!writer_.add(known, stored, flags_)) {
+			return false;
+		}
+		id = known;
+		return true;
+	}
+
+	bool pack_batch::contains(git::oid_view id) const {
+		std::lock_guard lock{m_};
+		return writer_.contains(id);
+	}
+
+	backend_write_stats pack_batch::write_stats() const {
+		std::lock_guard lock{m_};
+		return {.written = writer_.size(), .skipped = skipped_};
+	}
+
+	std::error_code pack_batch::commit() {
+		std::lock_guard lock{m_};
+		std::error_code ec{};
+		// nothing new, no need for an empty pack
+		if (!writer_.size())
+			writer_.rollback();
+		else
+			writer_.commit(ec);
+		return ec;
+	}
+
+	void pack_batch::rollback() {
+		std::lock_guard lock{m_};
+		writer_.rollback();
+	}
+
 	ref_ptr<backend> backend::loose_backend(std::filesystem::path const& root) {
 		return make_ref<cov::loose_backend>(root);
 	}
+
+	ref_ptr<backend> backend::pack_backend(
+	    std::filesystem::path const& pack_dir) {
+		return make_ref<cov::pack_backend>(pack_dir);
+	}
+
+	ref_ptr<write_batch> backend::pack_batch(
+	    std::filesystem::path const& pack_dir,
+	    io::pack_storage storage) {
+		auto result = make_ref<cov::pack_batch>(pack_dir, storage);
+		if (!result->opened()) return {};
+		return result;
+	}
 }  // namespace cov
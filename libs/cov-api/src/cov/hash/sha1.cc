@@ -3,6 +3,22 @@
 
 #include "cov/hash/sha1.hh"
 #include <cstdint>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define HAS_SHANI 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SHANI_TARGET
+#else
+#include <cpuid.h>
+#define SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#endif
+#else
+#define HAS_SHANI 0
+#endif
 
 namespace hash {
 	namespace {
@@ -62,128 +78,256 @@ namespace hash {
 		             std::uint32_t& e) {
 			SHA_ROUND(W, a, b, c, d, e, b ^ c ^ d, 0xCA62C1D6);
 		}
+
+		void transform_portable(std::uint32_t* state,
+		                        std::byte const* data) noexcept {
+			uint32_t A = state[0];
+			uint32_t B = state[1];
+			uint32_t C = state[2];
+			uint32_t D = state[3];
+			uint32_t E = state[4];
+
+			uint32_t W[80];
+			for (size_t t = 0; t < 16; ++t)
+				W[t] = host<endian::big>::c2l(data);
+
+			for (size_t t = 16; t < 80; ++t)
+				W[t] = ROTATE(W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16], 1);
+
+			T_0_19(W[0], A, B, C, D, E);
+			T_0_19(W[1], A, B, C, D, E);
+			T_0_19(W[2], A, B, C, D, E);
+			T_0_19(W[3], A, B, C, D, E);
+			T_0_19(W[4], A, B, C, D, E);
+			T_0_19(W[5], A, B, C, D, E);
+			T_0_19(W[6], A, B, C, D, E);
+			T_0_19(W[7], A, B, C, D, E);
+			T_0_19(W[8], A, B, C, D, E);
+			T_0_19(W[9], A, B, C, D, E);
+			T_0_19(W[10], A, B, C, D, E);
+			T_0_19(W[11], A, B, C, D, E);
+			T_0_19(W[12], A, B, C, D, E);
+			T_0_19(W[13], A, B, C, D, E);
+			T_0_19(W[14], A, B, C, D, E);
+			T_0_19(W[15], A, B, C, D, E);
+			T_0_19(W[16], A, B, C, D, E);
+			T_0_19(W[17], A, B, C, D, E);
+			T_0_19(W[18], A, B, C, D, E);
+			T_0_19(W[19], A, B, C, D, E);
+
+			T_20_39(W[20], A, B, C, D, E);
+			T_20_39(W[21], A, B, C, D, E);
+			T_20_39(W[22], A, B, C, D, E);
+			T_20_39(W[23], A, B, C, D, E);
+			T_20_39(W[24], A, B, C, D, E);
+			T_20_39(W[25], A, B, C, D, E);
+			T_20_39(W[26], A, B, C, D, E);
+			T_20_39(W[27], A, B, C, D, E);
+			T_20_39(W[28], A, B, C, D, E);
+			T_20_39(W[29], A, B, C, D, E);
+			T_20_39(W[30], A, B, C, D, E);
+			T_20_39(W[31], A, B, C, D, E);
+			T_20_39(W[32], A, B, C, D, E);
+			T_20_39(W[33], A, B, C, D, E);
+			T_20_39(W[34], A, B, C, D, E);
+			T_20_39(W[35], A, B, C, D, E);
+			T_20_39(W[36], A, B, C, D, E);
+			T_20_39(W[37], A, B, C, D, E);
+			T_20_39(W[38], A, B, C, D, E);
+			T_20_39(W[39], A, B, C, D, E);
+
+			T_40_59(W[40], A, B, C, D, E);
+			T_40_59(W[41], A, B, C, D, E);
+			T_40_59(W[42], A, B, C, D, E);
+			T_40_59(W[43], A, B, C, D, E);
+			T_40_59(W[44], A, B, C, D, E);
+			T_40_59(W[45], A, B, C, D, E);
+			T_40_59(W[46], A, B, C, D, E);
+			T_40_59(W[47], A, B, C, D, E);
+			T_40_59(W[48], A, B, C, D, E);
+			T_40_59(W[49], A, B, C, D, E);
+			T_40_59(W[50], A, B, C, D, E);
+			T_40_59(W[51], A, B, C, D, E);
+			T_40_59(W[52], A, B, C, D, E);
+			T_40_59(W[53], A, B, C, D, E);
+			T_40_59(W[54], A, B, C, D, E);
+			T_40_59(W[55], A, B, C, D, E);
+			T_40_59(W[56], A, B, C, D, E);
+			T_40_59(W[57], A, B, C, D, E);
+			T_40_59(W[58], A, B, C, D, E);
+			T_40_59(W[59], A, B, C, D, E);
+
+			T_60_79(W[60], A, B, C, D, E);
+			T_60_79(W[61], A, B, C, D, E);
+			T_60_79(W[62], A, B, C, D, E);
+			T_60_79(W[63], A, B, C, D, E);
+			T_60_79(W[64], A, B, C, D, E);
+			T_60_79(W[65], A, B, C, D, E);
+			T_60_79(W[66], A, B, C, D, E);
+			T_60_79(W[67], A, B, C, D, E);
+			T_60_79(W[68], A, B, C, D, E);
+			T_60_79(W[69], A, B, C, D, E);
+			T_60_79(W[70], A, B, C, D, E);
+			T_60_79(W[71], A, B, C, D, E);
+			T_60_79(W[72], A, B, C, D, E);
+			T_60_79(W[73], A, B, C, D, E);
+			T_60_79(W[74], A, B, C, D, E);
+			T_60_79(W[75], A, B, C, D, E);
+			T_60_79(W[76], A, B, C, D, E);
+			T_60_79(W[77], A, B, C, D, E);
+			T_60_79(W[78], A, B, C, D, E);
+			T_60_79(W[79], A, B, C, D, E);
+
+			state[0] += A;
+			state[1] += B;
+			state[2] += C;
+			state[3] += D;
+			state[4] += E;
+		}
+
+		void portable_blocks(std::uint32_t* state,
+		                     std::byte const* data,
+		                     size_t count) noexcept {
+			for (; count; --count, data += sha1::block_byte_size)
+				transform_portable(state, data);
+		}
+
+#if HAS_SHANI
+		// Each group of four rounds is one SHA1RNDS4, with the round
+		// function selected by the immediate argument; the message schedule
+		// for the group is built from the previous four groups.
+		template <int Group>
+		SHANI_TARGET inline void shani_group(__m128i& abcd,
+		                                     __m128i& e,
+		                                     __m128i& prev,
+		                                     __m128i (&msg)[4]) noexcept {
+			auto& W = msg[Group % 4];
+			if constexpr (Group >= 4) {
+				W = _mm_sha1msg1_epu32(W, msg[(Group + 1) % 4]);
+				W = _mm_xor_si128(W, msg[(Group + 2) % 4]);
+				W = _mm_sha1msg2_epu32(W, msg[(Group + 3) % 4]);
+			}
+
+			if constexpr (Group == 0)
+				e = _mm_add_epi32(e, W);
+			else
+				e = _mm_sha1nexte_epu32(prev, W);
+			prev = abcd;
+			abcd = _mm_sha1rnds4_epu32(abcd, e, Group / 5);
+		}
+
+		template <int... Group>
+		SHANI_TARGET inline void shani_rounds(
+		    __m128i& abcd,
+		    __m128i& e,
+		    __m128i (&msg)[4],
+		    std::integer_sequence<int, Group...>) noexcept {
+			__m128i prev{};
+			(shani_group<Group>(abcd, e, prev, msg), ...);
+			e = prev;
+		}
+
+		SHANI_TARGET void shani_blocks(std::uint32_t* state,
+		                               std::byte const* data,
+		                               size_t count) noexcept {
+			auto const BSWAP = _mm_set_epi64x(0x0001020304050607ULL,
+			                                  0x08090a0b0c0d0e0fULL);
+
+			auto abcd = _mm_shuffle_epi32(
+			    _mm_loadu_si128(reinterpret_cast<__m128i const*>(state)),
+			    0x1B);
+			auto e = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+			for (; count; --count, data += sha1::block_byte_size) {
+				auto const abcd_saved = abcd;
+				auto const e_saved = e;
+
+				__m128i msg[4];
+				for (int index = 0; index < 4; ++index) {
+					msg[index] = _mm_shuffle_epi8(
+					    _mm_loadu_si128(
+					        reinterpret_cast<__m128i const*>(data) + index),
+					    BSWAP);
+				}
+
+				shani_rounds(abcd, e, msg,
+				             std::make_integer_sequence<int, 20>{});
+
+				e = _mm_sha1nexte_epu32(e, e_saved);
+				abcd = _mm_add_epi32(abcd, abcd_saved);
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+			                 _mm_shuffle_epi32(abcd, 0x1B));
+			state[4] = static_cast<std::uint32_t>(_mm_extract_epi32(e, 3));
+		}
+
+		bool cpu_has_shani() noexcept {
+			static constexpr unsigned SSSE3 = 1u << 9;
+			static constexpr unsigned SSE41 = 1u << 19;
+			static constexpr unsigned SHA = 1u << 29;
+#ifdef _MSC_VER
+			int regs[4];
+			__cpuid(regs, 0);
+			if (regs[0] < 7) return false;
+			__cpuid(regs, 1);
+			auto const leaf1_ecx = static_cast<unsigned>(regs[2]);
+			__cpuidex(regs, 7, 0);
+			auto const leaf7_ebx = static_cast<unsigned>(regs[1]);
+#else
+			unsigned eax{}, ebx{}, ecx{}, edx{};
+			if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+			auto const leaf1_ecx = ecx;
+			if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+			auto const leaf7_ebx = ebx;
+#endif
+			return (leaf1_ecx & (SSSE3 | SSE41)) == (SSSE3 | SSE41) &&
+			       (leaf7_ebx & SHA) == SHA;
+		}
+#endif
 	}  // namespace
 
+	sha1::sha1(kernel selected) noexcept : blocks_{kernel_for(selected)} {}
+
+	sha1::kernel sha1::best_kernel() noexcept {
+#if HAS_SHANI
+		static auto const best =
+		    cpu_has_shani() ? kernel::shani : kernel::portable;
+		return best;
+#else
+		return kernel::portable;
+#endif
+	}
+
+	sha1::blocks_fn sha1::kernel_for(kernel selected) noexcept {
+		if (selected == kernel::automatic) selected = best_kernel();
+#if HAS_SHANI
+		if (selected == kernel::shani && best_kernel() == kernel::shani)
+			return shani_blocks;
+#endif
+		return portable_blocks;
+	}
+
 	sha1::digest_type sha1::on_result() noexcept {
 		digest_type result{};
 		auto* it = result.data;
-		l2c(A_, it);
-		l2c(B_, it);
-		l2c(C_, it);
-		l2c(D_, it);
-		l2c(E_, it);
-
-		A_ = 0x67452301L;
-		B_ = 0xEFCDAB89L;
-		C_ = 0x98BADCFEL;
-		D_ = 0x10325476L;
-		E_ = 0xC3D2E1F0L;
+		for (auto& value : state_)
+			l2c(value, it);
+
+		state_[0] = 0x67452301L;
+		state_[1] = 0xEFCDAB89L;
+		state_[2] = 0x98BADCFEL;
+		state_[3] = 0x10325476L;
+		state_[4] = 0xC3D2E1F0L;
 
 		return result;
 	}
 
 	void sha1::transform(std::byte const* data) noexcept {
-		uint32_t A = A_;
-		uint32_t B = B_;
-		uint32_t C = C_;
-		uint32_t D = D_;
-		uint32_t E = E_;
-
-		uint32_t W[80];
-		for (size_t t = 0; t < 16; ++t)
-			W[t] = c2l(data);
-
-		for (size_t t = 16; t < 80; ++t)
-			W[t] = ROTATE(W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16], 1);
-
-		T_0_19(W[0], A, B, C, D, E);
-		T_0_19(W[1], A, B, C, D, E);
-		T_0_19(W[2], A, B, C, D, E);
-		T_0_19(W[3], A, B, C, D, E);
-		T_0_19(W[4], A, B, C, D, E);
-		T_0_19(W[5], A, B, C, D, E);
-		T_0_19(W[6], A, B, C, D, E);
-		T_0_19(W[7], A, B, C, D, E);
-		T_0_19(W[8], A, B, C, D, E);
-		T_0_19(W[9], A, B, C, D, E);
-		T_0_19(W[10], A, B, C, D, E);
-		T_0_19(W[11], A, B, C, D, E);
-		T_0_19(W[12], A, B, C, D, E);
-		T_0_19(W[13], A, B, C, D, E);
-		T_0_19(W[14], A, B, C, D, E);
-		T_0_19(W[15], A, B, C, D, E);
-		T_0_19(W[16], A, B, C, D, E);
-		T_0_19(W[17], A, B, C, D, E);
-		T_0_19(W[18], A, B, C, D, E);
-		T_0_19(W[19], A, B, C, D, E);
-
-		T_20_39(W[20], A, B, C, D, E);
-		T_20_39(W[21], A, B, C, D, E);
-		T_20_39(W[22], A, B, C, D, E);
-		T_20_39(W[23], A, B, C, D, E);
-		T_20_39(W[24], A, B, C, D, E);
-		T_20_39(W[25], A, B, C, D, E);
-		T_20_39(W[26], A, B, C, D, E);
-		T_20_39(W[27], A, B, C, D, E);
-		T_20_39(W[28], A, B, C, D, E);
-		T_20_39(W[29], A, B, C, D, E);
-		T_20_39(W[30], A, B, C, D, E);
-		T_20_39(W[31], A, B, C, D, E);
-		T_20_39(W[32], A, B, C, D, E);
-		T_20_39(W[33], A, B, C, D, E);
-		T_20_39(W[34], A, B, C, D, E);
-		T_20_39(W[35], A, B, C, D, E);
-		T_20_39(W[36], A, B, C, D, E);
-		T_20_39(W[37], A, B, C, D, E);
-		T_20_39(W[38], A, B, C, D, E);
-		T_20_39(W[39], A, B, C, D, E);
-
-		T_40_59(W[40], A, B, C, D, E);
-		T_40_59(W[41], A, B, C, D, E);
-		T_40_59(W[42], A, B, C, D, E);
-		T_40_59(W[43], A, B, C, D, E);
-		T_40_59(W[44], A, B, C, D, E);
-		T_40_59(W[45], A, B, C, D, E);
-		T_40_59(W[46], A, B, C, D, E);
-		T_40_59(W[47], A, B, C, D, E);
-		T_40_59(W[48], A, B, C, D, E);
-		T_40_59(W[49], A, B, C, D, E);
-		T_40_59(W[50], A, B, C, D, E);
-		T_40_59(W[51], A, B, C, D, E);
-		T_40_59(W[52], A, B, C, D, E);
-		T_40_59(W[53], A, B, C, D, E);
-		T_40_59(W[54], A, B, C, D, E);
-		T_40_59(W[55], A, B, C, D, E);
-		T_40_59(W[56], A, B, C, D, E);
-		T_40_59(W[57], A, B, C, D, E);
-		T_40_59(W[58], A, B, C, D, E);
-		T_40_59(W[59], A, B, C, D, E);
-
-		T_60_79(W[60], A, B, C, D, E);
-		T_60_79(W[61], A, B, C, D, E);
-		T_60_79(W[62], A, B, C, D, E);
-		T_60_79(W[63], A, B, C, D, E);
-		T_60_79(W[64], A, B, C, D, E);
-		T_60_79(W[65], A, B, C, D, E);
-		T_60_79(W[66], A, B, C, D, E);
-		T_60_79(W[67], A, B, C, D, E);
-		T_60_79(W[68], A, B, C, D, E);
-		T_60_79(W[69], A, B, C, D, E);
-		T_60_79(W[70], A, B, C, D, E);
-		T_60_79(W[71], A, B, C, D, E);
-		T_60_79(W[72], A, B, C, D, E);
-		T_60_79(W[73], A, B, C, D, E);
-		T_60_79(W[74], A, B, C, D, E);
-		T_60_79(W[75], A, B, C, D, E);
-		T_60_79(W[76], A, B, C, D, E);
-		T_60_79(W[77], A, B, C, D, E);
-		T_60_79(W[78], A, B, C, D, E);
-		T_60_79(W[79], A, B, C, D, E);
-
-		A_ += A;
-		B_ += B;
-		C_ += C;
-		D_ += D;
-		E_ += E;
+		blocks_(state_, data, 1);
+	}
+
+	void sha1::transform_blocks(std::byte const* data, size_t count) noexcept {
+		blocks_(state_, data, count);
 	}
 }  // namespace hash
@@ -0,0 +1,239 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <cov/io/branch_coverage.hh>
+#include <cov/io/read_stream.hh>
+#include <cov/io/types.hh>
+#include <limits>
+
+namespace cov::io::handlers {
+	namespace {
+		struct impl : counted_impl<cov::branch_coverage> {
+			impl(std::uint32_t line_count,
+			     std::uint32_t branch_count,
+			     std::vector<std::byte>&& table)
+			    : line_count_{line_count}
+			    , branch_count_{branch_count}
+			    , table_{std::move(table)} {}
+
+			std::uint32_t line_count() const noexcept override {
+				return line_count_;
+			}
+			std::uint32_t branch_count() const noexcept override {
+				return branch_count_;
+			}
+			git::bytes table() const noexcept override {
+				return {table_.data(), table_.size()};
+			}
+
+		private:
+			std::uint32_t line_count_{};
+			std::uint32_t branch_count_{};
+			std::vector<std::byte> table_{};
+		};
+
+		struct view_impl : counted_impl<cov::branch_coverage> {
+			view_impl(v1::branch_coverage const& header,
+			          git::bytes table,
+			          ref_ptr<counted>&& owner)
+			    : owner_{std::move(owner)}
+			    , line_count_{header.line_count}
+			    , branch_count_{header.branch_count}
+			    , table_{table} {}
+
+			std::uint32_t line_count() const noexcept override {
+				return line_count_;
+			}
+			std::uint32_t branch_count() const noexcept override {
+				return branch_count_;
+			}
+			git::bytes table() const noexcept override { return table_; }
+
+		private:
+			ref_ptr<counted> owner_{};
+			std::uint32_t line_count_{};
+			std::uint32_t branch_count_{};
+			git::bytes table_{};
+		};
+
+		// the table is walked once here, so that a malformed object is
+		// rejected on load, not in the middle of printing it
+		ref_ptr<counted> validated(ref_ptr<cov::branch_coverage> obj,
+		                           std::error_code& ec) {
+			std::uint64_t branches{};
+			auto cursor = obj->lines();
+			while (cursor.next())
+				branches += cursor.branches().size();
+			if (cursor.failed() || branches != obj->branch_count()) return {};
+			ec.clear();
+			return obj;
+		}
+	}  // namespace
+
+	ref_ptr<counted> branch_coverage::load(uint32_t,
+	                                       uint32_t,
+	                                       git::oid_view,
+	                                       read_stream& in,
+	                                       std::error_code& ec) const {
+		ec = make_error_code(errc::bad_syntax);
+		v1::branch_coverage header{};
+		if (!in.load(header)) return {};
+
+		auto const size = size_t{header.table_size} * sizeof(std::uint32_t);
+
+		git::bytes data{};
+		ref_ptr<counted> owner{};
+		if (in.view(size, data, owner)) {
+			// varints have no alignment, any view will do
+			return validated(
+			    make_ref<view_impl>(header, data, std::move(owner)), ec);
+		}
+
+		std::vector<std::byte> table{};
+		if (!in.load(table, size)) return {};
+		return validated(cov::branch_coverage::create(
+		                     header.line_count, header.branch_count,
+		                     std::move(table)),
+		                 ec);
+	}
+
+	bool branch_coverage::store(ref_ptr<counted> const& value,
+	                            write_stream& out) const {
+		static constexpr std::byte zeros[sizeof(std::uint32_t)]{};
+
+		auto const obj =
+		    as_a<cov::branch_coverage>(static_cast<object const*>(value.get()));
+		if (!obj) return false;
+		auto const table = obj->table();
+		auto const padding = (sizeof(std::uint32_t) -
+		                      table.size() % sizeof(std::uint32_t)) %
+		                     sizeof(std::uint32_t);
+		v1::branch_coverage hdr{
+		    .line_count = obj->line_count(),
+		    .branch_count = obj->branch_count(),
+		    .table_size = clip_u32((table.size() + padding) /
+		                           sizeof(std::uint32_t)),
+		};
+		if (!out.store(hdr)) return false;
+		if (!out.store(table)) return false;
+		if (!out.store(git::bytes{zeros, padding})) return false;
+		return true;
+	}
+}  // namespace cov::io::handlers
+
+namespace cov {
+	namespace {
+		bool read_varint(std::byte const*& pos,
+		                 std::byte const* end,
+		                 std::uint32_t& value) {
+			static constexpr unsigned max_shift = 35;
+			std::uint64_t result{};
+			for (unsigned shift = 0; pos != end && shift < max_shift;
+			     shift += 7) {
+				auto const byte = std::to_integer<std::uint64_t>(*pos++);
+				result |= (byte & 0x7F) << shift;
+				if (!(byte & 0x80)) {
+					if (result > std::numeric_limits<std::uint32_t>::max())
+						return false;
+					value = static_cast<std::uint32_t>(result);
+					return true;
+				}
+			}
+			return false;
+		}
+	}  // namespace
+
+	branch_coverage::cursor::cursor(branch_coverage const& obj) {
+		auto const table = obj.table();
+		pos_ = table.data();
+		end_ = pos_ + table.size();
+		lines_left_ = obj.line_count();
+	}
+
+	bool branch_coverage::cursor::next() {
+		if (!lines_left_) return false;
+		--lines_left_;
+
+		std::uint32_t distance{};
+		std::uint32_t count{};
+		// each of the counts takes at least one byte, which keeps the
+		// vector below from growing past the table
+		auto ok = read_varint(pos_, end_, distance) &&
+		          read_varint(pos_, end_, count) &&
+		          distance <= std::numeric_limits<std::uint32_t>::max() -
+		                          line_ &&
+		          count <= static_cast<size_t>(end_ - pos_) / 2;
+		if (ok) {
+			line_ += distance;
+			branches_.resize(count);
+			for (auto& branch : branches_) {
+				ok = read_varint(pos_, end_, branch.taken) &&
+				     read_varint(pos_, end_, branch.not_taken);
+				if (!ok) break;
+			}
+		}
+
+		if (!ok) {
+			failed_ = true;
+			lines_left_ = 0;
+			branches_.clear();
+		}
+		return ok;
+	}
+
+	io::v1::stats branch_coverage::summary() const {
+		auto result = io::v1::stats::init();
+		auto cursor = lines();
+		while (cursor.next()) {
+			for (auto const& branch : cursor.branches()) {
+				result.relevant = io::add_u32(result.relevant, 2);
+				if (branch.taken) io::inc_u32(result.visited);
+				if (branch.not_taken) io::inc_u32(result.visited);
+			}
+		}
+		return result;
+	}
+
+	ref_ptr<branch_coverage> branch_coverage::create(
+	    std::uint32_t line_count,
+	    std::uint32_t branch_count,
+	    std::vector<std::byte>&& table) {
+		return make_ref<io::handlers::impl>(line_count, branch_count,
+		                                    std::move(table));
+	}
+
+	branch_coverage::builder& branch_coverage::builder::add(
+	    std::uint32_t line,
+	    std::span<branch const> branches) {
+		if (branches.empty()) return *this;
+
+		auto const count = io::clip_u32(branches.size());
+		put(line - last_line_);
+		put(count);
+		for (auto const& branch : branches.first(count)) {
+			put(branch.taken);
+			put(branch.not_taken);
+		}
+
+		last_line_ = line;
+		io::inc_u32(line_count_);
+		branch_count_ = io::add_u32(branch_count_, count);
+		return *this;
+	}
+
+	ref_ptr<branch_coverage> branch_coverage::builder::extract() {
+		auto result =
+		    create(line_count_, branch_count_, std::move(table_));
+		table_.clear();
+		line_count_ = branch_count_ = last_line_ = 0;
+		return result;
+	}
+
+	void branch_coverage::builder::put(std::uint32_t value) {
+		while (value >= 0x80) {
+			table_.push_back(static_cast<std::byte>((value & 0x7F) | 0x80));
+			value >>= 7;
+		}
+		table_.push_back(static_cast<std::byte>(value));
+	}
+}  // namespace cov
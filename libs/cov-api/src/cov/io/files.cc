@@ -1,21 +1,25 @@
 // Copyright (c) 2022 Marcin Zdun
 // This code is licensed under MIT license (see LICENSE for details)
 
+#include <algorithm>
 #include <cov/git2/blob.hh>
 #include <cov/io/files.hh>
+#include <cov/io/read_stream.hh>
 #include <cov/io/strings.hh>
 #include <cov/io/types.hh>
 #include <cov/repository.hh>
+#include "object_view.hh"
 
 namespace cov::io::handlers {
 	namespace {
-		struct entry_impl : cov::files::entry {
-			entry_impl(std::string_view path,
-			           io::v1::coverage_stats const& stats,
-			           git::oid_view contents,
-			           git::oid_view line_coverage,
-			           git::oid_view function_coverage,
-			           git::oid_view branch_coverage)
+		template <typename String>
+		struct basic_entry_impl : cov::files::entry {
+			basic_entry_impl(std::string_view path,
+			                 io::v1::coverage_stats const& stats,
+			                 git::oid_view contents,
+			                 git::oid_view line_coverage,
+			                 git::oid_view function_coverage,
+			                 git::oid_view branch_coverage)
 			    : path_{path.data(), path.size()}
 			    , stats_{stats}
 			    , contents_{contents.oid()}
@@ -23,7 +27,7 @@ namespace cov::io::handlers {
 			    , function_coverage_{function_coverage.oid()}
 			    , branch_coverage_{branch_coverage.oid()} {}
 
-			~entry_impl() = default;
+			~basic_entry_impl() = default;
 			std::string_view path() const noexcept override { return path_; }
 			io::v1::coverage_stats const& stats() const noexcept override {
 				return stats_;
@@ -45,7 +49,9 @@ namespace cov::io::handlers {
 			    std::error_code& ec) const noexcept override {
 				auto const obj = repo.lookup<cov::blob>(contents_, ec);
 				if (!obj || ec) return {};
-				auto blob = obj->peek().filtered(path_.c_str(), ec);
+				// both std::string and paths from the strings block are
+				// zero-terminated
+				auto blob = obj->peek().filtered(path_.data(), ec);
 				if (ec) return {};
 				auto const data = git::bytes{blob};
 				auto result = std::vector<std::byte>{data.begin(), data.end()};
@@ -54,7 +60,7 @@ namespace cov::io::handlers {
 			}
 
 		private:
-			std::string path_{};
+			String path_{};
 			io::v1::coverage_stats stats_{};
 			git::oid contents_{};
 			git::oid line_coverage_{};
@@ -62,10 +68,41 @@ namespace cov::io::handlers {
 			git::oid branch_coverage_{};
 		};
 
+		using entry_impl = basic_entry_impl<std::string>;
+
+		// lives in an entry_arena, with the path pointing to the strings
+		// block of a viewed object
+		struct view_entry : basic_entry_impl<std::string_view> {
+			using basic_entry_impl<std::string_view>::basic_entry_impl;
+			static void operator delete(void*) noexcept {}
+		};
+
+		bool path_less(std::unique_ptr<cov::files::entry> const& lhs,
+		               std::unique_ptr<cov::files::entry> const& rhs) {
+			return lhs->path() < rhs->path();
+		}
+
+		// entries of both implementations are sorted by path
+		cov::files::entry const* find_by_path(
+		    std::span<std::unique_ptr<cov::files::entry> const> entries,
+		    std::string_view path) noexcept {
+			auto it = std::lower_bound(
+			    entries.begin(), entries.end(), path,
+			    [](auto const& entry, std::string_view path) {
+				    return entry->path() < path;
+			    });
+			if (it == entries.end() || (*it)->path() != path) return nullptr;
+			return it->get();
+		}
+
 		struct impl : counted_impl<cov::files> {
 			explicit impl(git::oid_view id,
 			              std::vector<std::unique_ptr<entry>>&& files)
-			    : id_{id.oid()}, files_{std::move(files)} {}
+			    : id_{id.oid()}, files_{std::move(files)} {
+				// builder and loaders give sorted lists already
+				if (!std::is_sorted(files_.begin(), files_.end(), path_less))
+					std::stable_sort(files_.begin(), files_.end(), path_less);
+			}
 
 			git::oid const& oid() const noexcept override { return id_; };
 			std::span<std::unique_ptr<entry> const> entries()
@@ -75,10 +112,7 @@ namespace cov::io::handlers {
 
 			entry const* by_path(
 			    std::string_view path) const noexcept override {
-				for (auto const& entry : files_) {
-					if (entry->path() == path) return entry.get();
-				}
-				return nullptr;
+				return find_by_path(files_, path);
 			}
 
 		private:
@@ -86,6 +120,158 @@ namespace cov::io::handlers {
 			std::vector<std::unique_ptr<entry>> files_{};
 		};
 
+		struct view_impl : counted_impl<cov::files> {
+			view_impl(git::oid_view id, ref_ptr<counted>&& owner, size_t count)
+			    : id_{id.oid()}, owner_{std::move(owner)}, files_{count} {}
+
+			git::oid const& oid() const noexcept override { return id_; };
+			std::span<std::unique_ptr<entry> const> entries()
+			    const noexcept override {
+				return files_.entries();
+			}
+
+			entry const* by_path(
+			    std::string_view path) const noexcept override {
+				return find_by_path(files_.entries(), path);
+			}
+
+			template <typename... Args>
+			void add(Args&&... args) {
+				files_.emplace(std::forward<Args>(args)...);
+			}
+
+		private:
+			git::oid id_{};
+			ref_ptr<counted> owner_{};
+			entry_arena<view_entry, entry> files_;
+		};
+
+		struct decoded_entry {
+			std::string_view path{};
+			io::v1::coverage_stats stats{};
+			git_oid const* contents{};
+			git_oid const* line_coverage{};
+			git_oid const* function_coverage{};
+			git_oid const* branch_coverage{};
+		};
+
+		bool decode(strings_view_base const& strings,
+		            std::byte const* data,
+		            size_t entry_size,
+		            decoded_entry& out) {
+			static const git::oid zero_id{};
+
+			auto const& entry_v0 =
+			    *reinterpret_cast<v1::files::basic const*>(data);
+
+			if (!strings.is_valid(entry_v0.path)) {
+				return false;
+			}
+
+			if (entry_size < sizeof(v1::files::ext)) {
+				out = {.path = strings.at(entry_v0.path),
+				       .stats = {entry_v0.lines_total, entry_v0.lines.summary,
+				                 io::v1::stats::init(), io::v1::stats::init()},
+				       .contents = &entry_v0.contents,
+				       .line_coverage = &entry_v0.lines.details,
+				       .function_coverage = &zero_id.id,
+				       .branch_coverage = &zero_id.id};
+				return true;
+			}
+
+			auto const& entry_v1 =
+			    *reinterpret_cast<v1::files::ext const*>(data);
+			out = {.path = strings.at(entry_v1.path),
+			       .stats = {entry_v1.lines_total, entry_v1.lines.summary,
+			                 entry_v1.functions.summary,
+			                 entry_v1.branches.summary},
+			       .contents = &entry_v1.contents,
+			       .line_coverage = &entry_v1.lines.details,
+			       .function_coverage = &entry_v1.functions.details,
+			       .branch_coverage = &entry_v1.branches.details};
+			return true;
+		}
+
+		ref_ptr<counted> load_files(git::oid_view oid,
+		                            v1::files const& header,
+		                            read_stream& in) {
+			if (!in.skip((header.strings.offset * sizeof(uint32_t)) -
+			             sizeof(header))) {
+				return {};
+			}
+			strings_view strings{};
+			if (!strings.load_from(in, header.strings)) {
+				return {};
+			}
+
+			if (!in.skip((header.entries.offset -
+			              (header.strings.offset + header.strings.size)) *
+			             sizeof(uint32_t))) {
+				return {};
+			}
+
+			cov::files::builder builder{};
+			std::vector<std::byte> buffer{};
+			decoded_entry entry{};
+
+			auto const entry_size = header.entries.size * sizeof(uint32_t);
+			for (uint32_t index = 0; index < header.entries.count; ++index) {
+				if (!in.load(buffer, entry_size)) {
+					return {};
+				}
+
+				if (!decode(strings, buffer.data(), entry_size, entry)) {
+					return {};
+				}
+
+				builder.add(entry.path, entry.stats, *entry.contents,
+				            *entry.line_coverage, *entry.function_coverage,
+				            *entry.branch_coverage);
+			}
+
+			return builder.extract(oid);
+		}
+
+		// Same as load_files, but without copying either the strings, or
+		// the entries. Lists, which are not sorted by path, are left for
+		// load_files, since they need the builder to reorder or dedupe them.
+		ref_ptr<counted> view_files(git::oid_view oid,
+		                            v1::files const& header,
+		                            git::bytes data,
+		                            ref_ptr<counted>&& owner) {
+			auto const strings_offset =
+			    header.strings.offset * sizeof(uint32_t) - sizeof(header);
+			auto const entries_offset =
+			    header.entries.offset * sizeof(uint32_t) - sizeof(header);
+			auto const entry_size = header.entries.size * sizeof(uint32_t);
+
+			strings_ref const strings{data.subview(
+			    strings_offset, header.strings.size * sizeof(uint32_t))};
+			if (!view_as<v1::files::basic>(data, entries_offset)) return {};
+
+			auto result =
+			    make_ref<view_impl>(oid, std::move(owner), header.entries.count);
+			decoded_entry entry{};
+			std::string_view prev{};
+
+			for (uint32_t index = 0; index < header.entries.count; ++index) {
+				if (!decode(strings,
+				            data.data() + entries_offset + index * entry_size,
+				            entry_size, entry)) {
+					return {};
+				}
+
+				if (index && prev >= entry.path) return {};
+				prev = entry.path;
+
+				result->add(entry.path, entry.stats, *entry.contents,
+				            *entry.line_coverage, *entry.function_coverage,
+				            *entry.branch_coverage);
+			}
+
+			return result;
+		}
+
 		constexpr uint32_t uint_32(size_t value) {
 			return static_cast<uint32_t>(value &
 			                             std::numeric_limits<uint32_t>::max());
@@ -110,58 +296,23 @@ namespace cov::io::handlers {
 			return {};
 		}
 
-		if (!in.skip((header.strings.offset * sizeof(uint32_t)) -
-		             sizeof(header))) {
-			return {};
-		}
-		strings_view strings{};
-		if (!strings.load_from(in, header.strings)) {
-			return {};
-		}
-
-		if (!in.skip((header.entries.offset -
-		              (header.strings.offset + header.strings.size)) *
-		             sizeof(uint32_t))) {
-			return {};
-		}
-
-		cov::files::builder builder{};
-		std::vector<std::byte> buffer{};
-
-		static const git::oid zero_id{};
-
-		auto const entry_size = header.entries.size * sizeof(uint32_t);
-		for (uint32_t index = 0; index < header.entries.count; ++index) {
-			if (!in.load(buffer, entry_size)) {
-				return {};
-			}
-			auto const& entry_v0 =
-			    *reinterpret_cast<v1::files::basic const*>(buffer.data());
-
-			if (!strings.is_valid(entry_v0.path)) {
-				return {};
-			}
-
-			if (entry_size < sizeof(v1::files::ext)) {
-				builder.add(strings.at(entry_v0.path),
-				            {entry_v0.lines_total, entry_v0.lines.summary,
-				             io::v1::stats::init(), io::v1::stats::init()},
-				            entry_v0.contents, entry_v0.lines.details, zero_id,
-				            zero_id);
-			} else {
-				auto const& entry_v1 =
-				    *reinterpret_cast<v1::files::ext const*>(buffer.data());
-				builder.add(
-				    strings.at(entry_v1.path),
-				    {entry_v1.lines_total, entry_v1.lines.summary,
-				     entry_v1.functions.summary, entry_v1.branches.summary},
-				    entry_v1.contents, entry_v1.lines.details,
-				    entry_v1.functions.details, entry_v1.branches.details);
+		ref_ptr<counted> result{};
+		git::bytes data{};
+		ref_ptr<counted> owner{};
+		if (in.view(payload_size(header), data, owner)) {
+			// offsets outside of the payload are broken, copying won't help
+			if (!payload_fits(header, data)) return {};
+			result = view_files(oid, header, data, std::move(owner));
+			if (!result) {
+				bytes_read_stream copy{data};
+				result = load_files(oid, header, copy);
 			}
+		} else {
+			result = load_files(oid, header, in);
 		}
 
-		ec.clear();
-		return builder.extract(oid);
+		if (result) ec.clear();
+		return result;
 	}
 
 	template <typename EntryType>
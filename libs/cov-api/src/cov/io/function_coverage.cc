@@ -3,31 +3,30 @@
 
 #include <cov/git2/blob.hh>
 #include <cov/io/function_coverage.hh>
+#include <cov/io/read_stream.hh>
 #include <cov/io/strings.hh>
 #include <cov/io/types.hh>
 #include <cov/repository.hh>
 #include <map>
 #include <set>
+#include "object_view.hh"
 
 namespace cov::io::handlers {
 	namespace {
-		inline std::string S(std::string_view view) {
-			return {view.data(), view.size()};
-		}
-
-		struct entry_impl : cov::function_coverage::entry {
-			entry_impl(std::string_view name,
-			           std::string_view demangled_name,
-			           uint32_t count,
-			           io::v1::text_pos const& start,
-			           io::v1::text_pos const& end)
-			    : name_{S(name)}
-			    , demangled_name_{S(demangled_name)}
+		template <typename String>
+		struct basic_entry_impl : cov::function_coverage::entry {
+			basic_entry_impl(std::string_view name,
+			                 std::string_view demangled_name,
+			                 uint32_t count,
+			                 io::v1::text_pos const& start,
+			                 io::v1::text_pos const& end)
+			    : name_{name.data(), name.size()}
+			    , demangled_name_{demangled_name.data(), demangled_name.size()}
 			    , count_{count}
 			    , start_{start}
 			    , end_{end} {}
 
-			~entry_impl() = default;
+			~basic_entry_impl() = default;
 
 			std::string_view name() const noexcept override { return name_; };
 			std::string_view demangled_name() const noexcept override {
@@ -42,13 +41,22 @@ namespace cov::io::handlers {
 			};
 
 		private:
-			std::string name_{};
-			std::string demangled_name_{};
+			String name_{};
+			String demangled_name_{};
 			uint32_t count_{};
 			io::v1::text_pos start_{};
 			io::v1::text_pos end_{};
 		};
 
+		using entry_impl = basic_entry_impl<std::string>;
+
+		// lives in an entry_arena, with the names pointing to the strings
+		// block of a viewed object
+		struct view_entry : basic_entry_impl<std::string_view> {
+			using basic_entry_impl<std::string_view>::basic_entry_impl;
+			static void operator delete(void*) noexcept {}
+		};
+
 		struct impl : counted_impl<cov::function_coverage> {
 			explicit impl(std::vector<std::unique_ptr<entry>>&& files)
 			    : files_{std::move(files)} {}
@@ -62,6 +70,111 @@ namespace cov::io::handlers {
 			std::vector<std::unique_ptr<entry>> files_{};
 		};
 
+		struct view_impl : counted_impl<cov::function_coverage> {
+			view_impl(ref_ptr<counted>&& owner, size_t count)
+			    : owner_{std::move(owner)}, entries_{count} {}
+
+			std::span<std::unique_ptr<entry> const> entries()
+			    const noexcept override {
+				return entries_.entries();
+			}
+
+			template <typename... Args>
+			void add(Args&&... args) {
+				entries_.emplace(std::forward<Args>(args)...);
+			}
+
+		private:
+			ref_ptr<counted> owner_{};
+			entry_arena<view_entry, entry> entries_;
+		};
+
+		bool entry_valid(strings_view_base const& strings,
+		                 v1::function_coverage::entry const& entry) {
+			return strings.is_valid(entry.name) &&
+			       strings.is_valid(entry.demangled_name) &&
+			       (entry.start.line <= entry.end.line) &&
+			       ((entry.start.line != entry.end.line) ||
+			        (entry.start.column <= entry.end.column));
+		}
+
+		ref_ptr<counted> load_functions(v1::function_coverage const& header,
+		                                read_stream& in) {
+			if (!in.skip((header.strings.offset * sizeof(uint32_t)) -
+			             sizeof(header))) {
+				return {};
+			}
+			strings_view strings{};
+			if (!strings.load_from(in, header.strings)) {
+				return {};
+			}
+
+			if (!in.skip((header.entries.offset -
+			              (header.strings.offset + header.strings.size)) *
+			             sizeof(uint32_t))) {
+				return {};
+			}
+
+			cov::function_coverage::builder builder{};
+			std::vector<std::byte> buffer{};
+
+			auto const entry_size = header.entries.size * sizeof(uint32_t);
+			for (uint32_t index = 0; index < header.entries.count; ++index) {
+				if (!in.load(buffer, entry_size)) {
+					return {};
+				}
+				auto const& entry =
+				    *reinterpret_cast<v1::function_coverage::entry const*>(
+				        buffer.data());
+
+				if (!entry_valid(strings, entry)) {
+					return {};
+				}
+
+				builder.add(strings.at(entry.name),
+				            strings.at(entry.demangled_name), entry.count,
+				            entry.start, entry.end);
+			}
+
+			return builder.extract();
+		}
+
+		// same as load_functions, but without copying either the strings,
+		// or the entries
+		ref_ptr<counted> view_functions(v1::function_coverage const& header,
+		                                git::bytes data,
+		                                ref_ptr<counted>&& owner) {
+			auto const strings_offset =
+			    header.strings.offset * sizeof(uint32_t) - sizeof(header);
+			auto const entries_offset =
+			    header.entries.offset * sizeof(uint32_t) - sizeof(header);
+			auto const entry_size = header.entries.size * sizeof(uint32_t);
+
+			strings_ref const strings{data.subview(
+			    strings_offset, header.strings.size * sizeof(uint32_t))};
+			if (!view_as<v1::function_coverage::entry>(data, entries_offset))
+				return {};
+
+			auto result =
+			    make_ref<view_impl>(std::move(owner), header.entries.count);
+
+			for (uint32_t index = 0; index < header.entries.count; ++index) {
+				auto const& entry =
+				    *reinterpret_cast<v1::function_coverage::entry const*>(
+				        data.data() + entries_offset + index * entry_size);
+
+				if (!entry_valid(strings, entry)) {
+					return {};
+				}
+
+				result->add(strings.at(entry.name),
+				            strings.at(entry.demangled_name), entry.count,
+				            entry.start, entry.end);
+			}
+
+			return result;
+		}
+
 		constexpr uint32_t uint_32(size_t value) {
 			return static_cast<uint32_t>(value &
 			                             std::numeric_limits<uint32_t>::max());
@@ -86,48 +199,23 @@ namespace cov::io::handlers {
 			return {};
 		}
 
-		if (!in.skip((header.strings.offset * sizeof(uint32_t)) -
-		             sizeof(header))) {
-			return {};
-		}
-		strings_view strings{};
-		if (!strings.load_from(in, header.strings)) {
-			return {};
-		}
-
-		if (!in.skip((header.entries.offset -
-		              (header.strings.offset + header.strings.size)) *
-		             sizeof(uint32_t))) {
-			return {};
-		}
-
-		cov::function_coverage::builder builder{};
-		std::vector<std::byte> buffer{};
-
-		auto const entry_size = header.entries.size * sizeof(uint32_t);
-		for (uint32_t index = 0; index < header.entries.count; ++index) {
-			if (!in.load(buffer, entry_size)) {
-				return {};
-			}
-			auto const& entry =
-			    *reinterpret_cast<v1::function_coverage::entry const*>(
-			        buffer.data());
-
-			if (!strings.is_valid(entry.name) ||
-			    !strings.is_valid(entry.demangled_name) ||
-			    (entry.start.line > entry.end.line) ||
-			    ((entry.start.line == entry.end.line) &&
-			     (entry.start.column > entry.end.column))) {
-				return {};
+		ref_ptr<counted> result{};
+		git::bytes data{};
+		ref_ptr<counted> owner{};
+		if (in.view(payload_size(header), data, owner)) {
+			// offsets outside of the payload are broken, copying won't help
+			if (!payload_fits(header, data)) return {};
+			result = view_functions(header, data, std::move(owner));
+			if (!result) {
+				bytes_read_stream copy{data};
+				result = load_functions(header, copy);
 			}
-
-			builder.add(strings.at(entry.name),
-			            strings.at(entry.demangled_name), entry.count,
-			            entry.start, entry.end);
+		} else {
+			result = load_functions(header, in);
 		}
 
-		ec.clear();
-		return builder.extract();
+		if (result) ec.clear();
+		return result;
 	}
 
 	bool function_coverage::store(ref_ptr<counted> const& value,
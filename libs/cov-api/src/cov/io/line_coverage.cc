@@ -2,7 +2,9 @@
 // This code is licensed under MIT license (see LICENSE for details)
 
 #include <cov/io/line_coverage.hh>
+#include <cov/io/read_stream.hh>
 #include <cov/io/types.hh>
+#include "object_view.hh"
 
 namespace cov::io::handlers {
 	namespace {
@@ -18,6 +20,21 @@ namespace cov::io::handlers {
 		private:
 			std::vector<v1::coverage> lines_{};
 		};
+
+		struct view_impl : counted_impl<cov::line_coverage> {
+			view_impl(std::span<v1::coverage const> lines,
+			          ref_ptr<counted>&& owner)
+			    : owner_{std::move(owner)}, lines_{lines} {}
+
+			std::span<io::v1::coverage const> coverage()
+			    const noexcept override {
+				return lines_;
+			}
+
+		private:
+			ref_ptr<counted> owner_{};
+			std::span<v1::coverage const> lines_{};
+		};
 	}  // namespace
 
 	ref_ptr<counted> line_coverage::load(uint32_t,
@@ -28,6 +45,22 @@ namespace cov::io::handlers {
 		ec = make_error_code(errc::bad_syntax);
 		uint32_t count{0};
 		if (!in.load(count)) return {};
+
+		git::bytes data{};
+		ref_ptr<counted> owner{};
+		if (in.view(count * sizeof(v1::coverage), data, owner)) {
+			if (auto const lines = view_as<v1::coverage>(data, 0)) {
+				ec.clear();
+				return make_ref<view_impl>(
+				    std::span{lines, count}, std::move(owner));
+			}
+			bytes_read_stream copy{data};
+			std::vector<v1::coverage> result{};
+			if (!copy.load(result, count)) return {};
+			ec.clear();
+			return cov::line_coverage::create(std::move(result));
+		}
+
 		std::vector<v1::coverage> result{};
 		if (!in.load(result, count)) return {};
 		ec.clear();
@@ -0,0 +1,92 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cov/git2/bytes.hh>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace cov::io {
+	// Single allocation for all the entries of a viewed object. Object
+	// interfaces hand out the entries as std::unique_ptr<Base>, so Entry
+	// must declare a no-op operator delete; the memory is released here.
+	template <typename Entry, typename Base>
+	class entry_arena {
+	public:
+		explicit entry_arena(size_t capacity)
+		    : storage_{std::allocator<Entry>{}.allocate(capacity)}
+		    , capacity_{capacity} {
+			entries_.reserve(capacity);
+		}
+		~entry_arena() {
+			entries_.clear();
+			std::allocator<Entry>{}.deallocate(storage_, capacity_);
+		}
+		entry_arena(entry_arena const&) = delete;
+		entry_arena& operator=(entry_arena const&) = delete;
+
+		template <typename... Args>
+		void emplace(Args&&... args) {
+			auto const ptr = new (storage_ + entries_.size())
+			    Entry(std::forward<Args>(args)...);
+			entries_.emplace_back(ptr);
+		}
+
+		std::span<std::unique_ptr<Base> const> entries() const noexcept {
+			return entries_;
+		}
+
+	private:
+		Entry* storage_{};
+		size_t capacity_{};
+		std::vector<std::unique_ptr<Base>> entries_{};
+	};
+
+	// number of bytes following the header up to the end of last entry
+	template <typename Header>
+	inline size_t payload_size(Header const& header) noexcept {
+		auto const end =
+		    (std::uint64_t{header.entries.offset} +
+		     std::uint64_t{header.entries.size} * header.entries.count) *
+		    sizeof(std::uint32_t);
+		if (end > std::numeric_limits<size_t>::max())
+			return std::numeric_limits<size_t>::max();
+		return static_cast<size_t>(end) - sizeof(Header);
+	}
+
+	// true, if both the strings and all the entries lie inside the payload;
+	// payload_size() could have wrapped around for a broken header
+	template <typename Header>
+	inline bool payload_fits(Header const& header, git::bytes data) noexcept {
+		static constexpr std::uint64_t u32_size = sizeof(std::uint32_t);
+		auto const size = std::uint64_t{data.size()} + sizeof(Header);
+
+		auto const strings_start = header.strings.offset * u32_size;
+		auto const strings_end =
+		    strings_start + std::uint64_t{header.strings.size} * u32_size;
+		if (strings_start < sizeof(Header) || strings_end > size)
+			return false;
+
+		auto const entries_start = header.entries.offset * u32_size;
+		if (entries_start < sizeof(Header)) return false;
+		// both are 32-bit, so the product cannot overflow
+		auto const entries_u32s =
+		    std::uint64_t{header.entries.size} * header.entries.count;
+		if (entries_u32s > size / u32_size) return false;
+		return entries_start + entries_u32s * u32_size <= size;
+	}
+
+	template <typename Type>
+	inline Type const* view_as(git::bytes data, size_t offset) noexcept {
+		auto const ptr = data.data() + offset;
+		if (reinterpret_cast<std::uintptr_t>(ptr) % alignof(Type))
+			return nullptr;
+		return reinterpret_cast<Type const*>(ptr);
+	}
+}  // namespace cov::io
@@ -0,0 +1,429 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cov/hash/sha1.hh>
+#include <cov/io/file.hh>
+#include <cov/io/pack.hh>
+#include <cov/zstream.hh>
+#include <cstring>
+#include <numeric>
+#include "../path-utils.hh"
+
+namespace cov::io {
+	namespace {
+		constexpr auto pack_prefix = "pack-"sv;
+		constexpr auto pack_ext = ".pack"sv;
+		constexpr auto index_ext = ".idx"sv;
+
+		constexpr auto index_header_size =
+		    sizeof(file_header) + sizeof(v1::pack_index);
+
+		bool is_hex(std::string_view chars) {
+			for (auto c : chars) {
+				if (!std::isxdigit(static_cast<unsigned char>(c))) return false;
+			}
+			return true;
+		}
+
+		template <typename Type>
+		Type const* at(std::vector<std::byte> const& data, size_t offset) {
+			return reinterpret_cast<Type const*>(data.data() + offset);
+		}
+
+		bool oid_less(git_oid const& lhs, git_oid const& rhs) noexcept {
+			return git_oid_cmp(&lhs, &rhs) < 0;
+		}
+
+		std::error_code io_error() {
+			return std::make_error_code(std::errc::io_error);
+		}
+
+		std::uint32_t flags_for(pack_storage storage) noexcept {
+			return storage == pack_storage::uncompressed
+			           ? v1::pack_entry::uncompressed
+			           : 0u;
+		}
+
+		bool stored_as(pack_file const& pack, std::uint32_t flags) noexcept {
+			for (size_t index = 0; index < pack.size(); ++index) {
+				if ((pack.entry_at(index).flags &
+				     v1::pack_entry::uncompressed) != flags)
+					return false;
+			}
+			return true;
+		}
+
+		bool add_as(pack_writer& writer,
+		            git::oid_view id,
+		            git::bytes stored,
+		            std::uint32_t stored_flags,
+		            std::uint32_t flags) {
+			if (stored.empty()) return false;
+			if (stored_flags == flags) return writer.add(id, stored, flags);
+
+			buffer_zstream z{(flags & v1::pack_entry::uncompressed)
+			                     ? zstream::inflate
+			                     : zstream::deflate};
+			if (z.append(stored) != stored.size()) return false;
+			auto const converted = z.close();
+			return writer.add(id, converted.bytes(), flags);
+		}
+	}  // namespace
+
+	pack_file pack_file::open(std::filesystem::path const& index_path) {
+		pack_file result{};
+		{
+			auto const in = io::fopen(index_path, "rb");
+			if (!in) return {};
+			result.index_ = in.read();
+		}
+
+		auto const& data = result.index_;
+		if (data.size() < index_header_size) return {};
+
+		auto const& hdr = *at<file_header>(data, 0);
+		uint32_t const version = v1::VERSION;
+		if (hdr.magic != static_cast<std::uint32_t>(PACK::INDEX) ||
+		    (hdr.version & VERSION_MAJOR) != (version & VERSION_MAJOR))
+			return {};
+
+		auto const fanout =
+		    at<v1::pack_index>(data, sizeof(file_header))->fanout;
+		for (size_t index = 1; index < std::size(v1::pack_index{}.fanout);
+		     ++index) {
+			if (fanout[index] < fanout[index - 1]) return {};
+		}
+
+		auto const count = size_t{fanout[255]};
+		auto const ids_size = count * sizeof(git_oid);
+		auto const entries_size = count * sizeof(v1::pack_entry);
+		if (data.size() != index_header_size + ids_size + entries_size)
+			return {};
+
+		result.count_ = count;
+		result.index_path_ = index_path;
+		result.pack_path_ = index_path;
+		result.pack_path_.replace_extension(pack_ext);
+
+		result.data_ = shared_bytes::map(result.pack_path_);
+		if (!result.data_) return {};
+		auto const pack = result.data_->data();
+		if (pack.size() < sizeof(file_header)) return {};
+		auto const& pack_hdr =
+		    *reinterpret_cast<file_header const*>(pack.data());
+		if (pack_hdr.magic != static_cast<std::uint32_t>(PACK::DATA) ||
+		    (pack_hdr.version & VERSION_MAJOR) != (version & VERSION_MAJOR))
+			return {};
+
+		return result;
+	}
+
+	std::uint32_t const* pack_file::fanout() const noexcept {
+		return at<v1::pack_index>(index_, sizeof(file_header))->fanout;
+	}
+
+	git_oid const* pack_file::ids() const noexcept {
+		return at<git_oid>(index_, index_header_size);
+	}
+
+	v1::pack_entry const* pack_file::entries() const noexcept {
+		return at<v1::pack_entry>(index_,
+		                          index_header_size + count_ * sizeof(git_oid));
+	}
+
+	std::optional<size_t> pack_file::find(git::oid_view id) const noexcept {
+		if (!count_) return std::nullopt;
+
+		auto const ids = this->ids();
+		auto const fanout = this->fanout();
+		auto const first = id.ref->id[0];
+		auto const begin = ids + (first ? fanout[first - 1] : 0);
+		auto const end = ids + fanout[first];
+		auto const it = std::lower_bound(begin, end, *id.ref, oid_less);
+		if (it == end || git_oid_cmp(it, id.ref)) return std::nullopt;
+		return static_cast<size_t>(it - ids);
+	}
+
+	size_t pack_file::find_prefix(git::oid_view prefix,
+	                              size_t character_count,
+	                              size_t& index) const noexcept {
+		if (!count_) return 0;
+
+		// prefix is expected to be at least GIT_OID_MINPREFIXLEN long, so
+		// the first byte is always known here
+		auto const ids = this->ids();
+		auto const fanout = this->fanout();
+		auto const first = prefix.ref->id[0];
+		auto const begin = ids + (first ? fanout[first - 1] : 0);
+		auto const end = ids + fanout[first];
+
+		size_t found{};
+		for (auto it = std::lower_bound(begin, end, *prefix.ref, oid_less);
+		     it != end && found < 2; ++it) {
+			if (git_oid_ncmp(it, prefix.ref, character_count)) break;
+			if (!found) index = static_cast<size_t>(it - ids);
+			++found;
+		}
+		return found;
+	}
+
+	git::bytes pack_file::stored(size_t index) const noexcept {
+		if (index >= count_ || !data_) return {};
+		auto const& entry = entry_at(index);
+		if (entry.flags & ~v1::pack_entry::known_flags) return {};
+
+		auto const pack = data_->data();
+		auto const offset = entry.offset();
+		if (offset > pack.size() || entry.size > pack.size() - offset)
+			return {};
+		return pack.subview(static_cast<size_t>(offset), entry.size);
+	}
+
+	pack_writer::pack_writer(std::filesystem::path const& pack_dir)
+	    : pack_dir_{pack_dir}
+	    , out_{pack_dir / fmt::format("pack{}", pack_ext)} {
+		if (!out_.opened()) return;
+		file_header const hdr{
+		    .magic = static_cast<std::uint32_t>(PACK::DATA),
+		    .version = v1::VERSION,
+		};
+		if (!out_.store(hdr)) {
+			out_.rollback();
+			return;
+		}
+		offset_ = sizeof(hdr);
+	}
+
+	pack_writer::~pack_writer() {
+		if (opened()) rollback();
+	}
+
+	bool pack_writer::contains(git::oid_view id) const noexcept {
+		return known_.contains(id.oid());
+	}
+
+	bool pack_writer::add(git::oid_view id,
+	                      git::bytes raw,
+	                      std::uint32_t flags) {
+		if (!opened()) return false;
+		if (contains(id)) return true;
+		if (raw.size() > std::numeric_limits<std::uint32_t>::max())
+			return false;
+
+		if (flags & v1::pack_entry::uncompressed) {
+			static constexpr std::byte padding[8]{};
+			auto const length = (sizeof(padding) - offset_ % sizeof(padding)) %
+			                    sizeof(padding);
+			if (!out_.store(git::bytes{padding, length})) return false;
+			offset_ += length;
+		}
+
+		if (!out_.store(raw)) return false;
+		entries_.push_back({.id = id.oid(),
+		                    .offset = offset_,
+		                    .size = static_cast<std::uint32_t>(raw.size()),
+		                    .flags = flags});
+		known_.insert(id.oid());
+		offset_ += raw.size();
+		return true;
+	}
+
+	std::filesystem::path pack_writer::commit(std::error_code& ec) {
+		if (!opened()) {
+			ec = io_error();
+			return {};
+		}
+
+		std::sort(entries_.begin(), entries_.end(),
+		          [](entry const& lhs, entry const& rhs) {
+			          return oid_less{}(lhs.id, rhs.id);
+		          });
+
+		v1::pack_index index{};
+		hash::sha1 name_hash{};
+		for (auto const& entry : entries_) {
+			++index.fanout[entry.id.id.id[0]];
+			name_hash.update({entry.id.id.id, GIT_OID_RAWSZ});
+		}
+		std::partial_sum(std::begin(index.fanout), std::end(index.fanout),
+		                 std::begin(index.fanout));
+
+		auto const digest = name_hash.finalize();
+		git::oid name{};
+		static_assert(sizeof(digest.data) == sizeof(name.id.id),
+		              "git::oid and sha1 digest sizes are mismatched");
+		std::memcpy(name.id.id, digest.data, sizeof(digest.data));
+
+		auto const stem = fmt::format("{}{}", pack_prefix, name.str());
+		auto const pack_path = pack_dir_ / fmt::format("{}{}", stem, pack_ext);
+		auto const index_path =
+		    pack_dir_ / fmt::format("{}{}", stem, index_ext);
+
+		ec = out_.commit_as(pack_path);
+		if (ec) return {};
+
+		safe_stream out{index_path};
+		auto ok = out.opened();
+		if (ok) {
+			file_header const hdr{
+			    .magic = static_cast<std::uint32_t>(PACK::INDEX),
+			    .version = v1::VERSION,
+			};
+			ok = out.store(hdr) && out.store(index);
+		}
+		for (auto const& entry : entries_) {
+			if (!ok) break;
+			ok = out.store(entry.id.id);
+		}
+		for (auto const& entry : entries_) {
+			if (!ok) break;
+			auto const offset = entry.offset;
+			ok = out.store(v1::pack_entry{
+			    .offset_hi =
+			        static_cast<std::uint32_t>((offset >> 32) & 0xFFFF'FFFF),
+			    .offset_lo = static_cast<std::uint32_t>(offset & 0xFFFF'FFFF),
+			    .size = entry.size,
+			    .flags = entry.flags,
+			});
+		}
+
+		if (ok) ec = out.commit();
+		if (!ok || ec) {
+			if (!ec) ec = io_error();
+			if (out.opened()) out.rollback();
+			std::error_code ignore{};
+			std::filesystem::remove(pack_path, ignore);
+			return {};
+		}
+
+		return index_path;
+	}
+
+	void pack_writer::rollback() {
+		if (out_.opened()) out_.rollback();
+		entries_.clear();
+		known_.clear();
+	}
+
+	std::vector<std::filesystem::path> pack_indices(
+	    std::filesystem::path const& pack_dir) {
+		std::vector<std::filesystem::path> indices{};
+
+		std::error_code ec{};
+		for (auto const& entry :
+		     std::filesystem::directory_iterator{pack_dir, ec}) {
+			auto const filename = get_path(entry.path().filename());
+			if (!filename.starts_with(pack_prefix) ||
+			    !filename.ends_with(index_ext))
+				continue;
+			indices.push_back(entry.path());
+		}
+		std::sort(indices.begin(), indices.end());
+		return indices;
+	}
+
+	std::vector<pack_file> open_packs(std::filesystem::path const& pack_dir) {
+		auto const indices = pack_indices(pack_dir);
+
+		std::vector<pack_file> result{};
+		result.reserve(indices.size());
+		for (auto const& path : indices) {
+			auto pack = pack_file::open(path);
+			if (pack) result.push_back(std::move(pack));
+		}
+		return result;
+	}
+
+	repack_stats repack(std::filesystem::path const& loose_dir,
+	                    std::filesystem::path const& pack_dir,
+	                    pack_storage storage,
+	                    std::error_code& ec) {
+		auto packs = open_packs(pack_dir);
+		auto const flags = flags_for(storage);
+
+		std::vector<std::pair<git::oid, std::filesystem::path>> loose{};
+		std::error_code ignore{};
+		for (auto const& dir_entry :
+		     std::filesystem::directory_iterator{loose_dir, ignore}) {
+			auto const dirname = get_path(dir_entry.path().filename());
+			if (dirname.size() != 2 || !is_hex(dirname) ||
+			    !dir_entry.is_directory(ignore))
+				continue;
+
+			for (auto const& file_entry :
+			     std::filesystem::directory_iterator{dir_entry.path(),
+			                                         ignore}) {
+				// this will also skip all the unfinished object_tmp files
+				auto const filename = get_path(file_entry.path().filename());
+				if (filename.size() != GIT_OID_HEXSZ - 2 || !is_hex(filename))
+					continue;
+				loose.push_back(
+				    {git::oid::from(fmt::format("{}{}", dirname, filename)),
+				     file_entry.path()});
+			}
+		}
+
+		if (loose.empty() &&
+		    (packs.empty() ||
+		     (packs.size() == 1 && stored_as(packs.front(), flags))))
+			return {};
+
+		pack_writer writer{pack_dir};
+		for (auto const& pack : packs) {
+			for (size_t index = 0; index < pack.size(); ++index) {
+				if (!add_as(writer, pack.id_at(index), pack.stored(index),
+				            pack.entry_at(index).flags, flags)) {
+					ec = io_error();
+					return {};
+				}
+			}
+		}
+
+		// only the objects, which made it to the new pack, can be removed
+		// after the commit; the rest stays loose for the next repack
+		std::vector<std::filesystem::path> packed_loose{};
+		packed_loose.reserve(loose.size());
+		for (auto const& [id, path] : loose) {
+			auto const in = io::fopen(path, "rb");
+			if (!in) continue;
+			auto const raw = in.read();
+			if (!add_as(writer, id, {raw.data(), raw.size()}, 0, flags)) {
+				ec = io_error();
+				return {};
+			}
+			packed_loose.push_back(path);
+		}
+
+		repack_stats stats{.packed_objects = writer.size()};
+		std::vector<std::pair<std::filesystem::path, std::filesystem::path>>
+		    old_packs{};
+		old_packs.reserve(packs.size());
+		for (auto const& pack : packs) {
+			old_packs.push_back({pack.index_path(), pack.pack_path()});
+		}
+		// some systems would not remove (or overwrite) a mapped file
+		packs.clear();
+
+		auto const index_path = writer.commit(ec);
+		if (ec) return {};
+
+		for (auto const& [old_index, old_pack] : old_packs) {
+			// same set of objects will produce the same name
+			if (old_index == index_path) continue;
+			std::filesystem::remove(old_index, ignore);
+			std::filesystem::remove(old_pack, ignore);
+			++stats.removed_packs;
+		}
+
+		for (auto const& path : packed_loose) {
+			std::filesystem::remove(path, ignore);
+			// will only succeed for the last object in the directory
+			std::filesystem::remove(path.parent_path(), ignore);
+			++stats.loose_objects;
+		}
+
+		return stats;
+	}
+}  // namespace cov::io
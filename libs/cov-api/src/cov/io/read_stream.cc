@@ -19,6 +19,17 @@ namespace cov::io {
 		return true;
 	}
 
+	bool bytes_read_stream::view(size_t length,
+	                             git::bytes& data,
+	                             ref_ptr<counted>& owner) {
+		if (!owner_ || length > in_.size()) return false;
+
+		data = in_.subview(0, length);
+		owner = owner_.duplicate();
+		in_ = in_.subview(length);
+		return true;
+	}
+
 	size_t bytes_read_stream::read(void* ptr, size_t length) {
 		auto const chunk = std::min(length, in_.size());
 		if (chunk) std::memcpy(ptr, in_.data(), chunk);
@@ -0,0 +1,194 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <algorithm>
+#include <cov/io/report_graph.hh>
+#include <cov/io/safe_stream.hh>
+#include <numeric>
+
+namespace cov::io {
+	namespace {
+		constexpr auto header_size =
+		    sizeof(file_header) + sizeof(v1::graph_index);
+		constexpr auto record_size = sizeof(git_oid) + sizeof(v1::graph_entry);
+
+		template <typename Type>
+		Type const* at(git::bytes data, size_t offset) {
+			return reinterpret_cast<Type const*>(data.data() + offset);
+		}
+
+		template <typename Type>
+		void append(std::vector<std::byte>& out, Type const& value) {
+			auto const bytes = reinterpret_cast<std::byte const*>(&value);
+			out.insert(out.end(), bytes, bytes + sizeof(value));
+		}
+
+		bool oid_less(git_oid const& lhs, git_oid const& rhs) noexcept {
+			return git_oid_cmp(&lhs, &rhs) < 0;
+		}
+
+		// either an entry of the current graph, or a newly added node
+		struct slot {
+			git_oid const* id{};
+			size_t index{};
+			report_graph::node const* added{};
+		};
+	}  // namespace
+
+	report_graph report_graph::open(std::filesystem::path const& path) {
+		std::error_code ec{};
+		if (!std::filesystem::is_regular_file(path, ec)) return {};
+
+		auto data = shared_bytes::map(path);
+		if (!data) return {};
+
+		auto const bytes = data->data();
+		if (bytes.size() < header_size) return {};
+
+		auto const& hdr = *at<file_header>(bytes, 0);
+		uint32_t const version = v1::VERSION;
+		if (hdr.magic != static_cast<std::uint32_t>(GRAPH::REPORTS) ||
+		    (hdr.version & VERSION_MAJOR) != (version & VERSION_MAJOR))
+			return {};
+
+		auto const fanout =
+		    at<v1::graph_index>(bytes, sizeof(file_header))->fanout;
+		for (size_t index = 1; index < std::size(v1::graph_index{}.fanout);
+		     ++index) {
+			if (fanout[index] < fanout[index - 1]) return {};
+		}
+
+		auto const count = size_t{fanout[255]};
+		if (bytes.size() != header_size + count * record_size) return {};
+
+		report_graph result{};
+		result.data_ = std::move(data);
+		result.count_ = count;
+		return result;
+	}
+
+	std::uint32_t const* report_graph::fanout() const noexcept {
+		return at<v1::graph_index>(data_->data(), sizeof(file_header))->fanout;
+	}
+
+	git_oid const* report_graph::ids() const noexcept {
+		return at<git_oid>(data_->data(), header_size);
+	}
+
+	v1::graph_entry const* report_graph::entries() const noexcept {
+		return at<v1::graph_entry>(data_->data(),
+		                           header_size + count_ * sizeof(git_oid));
+	}
+
+	std::optional<size_t> report_graph::find(
+	    git::oid_view id) const noexcept {
+		if (!count_) return std::nullopt;
+
+		auto const ids = this->ids();
+		auto const fanout = this->fanout();
+		auto const first = id.ref->id[0];
+		auto const begin = ids + (first ? fanout[first - 1] : 0);
+		auto const end = ids + fanout[first];
+		auto const it = std::lower_bound(begin, end, *id.ref, oid_less);
+		if (it == end || git_oid_cmp(it, id.ref)) return std::nullopt;
+		return static_cast<size_t>(it - ids);
+	}
+
+	std::optional<size_t> report_graph::parent_of(
+	    size_t index) const noexcept {
+		auto const parent = entry_at(index).parent;
+		if (parent >= count_) return std::nullopt;
+		return parent;
+	}
+
+	std::vector<std::byte> report_graph::merged(
+	    std::span<node const> added) const {
+		std::vector<slot> slots{};
+		slots.reserve(count_ + added.size());
+		for (size_t index = 0; index < count_; ++index)
+			slots.push_back({.id = &id_at(index), .index = index});
+		for (auto const& item : added) {
+			if (find(item.id)) continue;
+			slots.push_back({.id = &item.id.id, .added = &item});
+		}
+
+		// current entries come first, so they win over the same ids added
+		// once more
+		std::stable_sort(slots.begin(), slots.end(),
+		                 [](slot const& lhs, slot const& rhs) {
+			                 return oid_less(*lhs.id, *rhs.id);
+		                 });
+		slots.erase(std::unique(slots.begin(), slots.end(),
+		                        [](slot const& lhs, slot const& rhs) {
+			                        return !git_oid_cmp(lhs.id, rhs.id);
+		                        }),
+		            slots.end());
+		if (slots.size() >= v1::graph_entry::outside) return {};
+
+		std::vector<std::uint32_t> moved_to(count_);
+		v1::graph_index index{};
+		for (size_t pos = 0; pos < slots.size(); ++pos) {
+			auto const& item = slots[pos];
+			++index.fanout[item.id->id[0]];
+			if (!item.added)
+				moved_to[item.index] = static_cast<std::uint32_t>(pos);
+		}
+		std::partial_sum(std::begin(index.fanout), std::end(index.fanout),
+		                 std::begin(index.fanout));
+
+		auto const parent_index = [&slots](git::oid const& parent) {
+			if (parent.is_zero()) return v1::graph_entry::no_parent;
+			auto const it = std::lower_bound(
+			    slots.begin(), slots.end(), parent.id,
+			    [](slot const& item, git_oid const& id) {
+				    return oid_less(*item.id, id);
+			    });
+			if (it == slots.end() || git_oid_cmp(it->id, &parent.id))
+				return v1::graph_entry::outside;
+			return static_cast<std::uint32_t>(it - slots.begin());
+		};
+
+		std::vector<std::byte> result{};
+		result.reserve(header_size + slots.size() * record_size);
+		append(result, file_header{
+		                   .magic = static_cast<std::uint32_t>(GRAPH::REPORTS),
+		                   .version = v1::VERSION,
+		               });
+		append(result, index);
+		for (auto const& item : slots)
+			append(result, *item.id);
+
+		for (auto const& item : slots) {
+			if (!item.added) {
+				auto entry = entry_at(item.index);
+				if (entry.parent < count_)
+					entry.parent = moved_to[entry.parent];
+				append(result, entry);
+				continue;
+			}
+
+			auto const& node = *item.added;
+			v1::graph_entry entry{
+			    .parent = parent_index(node.parent),
+			    .commit = {},
+			    .added = {},
+			    .stats = node.stats,
+			};
+			entry.commit = node.commit_time;
+			entry.added = node.add_time;
+			append(result, entry);
+		}
+
+		return result;
+	}
+
+	std::error_code report_graph::store(std::filesystem::path const& path,
+	                                    git::bytes contents) {
+		safe_stream out{path};
+		if (!out.opened() || !out.store(contents)) {
+			if (out.opened()) out.rollback();
+			return std::make_error_code(std::errc::io_error);
+		}
+		return out.commit();
+	}
+}  // namespace cov::io
@@ -71,10 +71,13 @@ namespace cov::io {
 
 	bool safe_stream::opened() const noexcept { return !!out_; }
 
-	std::error_code safe_stream::commit() {
+	std::error_code safe_stream::commit() { return commit_as(path_); }
+
+	std::error_code safe_stream::commit_as(
+	    std::filesystem::path const& filename) {
 		out_.close();
 		std::error_code ec;
-		rename(tmp_filename_, path_, ec);
+		rename(tmp_filename_, filename, ec);
 		return ec;
 	}
 
@@ -0,0 +1,119 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <cov/io/file.hh>
+#include <cov/io/shared_bytes.hh>
+
+#if defined WIN32 || defined _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else  // WIN32 || _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cov::io {
+	namespace {
+		class buffer_bytes : public counted_impl<shared_bytes> {
+		public:
+			explicit buffer_bytes(std::vector<std::byte>&& buffer)
+			    : buffer_{std::move(buffer)} {}
+
+			git::bytes data() const noexcept override {
+				return {buffer_.data(), buffer_.size()};
+			}
+
+		private:
+			std::vector<std::byte> buffer_{};
+		};
+
+		class mapped_bytes : public counted_impl<shared_bytes> {
+		public:
+			mapped_bytes(void const* data, size_t size)
+			    : data_{data}, size_{size} {}
+			~mapped_bytes();
+
+			git::bytes data() const noexcept override {
+				return {static_cast<std::byte const*>(data_), size_};
+			}
+
+		private:
+			void const* data_{};
+			size_t size_{};
+		};
+
+#if defined WIN32 || defined _WIN32
+		mapped_bytes::~mapped_bytes() { UnmapViewOfFile(data_); }
+
+		ref_ptr<shared_bytes> map_file(std::filesystem::path const& path) {
+			auto const file = CreateFileW(
+			    path.native().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) return {};
+
+			LARGE_INTEGER size{};
+			if (!GetFileSizeEx(file, &size) || !size.QuadPart) {
+				CloseHandle(file);
+				return {};
+			}
+
+			auto const mapping =
+			    CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+			if (!mapping) return {};
+
+			auto const data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+			if (!data) return {};
+
+			return make_ref<mapped_bytes>(
+			    data, static_cast<size_t>(size.QuadPart));
+		}
+#else   // WIN32 || _WIN32
+		mapped_bytes::~mapped_bytes() {
+			munmap(const_cast<void*>(data_), size_);
+		}
+
+		ref_ptr<shared_bytes> map_file(std::filesystem::path const& path) {
+			auto const fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0) return {};
+
+			struct stat st {};
+			if (fstat(fd, &st) || !st.st_size) {
+				::close(fd);
+				return {};
+			}
+
+			auto const size = static_cast<size_t>(st.st_size);
+			auto const data =
+			    mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (data == MAP_FAILED) return {};
+
+			return make_ref<mapped_bytes>(data, size);
+		}
+#endif  // WIN32 || _WIN32
+	}   // namespace
+
+	ref_ptr<shared_bytes> shared_bytes::map(
+	    std::filesystem::path const& path) {
+		if (auto mapped = map_file(path)) return mapped;
+
+		// empty files cannot be mapped and some filesystems do not support
+		// mapping at all; reading the whole file is still an answer
+		auto const in = io::fopen(path, "rb");
+		if (!in) return {};
+		return wrap(in.read());
+	}
+
+	ref_ptr<shared_bytes> shared_bytes::wrap(std::vector<std::byte>&& buffer) {
+		return make_ref<buffer_bytes>(std::move(buffer));
+	}
+}  // namespace cov::io
@@ -4,7 +4,9 @@
 #include <cov/git2/blob.hh>
 #include <cov/git2/commit.hh>
 #include <cov/module.hh>
+#include <algorithm>
 #include <cov/repository.hh>
+#include <iterator>
 #include <map>
 #include <unordered_set>
 #include "path-utils.hh"
@@ -63,17 +65,13 @@ namespace cov {
 					(*it++).name = mod.name;
 				}
 
+				module_matcher const matcher{entries_};
 				for (auto const& file : files) {
 					auto const ptr = conv(file);
-					auto const filename = ptr->path();
-					auto found = false;
-					for (auto it = result.begin(); auto const& mod : entries_) {
-						auto& view = *it++;
-						if (!contains(mod.prefixes, filename)) continue;
-						view.items.push_back(ptr);
-						found = true;
-					}
-					if (!found) result.back().items.push_back(ptr);
+					auto const owners = matcher.containing(ptr->path());
+					for (auto const index : owners)
+						result[index].items.push_back(ptr);
+					if (owners.empty()) result.back().items.push_back(ptr);
 				}
 
 				std::erase_if(result, [](auto const& view) {
@@ -202,27 +200,102 @@ namespace cov {
 			}
 
 		private:
-			static bool contains(std::vector<std::string> const& prefixes,
-			                     std::string_view path) {
-				for (auto const& pre : prefixes) {
-					if (contains(pre, path)) return true;
+			std::string separator_;
+			std::vector<module_info> entries_;
+		};
+	}  // namespace
+
+	module_matcher::module_matcher(std::vector<module_info> const& mods) {
+		nodes_.emplace_back();  // root
+		for (size_t index = 0; index < mods.size(); ++index) {
+			for (std::string_view prefix : mods[index].prefixes) {
+				auto const slash = prefix.ends_with('/');
+				if (slash) prefix = prefix.substr(0, prefix.length() - 1);
+
+				size_t current = 0;
+				while (true) {
+					auto const pos = prefix.find('/');
+					auto const segment = prefix.substr(0, pos);
+
+					auto it = nodes_[current].children.find(segment);
+					if (it == nodes_[current].children.end()) {
+						it = nodes_[current]
+						         .children.emplace(segment, nodes_.size())
+						         .first;
+						nodes_.emplace_back();
+					}
+					current = it->second;
+
+					if (pos == std::string_view::npos) break;
+					prefix = prefix.substr(pos + 1);
 				}
-				return false;
+
+				auto& node = nodes_[current];
+				(slash ? node.below : node.exact).push_back(index);
 			}
+		}
 
-			static bool contains(std::string_view prefix,
-			                     std::string_view path) {
-				if (prefix.size() > path.size()) return false;
-				if (prefix.size() == path.size()) return prefix == path;
-				if (!path.starts_with(prefix)) return false;
-				return (!prefix.empty() && prefix.back() == '/') ||
-				       (path[prefix.size()] == '/');
+		for (auto& node : nodes_) {
+			for (auto* indices : {&node.exact, &node.below}) {
+				std::sort(indices->begin(), indices->end());
+				indices->erase(std::unique(indices->begin(), indices->end()),
+				               indices->end());
 			}
+		}
+	}
 
-			std::string separator_;
-			std::vector<module_info> entries_;
-		};
-	}  // namespace
+	template <typename Callback>
+	void module_matcher::walk(std::string_view path,
+	                          Callback&& callback) const {
+		size_t current = 0;
+		size_t length = 0;
+		while (true) {
+			auto const pos = path.find('/', length);
+			auto const segment = path.substr(
+			    length, pos == std::string_view::npos ? pos : pos - length);
+
+			auto const& children = nodes_[current].children;
+			auto const it = children.find(segment);
+			if (it == children.end()) return;
+			current = it->second;
+
+			auto const at_end = pos == std::string_view::npos;
+			length = at_end ? path.length() : pos;
+			callback(nodes_[current], length, at_end);
+
+			if (at_end) return;
+			++length;
+		}
+	}
+
+	std::vector<size_t> module_matcher::containing(
+	    std::string_view path) const {
+		std::vector<size_t> result{};
+		walk(path, [&](node const& dir, size_t, bool at_end) {
+			result.insert(result.end(), dir.exact.begin(), dir.exact.end());
+			if (!at_end)
+				result.insert(result.end(), dir.below.begin(), dir.below.end());
+		});
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return result;
+	}
+
+	std::vector<size_t> module_matcher::closest(std::string_view path) const {
+		node const* found = nullptr;
+		walk(path, [&](node const& dir, size_t length, bool) {
+			if (length && (!dir.exact.empty() || !dir.below.empty()))
+				found = &dir;
+		});
+
+		std::vector<size_t> result{};
+		if (!found) return result;
+
+		std::set_union(found->exact.begin(), found->exact.end(),
+		               found->below.begin(), found->below.end(),
+		               std::back_inserter(result));
+		return result;
+	}
 
 	ref_ptr<modules> modules::make_modules(
 	    std::string const& separator,
@@ -0,0 +1,149 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <cov/object_cache.hh>
+#include <cov/report.hh>
+#include <cstring>
+
+namespace cov {
+	namespace {
+		// rough size of a heap-allocated object, or an entry, with its
+		// vtable, counter and bookkeeping of the container owning it
+		static constexpr size_t object_overhead = 64;
+		static constexpr size_t entry_overhead = 128;
+
+		size_t cost_of_report(report const& obj) noexcept {
+			size_t result = obj.branch().size() + obj.author_name().size() +
+			                obj.author_email().size() +
+			                obj.committer_name().size() +
+			                obj.committer_email().size() +
+			                obj.message().size();
+			for (auto const& entry : obj.entries()) {
+				result += entry_overhead + entry->props_json().size();
+			}
+			return result;
+		}
+
+		size_t cost_of_files(files const& obj) noexcept {
+			size_t result{};
+			for (auto const& entry : obj.entries()) {
+				result += entry_overhead + entry->path().size();
+			}
+			return result;
+		}
+
+		size_t cost_of_functions(function_coverage const& obj) noexcept {
+			size_t result{};
+			for (auto const& entry : obj.entries()) {
+				result += entry_overhead + entry->name().size() +
+				          entry->demangled_name().size();
+			}
+			return result;
+		}
+	}  // namespace
+
+	size_t object_cache::oid_hash::operator()(
+	    git::oid const& id) const noexcept {
+		// object ids are already well distributed
+		size_t result{};
+		static_assert(sizeof(result) <= sizeof(id.id.id));
+		std::memcpy(&result, id.id.id, sizeof(result));
+		return result;
+	}
+
+	ref_ptr<object> object_cache::get(git::oid_view id) {
+		std::lock_guard lock{m_};
+		auto it = index_.find(git::oid{*id.ref});
+		if (it == index_.end()) {
+			++misses_;
+			return {};
+		}
+
+		++hits_;
+		lru_.splice(lru_.begin(), lru_, it->second);
+		return it->second->obj.duplicate();
+	}
+
+	void object_cache::put(git::oid_view id, ref_ptr<object> const& obj) {
+		if (!obj) return;
+		put(id, obj, cost_of(*obj));
+	}
+
+	void object_cache::put(git::oid_view id,
+	                       ref_ptr<object> const& obj,
+	                       size_t cost) {
+		if (!obj) return;
+
+		std::lock_guard lock{m_};
+		// an object bigger than the whole budget would only flush the cache
+		if (cost > budget_) return;
+
+		git::oid key{*id.ref};
+		auto it = index_.find(key);
+		if (it != index_.end()) {
+			bytes_ -= it->second->cost;
+			lru_.erase(it->second);
+			index_.erase(it);
+		}
+
+		lru_.push_front({key, obj.duplicate(), cost});
+		index_[key] = lru_.begin();
+		bytes_ += cost;
+		trim();
+	}
+
+	void object_cache::resize(size_t budget) {
+		std::lock_guard lock{m_};
+		budget_ = budget;
+		trim();
+	}
+
+	void object_cache::clear() {
+		std::lock_guard lock{m_};
+		index_.clear();
+		lru_.clear();
+		bytes_ = 0;
+	}
+
+	object_cache_stats object_cache::stats() const {
+		std::lock_guard lock{m_};
+		return {
+		    .hits = hits_,
+		    .misses = misses_,
+		    .evictions = evictions_,
+		    .objects = lru_.size(),
+		    .bytes = bytes_,
+		    .budget = budget_,
+		};
+	}
+
+	size_t object_cache::cost_of(object const& obj) noexcept {
+		size_t result = object_overhead;
+
+		if (auto const lines = as_a<line_coverage>(obj)) {
+			result += lines->coverage().size_bytes();
+		} else if (auto const branches = as_a<branch_coverage>(obj)) {
+			result += branches->table().size();
+		} else if (auto const list = as_a<files>(obj)) {
+			result += cost_of_files(*list);
+		} else if (auto const functions = as_a<function_coverage>(obj)) {
+			result += cost_of_functions(*functions);
+		} else if (auto const head = as_a<report>(obj)) {
+			result += cost_of_report(*head);
+		} else if (auto const entry = as_a<build>(obj)) {
+			result += entry->props_json().size();
+		}
+
+		return result;
+	}
+
+	void object_cache::trim() {
+		while (bytes_ > budget_ && !lru_.empty()) {
+			auto const& last = lru_.back();
+			bytes_ -= last.cost;
+			index_.erase(last.id);
+			lru_.pop_back();
+			++evictions_;
+		}
+	}
+}  // namespace cov
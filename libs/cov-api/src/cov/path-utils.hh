@@ -31,6 +31,9 @@ namespace cov {
 			constexpr auto objects_dir = "objects"sv;
 			constexpr auto objects_pack_dir = "objects/pack"sv;
 			constexpr auto coverage_dir = "objects/coverage"sv;
+			constexpr auto coverage_pack_dir = "objects/coverage/pack"sv;
+			constexpr auto report_graph =
+			    "objects/coverage/info/report-graph"sv;
 			constexpr auto refs_dir = "refs"sv;
 			constexpr auto heads_dir = "refs/heads"sv;
 			constexpr auto tags_dir = "refs/tags"sv;
@@ -2,46 +2,44 @@
 // This code is licensed under MIT license (see LICENSE for details)
 
 #include <fmt/format.h>
+#include <algorithm>
 #include <cov/module.hh>
 #include <cov/projection.hh>
+#include <optional>
 
 namespace cov::projection {
 	namespace {
 		using namespace std::literals;
 
-		void update_prefixes(std::unordered_set<std::string>& dst,
-		                     std::vector<std::string> const& prefixes) {
-			for (auto const& prefix : prefixes) {
-				if (!prefix.empty() && prefix.ends_with('/')) {
-					dst.insert(prefix.substr(0, prefix.length() - 1));
-				} else {
-					dst.insert(prefix);
-				}
-			}
-		}
+		using indexed_file = report_index::file;
 
-		void clean_modules(
-		    std::map<std::string, std::vector<file_stats const*>>& modules) {
-			auto it = modules.begin();
-			auto end = modules.end();
-			while (it != end) {
-				if (!it->second.empty()) {
-					++it;
-					continue;
-				}
+		struct filename_less {
+			bool operator()(indexed_file const& lhs,
+			                indexed_file const& rhs) const noexcept {
+				return lhs.source->filename < rhs.source->filename;
+			}
+			bool operator()(indexed_file const& lhs,
+			                std::string_view rhs) const noexcept {
+				return lhs.source->filename < rhs;
+			}
+			bool operator()(std::string_view lhs,
+			                indexed_file const& rhs) const noexcept {
+				return lhs < rhs.source->filename;
+			}
+		};
 
-				// GCOV_EXCL_START
-				it = modules.erase(it);
-				end = modules.end();
-				// GCOV_EXCL_STOP
-			}  // GCOV_EXCL_LINE[MSVC]
+		std::vector<file_stats const*> pointers_to(
+		    std::vector<file_stats> const& report) {
+			std::vector<file_stats const*> result{};
+			result.reserve(report.size());
+			for (auto const& file : report)
+				result.push_back(&file);
+			return result;
 		}
 
 		struct dir_entry;
 		dir_entry make_entry(entry_type type, std::string_view display);
-		dir_entry make_file(std::string_view display,
-		                    file_stats const& file,
-		                    repository const* repo);
+		dir_entry make_file(std::string_view display, indexed_file const& file);
 		auto find_entry(std::vector<dir_entry>& children,
 		                entry_type type,
 		                std::string_view display) -> decltype(children.begin());
@@ -66,15 +64,14 @@ namespace cov::projection {
 
 			void add_module(std::string_view module,
 			                std::string_view sep,
-			                std::vector<file_stats const*> const& files,
-			                size_t file_prefix_len,
-			                repository const* repo) {
+			                std::vector<indexed_file const*> const& files,
+			                size_t file_prefix_len) {
 				if (module.empty()) {
 					for (auto file : files) {
-						auto filename = std::string_view{file->filename};
+						std::string_view filename = file->source->filename;
 						if (file_prefix_len < filename.size())
 							filename = filename.substr(file_prefix_len);
-						add_file(filename, *file, repo);
+						add_file(filename, *file);
 					}
 
 					return;
@@ -90,16 +87,14 @@ namespace cov::projection {
 				add_level(entry_type::module, display,
 				          [=, &files](dir_entry& child) {
 					          child.add_module(rest, sep, files,
-					                           file_prefix_len, repo);
+					                           file_prefix_len);
 				          });
 			}
 
-			void add_file(std::string_view filename,
-			              file_stats const& file,
-			              repository const* repo) {
+			void add_file(std::string_view filename, indexed_file const& file) {
 				auto const pos = filename.find('/');
 				if (pos == std::string_view::npos)
-					return children.push_back(make_file(filename, file, repo));
+					return children.push_back(make_file(filename, file));
 
 				auto const display = filename.substr(0, pos);
 				auto const rest = pos == std::string_view::npos
@@ -108,78 +103,10 @@ namespace cov::projection {
 
 				add_level(entry_type::directory, display,
 				          [=, &file](dir_entry& child) {
-					          child.add_file(rest, file, repo);
+					          child.add_file(rest, file);
 				          });
 			}
 
-			void add_files(
-			    std::map<std::string, std::unordered_set<std::string>> const&
-			        modules,
-			    std::unordered_set<std::string> const& filtered_out,
-			    std::vector<file_stats const*>& files,
-			    std::string_view mod_sep,
-			    bool mod_filter_empty,
-			    size_t file_prefix_len,
-			    repository const* repo) {
-				std::map<std::string, std::vector<file_stats const*>>
-				    module_data{};
-
-				for (auto& file : files) {
-					size_t length{};
-					std::string module_name{};
-					bool is_filtered = false;
-					bool found_something = false;
-
-					for (auto const& [modname, dirs] : modules) {
-						for (auto const& dir : dirs) {
-							auto const prefix = prefixed{dir};
-							if (prefix.prefixes(file->filename) &&
-							    length < prefix.prefix.length()) {
-								length = prefix.prefix.length();
-								module_name = modname;
-								found_something = true;
-							}
-						}
-					}
-
-					for (auto const& dir : filtered_out) {
-						auto const prefix = prefixed{dir};
-
-						if (prefix.prefixes(file->filename) &&
-						    length < prefix.prefix.length()) {
-							length = prefix.prefix.length();
-							module_name.clear();
-							is_filtered = true;
-							found_something = true;
-						}
-					}
-
-					if (found_something) {
-						if (!is_filtered) {
-							module_data[module_name].push_back(file);
-						}
-						file = nullptr;
-					}
-				}
-
-				if (mod_filter_empty) {
-					std::vector<file_stats const*> nul_module;
-					for (auto& file : files) {
-						if (!file) continue;
-						nul_module.push_back(file);
-					}
-
-					if (!nul_module.empty())
-						module_data[{}] = std::move(nul_module);
-				}
-
-				clean_modules(module_data);
-
-				for (auto const& [modname, mod_files] : module_data)
-					add_module(modname, mod_sep, mod_files, file_prefix_len,
-					           repo);
-			}
-
 			void propagate(std::string_view sep) {
 				if (result.type != entry_type::file) {
 					result.stats.current = coverage_stats::init();
@@ -245,9 +172,10 @@ namespace cov::projection {
 			}
 		};
 
-		inline bool is_standalone(std::span<cov::file_stats const* const> files,
+		inline bool is_standalone(std::span<indexed_file const* const> files,
 		                          prefixed const& fname) noexcept {
-			return files.size() == 1 && files.front()->filename == fname.filter;
+			return files.size() == 1 &&
+			       files.front()->source->filename == fname.filter;
 		}
 
 		label make_label(std::string_view display) {
@@ -274,9 +202,7 @@ namespace cov::projection {
 			return result;
 		}
 
-		dir_entry make_file(std::string_view display,
-		                    file_stats const& file,
-		                    repository const* repo) {
+		entry_stats stats_of(file_stats const& file, repository const* repo) {
 			auto current = file.current;
 			auto previous = file.previous;
 			if (repo) {
@@ -290,14 +216,16 @@ namespace cov::projection {
 					    *repo, file.previous_functions, previous.functions);
 				}
 			}
+			return {.current{current}, .previous{previous}};
+		}
+
+		dir_entry make_file(std::string_view display,
+		                    indexed_file const& file) {
 			return {.result{.type = entry_type::file,
 			                .name = make_label(display),
-			                .stats{
-			                    .current{current},
-			                    .previous{previous},
-			                },
-			                .previous_name{file.previous_name},
-			                .diff_kind{file.diff_kind}}};
+			                .stats{file.stats},
+			                .previous_name{file.source->previous_name},
+			                .diff_kind{file.source->diff_kind}}};
 		}
 
 		auto find_entry(std::vector<dir_entry>& children,
@@ -312,21 +240,74 @@ namespace cov::projection {
 		}
 	}  // namespace
 
+	report_index::report_index(std::vector<file_stats> const& report,
+	                           struct modules const* mods,
+	                           cov::repository const* repo)
+	    : report_index{pointers_to(report), mods, repo} {}
+
+	report_index::report_index(std::vector<file_stats const*> const& report,
+	                           struct modules const* mods,
+	                           cov::repository const* repo)
+	    : mods_{mods} {
+		std::vector<module_info> const no_modules{};
+		module_matcher const matcher{mods ? mods->entries() : no_modules};
+
+		files_.reserve(report.size());
+		for (auto const* file : report) {
+			files_.push_back({.source = file,
+			                  .stats = stats_of(*file, repo),
+			                  .owners = matcher.closest(file->filename)});
+		}
+		std::stable_sort(files_.begin(), files_.end(), filename_less{});
+	}
+
+	std::vector<report_index::file const*> report_index::files_under(
+	    prefixed const& fname) const {
+		std::vector<file const*> result{};
+
+		if (fname.prefix.empty()) {
+			result.reserve(files_.size());
+			for (auto const& file : files_)
+				result.push_back(&file);
+			return result;
+		}
+
+		auto const [first, last] = std::equal_range(
+		    files_.begin(), files_.end(), fname.filter, filename_less{});
+		for (auto it = first; it != last; ++it)
+			result.push_back(&*it);
+
+		auto it = std::lower_bound(files_.begin(), files_.end(), fname.prefix,
+		                           filename_less{});
+		for (; it != files_.end() &&
+		       it->source->filename.starts_with(fname.prefix);
+		     ++it)
+			result.push_back(&*it);
+
+		return result;
+	}
+
 	std::vector<entry> report_filter::project(
 	    std::vector<file_stats> const& report,
 	    cov::repository const* repo) const {
+		// only the files seen by this filter need their stats
+		return project(report_index{file_projection(report), mods, repo});
+	}
+
+	std::vector<entry> report_filter::project(
+	    report_index const& index) const {
 		std::vector<entry> result{};
 		dir_entry root{.result{.type = entry_type::module}};
 
-		auto files = file_projection(report);
+		auto files = index.files_under(fname);
 
 		auto const was_standalone = is_standalone(files, fname);
 		if (was_standalone) {
-			root.add_file(fname.filter, *files.front(), repo);
+			root.add_file(fname.filter, *files.front());
 		} else {
-			auto [modules, filtered_out] = modules_projection();
-			root.add_files(modules, filtered_out, files, sep,
-			               module.filter.empty(), fname.prefix.size(), repo);
+			for (auto const& [modname, mod_files] :
+			     modules_projection(index, files))
+				root.add_module(modname, sep, mod_files, fname.prefix.size());
 		}
 
 		root.propagate(sep);
@@ -385,29 +366,36 @@ namespace cov::projection {
 		return result;
 	}  // GCOV_EXCL_LINE[GCC]
 
-	std::pair<std::map<std::string, std::unordered_set<std::string>>,
-	          std::unordered_set<std::string>>
-	report_filter::modules_projection() const {
-		std::pair<std::map<std::string, std::unordered_set<std::string>>,
-		          std::unordered_set<std::string>>
-		    results{};
-		if (!mods) return results;
+	report_filter::module_files report_filter::modules_projection(
+	    report_index const& index,
+	    std::vector<report_index::file const*> const& files) const {
+		module_files result{};
+		std::vector<report_index::file const*> nul_module{};
 
-		auto& [modules, filtered_out] = results;
-
-		for (auto const& entry : mods->entries()) {
-			if (!module.prefixes(entry.name)) {
-				update_prefixes(filtered_out, entry.prefixes);
+		for (auto const* file : files) {
+			if (file->owners.empty()) {
+				if (module.filter.empty()) nul_module.push_back(file);
 				continue;
 			}
 
-			auto const pos = entry.name.find(sep, module.prefix.length());
-			auto const name = pos == std::string::npos
-			                      ? entry.name
-			                      : entry.name.substr(0, pos);
-			update_prefixes(modules[name], entry.prefixes);
+			// from all the modules sharing the longest path, the file goes
+			// to the first one seen through this filter; it is filtered out
+			// together with the path, if there are none
+			std::optional<std::string> module_name{};
+			for (auto const owner : file->owners) {
+				auto const& name = index.mods()->entries()[owner].name;
+				if (!module.prefixes(name)) continue;
+
+				auto const pos = name.find(sep, module.prefix.length());
+				auto const level = std::string_view{name}.substr(0, pos);
+				if (!module_name || level < *module_name)
+					module_name.emplace(level);
+			}
+
+			if (module_name) result[*module_name].push_back(file);
 		}
 
-		return results;
-	}  // GCOV_EXCL_LINE[GCC]
+		if (!nul_module.empty()) result[{}] = std::move(nul_module);
+		return result;
+	}
 }  // namespace cov::projection
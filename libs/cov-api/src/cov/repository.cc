@@ -114,7 +114,17 @@ namespace cov {
 			if (!ec) refs_ = references::make_refs(common_dir_, cov_dir_);
 			if (!ec)
 				db_ = backend::loose_backend(common_dir_ / names::coverage_dir);
+			if (!ec)
+				packs_ = backend::pack_backend(common_dir_ /
+				                               names::coverage_pack_dir);
+			if (!ec)
+				cache_ = std::make_unique<object_cache>(
+				    cfg_.get_unsigned("core.cacheSize")
+				        .value_or(object_cache::default_budget));
 			if (!ec) git_.open(common_dir_, cov_dir_, cfg_, ec);
+			if (!ec)
+				graph_ = io::report_graph::open(common_dir_ /
+				                                names::report_graph);
 		}
 	}
 
@@ -177,12 +187,31 @@ namespace cov {
 
 	ref_ptr<object> repository::find_partial(git::oid_view in,
 	                                         size_t character_count) const {
-		return db_->lookup<object>(in, character_count);
+		git::oid loose{}, packed{};
+		auto const in_loose = db_->find_prefix(in, character_count, loose);
+		auto const in_packs = packs_->find_prefix(in, character_count, packed);
+		if (in_loose > 1 || in_packs > 1) return {};
+		// after a repack, the same object could still be kept loose
+		if (in_loose && in_packs && loose != packed) return {};
+
+		if (in_loose) return db_->lookup_object(loose);
+		if (in_packs) return packs_->lookup_object(packed);
+		return {};
 	}
 
 	ref_ptr<object> repository::lookup_object(git::oid_view id,
 	                                          std::error_code& ec) const {
-		if (auto report = db_->lookup_object(id)) return report;
+		if (auto cached = cache_->get(id)) return cached;
+
+		auto stored = db_->lookup_object(id);
+		if (!stored) stored = packs_->lookup_object(id);
+		if (stored) {
+			cache_->put(id, stored);
+			return stored;
+		}
+
+		// blobs are not cached, peel_and_unlink() would leave an empty one
+		// for the next caller
 		if (auto blob = git_.lookup(id, ec)) return blob;
 
 		return {};
@@ -190,7 +219,144 @@ namespace cov {
 
 	bool repository::write(git::oid& out, ref_ptr<object> const& obj) {
 		if (is_a<blob>(obj)) return false;
-		return db_->write(out, obj);
+		if (batch_) {
+			backend const* also_in[] = {db_.get(), packs_.get()};
+			return batch_->write(out, obj, also_in);
+		}
+		backend const* also_in[] = {packs_.get()};
+		return db_->write(out, obj, also_in);
+	}
+
+	bool repository::begin_batch() {
+		if (batch_) return true;
+		batch_ = backend::pack_batch(common_dir_ / names::coverage_pack_dir,
+		                             pack_storage());
+		return !!batch_;
+	}
+
+	std::error_code repository::commit_batch() {
+		if (!batch_) return {};
+		auto const ec = batch_->commit();
+		if (ec) {
+			rollback_batch();
+			return ec;
+		}
+
+		end_batch();
+		packs_ = backend::pack_backend(common_dir_ / names::coverage_pack_dir);
+		auto_repack();
+		return {};
+	}
+
+	void repository::rollback_batch() {
+		if (!batch_) return;
+		batch_->rollback();
+		end_batch();
+	}
+
+	void repository::end_batch() {
+		// objects from rolled back batch are no longer counted as written
+		auto const stats = batch_->write_stats();
+		batched_.written += stats.written;
+		batched_.skipped += stats.skipped;
+		batch_ = nullptr;
+	}
+
+	io::pack_storage repository::pack_storage() const {
+		return cfg_.get_bool("pack.uncompressed").value_or(false)
+		           ? io::pack_storage::uncompressed
+		           : io::pack_storage::compressed;
+	}
+
+	io::repack_stats repository::repack(std::error_code& ec) {
+		auto const storage = pack_storage();
+		auto const pack_dir = common_dir_ / names::coverage_pack_dir;
+
+		// current packs are about to be replaced
+		packs_ = nullptr;
+		auto const stats = io::repack(common_dir_ / names::coverage_dir,
+		                              pack_dir, storage, ec);
+		packs_ = backend::pack_backend(pack_dir);
+		return stats;
+	}
+
+	void repository::auto_repack() {
+		auto const limit = cfg_.get_unsigned("pack.autoPackLimit")
+		                       .value_or(default_auto_pack_limit);
+		if (!limit) return;
+
+		auto const pack_dir = common_dir_ / names::coverage_pack_dir;
+		if (io::pack_indices(pack_dir).size() <= limit) return;
+
+		// the objects are already safe in their packs; if this fails, they
+		// will be merged by the next commit or by cov gc
+		std::error_code ignore{};
+		repack(ignore);
+	}
+
+	std::error_code repository::update_report_graph(git::oid_view tip) {
+		std::vector<io::report_graph::node> added{};
+		git::oid id = tip.oid();
+		while (!id.is_zero() && !graph_.find(id)) {
+			std::error_code ec{};
+			auto const report = lookup<cov::report>(id, ec);
+			if (!report || ec) break;
+			added.push_back({
+			    .id = id,
+			    .parent = report->parent_id(),
+			    .commit_time = report->commit_time_utc(),
+			    .add_time = report->add_time_utc(),
+			    .stats = report->stats(),
+			});
+			id = report->parent_id();
+		}
+		if (added.empty()) return {};
+
+		auto const contents = graph_.merged(added);
+		if (contents.empty())
+			return std::make_error_code(std::errc::value_too_large);
+
+		auto const path = common_dir_ / names::report_graph;
+		// some systems would not replace a mapped file
+		graph_ = {};
+		auto const ec = io::report_graph::store(
+		    path, {contents.data(), contents.size()});
+		graph_ = io::report_graph::open(path);
+		return ec;
+	}
+
+	std::optional<git::oid> repository::parent_report(
+	    git::oid_view id) const {
+		if (auto const index = graph_.find(id)) {
+			if (!graph_.has_parent(*index)) return git::oid{};
+			if (auto const parent = graph_.parent_of(*index))
+				return git::oid{graph_.id_at(*parent)};
+		}
+
+		std::error_code ec{};
+		auto const report = lookup<cov::report>(id, ec);
+		if (!report || ec) return std::nullopt;
+		return report->parent_id();
+	}
+
+	backend_write_stats repository::write_stats() const {
+		auto result = batched_;
+		if (db_) {
+			auto const stats = db_->write_stats();
+			result.written += stats.written;
+			result.skipped += stats.skipped;
+		}
+		if (batch_) {
+			auto const stats = batch_->write_stats();
+			result.written += stats.written;
+			result.skipped += stats.skipped;
+		}
+		return result;
+	}
+
+	object_cache_stats repository::cache_stats() const {
+		if (!cache_) return {};
+		return cache_->stats();
 	}
 
 	std::map<std::string, commit_file_diff> repository::diff_betwen_commits(
@@ -241,99 +407,93 @@ namespace cov {
 		return false;
 	}  // GCOV_EXCL_STOP
 
-	struct file_pool {
-		struct file_info {
-			io::v1::coverage_stats stats;
-			git::oid functions;
-			bool used;
-		};
-		std::map<std::string, file_info> items{};
-
-		static file_pool from(
-		    std::span<std::unique_ptr<cov::files::entry> const> const&
-		        old_entries) {
-			file_pool result{};
+	// Both lists are sorted by path, so the files, which were not renamed,
+	// are paired in a single walk over both lists. Files with a new name
+	// are looked up by their previous name.
+	class file_merge {
+	public:
+		using entries_type =
+		    std::span<std::unique_ptr<cov::files::entry> const>;
 
-			for (auto const& entry : old_entries) {
-				auto const path = entry->path();
-				result.items[{path.data(), path.size()}] = {
-				    entry->stats(), entry->function_coverage(), false};
-			}
+		explicit file_merge(entries_type old_entries)
+		    : old_{old_entries}, used_(old_entries.size(), false) {}
 
-			return result;
-		}  // GCOV_EXCL_LINE[GCC]
-
-		void apply(std::span<std::unique_ptr<cov::files::entry> const> const&
-		               new_entries,
+		void apply(entries_type new_entries,
 		           std::map<std::string, cov::commit_file_diff> const& renames,
 		           std::vector<file_stats>& result) {
+			result.reserve(result.size() + new_entries.size());
 			for (auto const& entry : new_entries) {
-				auto const path_view = entry->path();
-				auto path = std::string{path_view.data(), path_view.size()};
-				auto it = renames.find(path);
+				auto const path = entry->path();
+				file_stats next{
+				    .filename = {path.data(), path.size()},
+				    .current = entry->stats(),
+				    .previous = {},
+				    .current_functions = entry->function_coverage(),
+				    .previous_functions = {},
+				};
+
+				auto it = renames.find(next.filename);
 				if (it != renames.end()) {
-					// this is the name and kind to use for pool lookup...
-					result.push_back(match(
-					    it->second.previous_name, std::move(path), entry,
-					    [it](cov::file_stats& next, cov::file_diff::kind) {
-						    next.previous_name = it->second.previous_name;
-						    next.diff_kind = it->second.diff_kind;
-					    }));
-					continue;
+					// previous name is the one to look for in older list
+					find(it->second.previous_name, next);
+					next.previous_name = it->second.previous_name;
+					next.diff_kind = it->second.diff_kind;
+				} else {
+					next.diff_kind = advance_to(path, next)
+					                     ? file_diff::normal
+					                     : file_diff::added;
 				}
 
-				{
-					auto copy = path;
-					result.push_back(
-					    match(copy, std::move(path), entry,
-					          [](file_stats& info,        // GCOV_EXCL_LINE
-					             file_diff::kind kind) {  // GCOV_EXCL_LINE
-						          info.diff_kind = kind;
-					          }));
-				}
+				result.push_back(std::move(next));
 			}
 		}
 
 		void get_deleted(std::vector<file_stats>& result) {
-			for (auto const& [path, info] : items) {
-				auto const& [stats, prev_oid, used] = info;
-				if (used) continue;
+			for (size_t index = 0; index < old_.size(); ++index) {
+				if (used_[index]) continue;
+				auto const& entry = *old_[index];
+				auto const path = entry.path();
 
 				result.push_back({
-				    .filename = path,
+				    .filename = {path.data(), path.size()},
 				    .current = {},
-				    .previous = stats,
+				    .previous = entry.stats(),
 				    .previous_name = {},
 				    .diff_kind = file_diff::deleted,
 				});
 			}
 		}
 
-		template <typename Callback>
-		file_stats match(std::string const& key,
-		                 std::string&& path,
-		                 std::unique_ptr<cov::files::entry> const& entry,
-		                 Callback&& get_prev) {
-			file_stats result{
-			    .filename = std::move(path),
-			    .current = entry->stats(),
-			    .previous = {},
-			    .current_functions = entry->function_coverage(),
-			    .previous_functions = {},
-			};
-
-			auto kind = file_diff::added;
-
-			auto prev = items.find(key);
-			if (prev != items.end()) {
-				prev->second.used = true;
-				result.previous = prev->second.stats;
-				result.previous_functions = prev->second.functions;
-				kind = file_diff::normal;
-			}
-			get_prev(result, kind);
-			return result;
-		}  // GCOV_EXCL_LINE[GCC]
+	private:
+		// moves the cursor forward; new entries come in the same order
+		bool advance_to(std::string_view path, file_stats& next) {
+			while (cursor_ < old_.size() && old_[cursor_]->path() < path)
+				++cursor_;
+			if (cursor_ == old_.size() || old_[cursor_]->path() != path)
+				return false;
+			use(cursor_, next);
+			return true;
+		}
+
+		void find(std::string_view path, file_stats& next) {
+			auto it = std::lower_bound(
+			    old_.begin(), old_.end(), path,
+			    [](auto const& entry, std::string_view path) {
+				    return entry->path() < path;
+			    });
+			if (it == old_.end() || (*it)->path() != path) return;
+			use(static_cast<size_t>(it - old_.begin()), next);
+		}
+
+		void use(size_t index, file_stats& next) {
+			used_[index] = true;
+			next.previous = old_[index]->stats();
+			next.previous_functions = old_[index]->function_coverage();
+		}
+
+		entries_type old_;
+		std::vector<bool> used_{};
+		size_t cursor_{};
 	};
 
 	std::vector<file_stats> repository::diff_betwen_reports(
@@ -354,11 +514,16 @@ namespace cov {
 
 		std::vector<file_stats> result{};
 
-		auto pool = file_pool::from(old_files->entries());
-		pool.apply(new_files->entries(), renames, result);
-		pool.get_deleted(result);
+		file_merge merge{old_files->entries()};
+		merge.apply(new_files->entries(), renames, result);
+		auto const current_count = result.size();
+		merge.get_deleted(result);
 
-		std::stable_sort(result.begin(), result.end(), path_sort_less);
+		// both the current and the deleted files are already in path order
+		auto const middle =
+		    result.begin() + static_cast<std::ptrdiff_t>(current_count);
+		std::inplace_merge(result.begin(), middle, result.end(),
+		                   path_sort_less);
 		return result;
 	}
 
@@ -34,15 +34,11 @@ namespace cov {
 
 			ref next(cov::repository const& repo) const {
 				if (flag) {
-					std::error_code ec{};
-					// fs based, good candidate for WHY I will need cache of
-					// object-already-looked-up
-					auto me = repo.lookup<cov::report>(sha, ec);
-					if (!ec && me) {
-						auto const& parent = me->parent_id();
-						if (!parent.is_zero()) {
-							return {parent, true};
-						}
+					// report graph first, report objects only for the ids
+					// missing from the graph
+					auto const parent = repo.parent_report(sha);
+					if (parent && !parent->is_zero()) {
+						return {*parent, true};
 					}
 				}
 				return {};
@@ -273,6 +269,7 @@ namespace cov {
 	}
 
 	bool revs::is_report(cov::repository const& repo, git::oid_view id) {
+		if (repo.report_graph().find(id)) return true;
 		std::error_code ec{};
 		auto const obj = repo.lookup<cov::report>(id, ec);
 		return !ec && obj;
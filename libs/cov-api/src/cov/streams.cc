@@ -11,4 +11,8 @@
 namespace cov {
 	write_stream::~write_stream() {}
 	read_stream::~read_stream() {}
+
+	bool read_stream::view(size_t, git::bytes&, ref_ptr<counted>&) {
+		return false;
+	}
 }  // namespace cov
@@ -6,7 +6,24 @@
 #include <cstring>
 
 namespace cov {
-	zstream::zstream(direction dir) : deflating_{dir} {
+	zstream::zstream(direction dir, wrapper wrap) : deflating_{dir} {
+		// adding 16 to the window bits selects gzip header and trailer
+		// instead of zlib ones
+		static constexpr int max_window_bits = 15;
+		static constexpr int gzip_window_bits = max_window_bits + 16;
+		static constexpr int default_mem_level = 8;
+
+		if (wrap == gzip) {
+			if (deflating_)
+				deflateInit2_(&z_, Z_BEST_SPEED, Z_DEFLATED, gzip_window_bits,
+				              default_mem_level, Z_DEFAULT_STRATEGY,
+				              ZLIB_VERSION, sizeof(z_stream));
+			else
+				inflateInit2_(&z_, gzip_window_bits, ZLIB_VERSION,
+				              sizeof(z_stream));
+			return;
+		}
+
 		if (deflating_)
 			deflateInit_(&z_, Z_BEST_SPEED, ZLIB_VERSION, sizeof(z_stream));
 		else
@@ -68,7 +85,14 @@ namespace cov {
 			z_.avail_out = buffer_size;
 			z_.next_out = output;
 			ret = process(Z_FINISH);
+			// inflate reports Z_BUF_ERROR for each call, which fills the
+			// output; only a call without any output means there is no more
+			// input to finish the stream with
+			auto const stalled = z_.avail_out == buffer_size;
+			if (ret == Z_BUF_ERROR && !stalled) continue;
+			if (ret != Z_OK) break;
 		}
+		complete_ = ret == Z_STREAM_END;
 	}
 
 	int zstream::process(int flush) {
@@ -77,7 +101,7 @@ namespace cov {
 
 		int ret = deflating_ ? ::deflate(&z_, flush) : ::inflate(&z_, flush);
 
-		if (ret == Z_OK || ret == Z_STREAM_END) {
+		if (ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR) {
 			auto const used = ready - z_.avail_out;
 			if (output({data, used}) != used) ret = Z_STREAM_ERROR;
 		}
@@ -0,0 +1,236 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <gtest/gtest.h>
+#include <cov/git2/bytes.hh>
+#include <cov/io/branch_coverage.hh>
+#include <cov/io/db_object.hh>
+#include <cov/io/read_stream.hh>
+#include <cov/io/shared_bytes.hh>
+#include "test_stream.hh"
+
+namespace cov::testing {
+	using namespace std::literals;
+	using branch = cov::branch_coverage::branch;
+
+	namespace {
+		struct line_branches {
+			std::uint32_t line{};
+			std::vector<branch> branches{};
+			bool operator==(line_branches const&) const noexcept = default;
+		};
+
+		std::vector<line_branches> decode(cov::branch_coverage const& obj) {
+			std::vector<line_branches> result{};
+			auto cursor = obj.lines();
+			while (cursor.next()) {
+				auto const branches = cursor.branches();
+				result.push_back(
+				    {cursor.line(), {branches.begin(), branches.end()}});
+			}
+			EXPECT_FALSE(cursor.failed());
+			return result;
+		}
+
+		ref_ptr<counted> load(std::string_view data, std::error_code& ec) {
+			io::bytes_read_stream stream{git::bytes{data.data(), data.size()}};
+
+			io::db_object dbo{};
+			dbo.add_handler<io::OBJECT::BRANCHES,
+			                io::handlers::branch_coverage>();
+			return dbo.load(git::oid{}, stream, ec);
+		}
+	}  // namespace
+
+	TEST(branch_coverage, load_empty) {
+		static constexpr auto s =
+		    "bran\x00\x00\x01\x00"
+		    "\x00\x00\x00\x00"
+		    "\x00\x00\x00\x00"
+		    "\x00\x00\x00\x00"sv;
+
+		std::error_code ec{};
+		auto const result = load(s, ec);
+		ASSERT_FALSE(ec) << "   Error: " << ec.message() << " ("
+		                 << ec.category().name() << ')';
+		ASSERT_TRUE(result);
+		ASSERT_TRUE(result->is_object());
+		auto const obj = static_cast<object const*>(result.get());
+		ASSERT_EQ(obj_branch_coverage, obj->type());
+		auto const branches = as_a<cov::branch_coverage>(obj);
+		ASSERT_TRUE(branches);
+		ASSERT_TRUE(decode(*branches).empty());
+		ASSERT_EQ(io::v1::stats::init(), branches->summary());
+	}
+
+	TEST(branch_coverage, load) {
+		static constexpr auto s =
+		    "bran\x00\x00\x01\x00"
+		    "\x02\x00\x00\x00"
+		    "\x03\x00\x00\x00"
+		    "\x03\x00\x00\x00"
+		    "\x02\x01\x01\x00"
+		    "\x03\x02\xAC\x02"
+		    "\x00\x00\x00\x00"sv;
+
+		std::error_code ec{};
+		auto const result = load(s, ec);
+		ASSERT_FALSE(ec) << "   Error: " << ec.message() << " ("
+		                 << ec.category().name() << ')';
+		auto const branches =
+		    as_a<cov::branch_coverage>(static_cast<object const*>(result.get()));
+		ASSERT_TRUE(branches);
+
+		std::vector<line_branches> const expected{
+		    {.line = 2, .branches = {{.taken = 1, .not_taken = 0}}},
+		    {.line = 5,
+		     .branches = {{.taken = 300, .not_taken = 0},
+		                  {.taken = 0, .not_taken = 0}}},
+		};
+		ASSERT_EQ(expected, decode(*branches));
+		ASSERT_EQ((io::v1::stats{.relevant = 6, .visited = 2}),
+		          branches->summary());
+	}
+
+	TEST(branch_coverage, load_shared) {
+		static constexpr auto s =
+		    "bran\x00\x00\x01\x00"
+		    "\x01\x00\x00\x00"
+		    "\x01\x00\x00\x00"
+		    "\x01\x00\x00\x00"
+		    "\x07\x01\x00\x04"sv;
+		auto const bytes = reinterpret_cast<std::byte const*>(s.data());
+		auto const shared =
+		    io::shared_bytes::wrap({bytes, bytes + s.size()});
+		auto const data = shared->data();
+		io::bytes_read_stream stream{data, shared};
+
+		io::db_object dbo{};
+		dbo.add_handler<io::OBJECT::BRANCHES, io::handlers::branch_coverage>();
+
+		std::error_code ec{};
+		auto const result = dbo.load(git::oid{}, stream, ec);
+		ASSERT_FALSE(ec) << "   Error: " << ec.message() << " ("
+		                 << ec.category().name() << ')';
+		auto const branches =
+		    as_a<cov::branch_coverage>(static_cast<object const*>(result.get()));
+		ASSERT_TRUE(branches);
+		// the table is not copied out of the shared bytes
+		ASSERT_EQ(data.data() + 20, branches->table().data());
+
+		std::vector<line_branches> const expected{
+		    {.line = 7, .branches = {{.taken = 0, .not_taken = 4}}},
+		};
+		ASSERT_EQ(expected, decode(*branches));
+	}
+
+	TEST(branch_coverage, load_partial) {
+		static constexpr auto s =
+		    "bran\x00\x00\x01\x00"
+		    "\x02\x00\x00\x00"
+		    "\x03\x00\x00\x00"
+		    "\x03\x00\x00\x00"
+		    "\x02\x01\x01\x00"sv;
+
+		std::error_code ec{};
+		auto const result = load(s, ec);
+		ASSERT_FALSE(result);
+		ASSERT_EQ(ec, io::errc::bad_syntax);
+	}
+
+	TEST(branch_coverage, load_mismatched) {
+		// header says there are four branches, the table has three
+		static constexpr auto s =
+		    "bran\x00\x00\x01\x00"
+		    "\x02\x00\x00\x00"
+		    "\x04\x00\x00\x00"
+		    "\x03\x00\x00\x00"
+		    "\x02\x01\x01\x00"
+		    "\x03\x02\xAC\x02"
+		    "\x00\x00\x00\x00"sv;
+
+		std::error_code ec{};
+		auto const result = load(s, ec);
+		ASSERT_FALSE(result);
+		ASSERT_EQ(ec, io::errc::bad_syntax);
+	}
+
+	TEST(branch_coverage, load_overflowing) {
+		// the count of the only branch does not fit in 32 bits
+		static constexpr auto s =
+		    "bran\x00\x00\x01\x00"
+		    "\x01\x00\x00\x00"
+		    "\x01\x00\x00\x00"
+		    "\x03\x00\x00\x00"
+		    "\x00\x01\xFF\xFF"
+		    "\xFF\xFF\x7F\x00"
+		    "\x00\x00\x00\x00"sv;
+
+		std::error_code ec{};
+		auto const result = load(s, ec);
+		ASSERT_FALSE(result);
+		ASSERT_EQ(ec, io::errc::bad_syntax);
+	}
+
+	TEST(branch_coverage, store) {
+		static constexpr auto expected =
+		    "bran\x00\x00\x01\x00"
+		    "\x02\x00\x00\x00"
+		    "\x03\x00\x00\x00"
+		    "\x03\x00\x00\x00"
+		    "\x02\x01\x01\x00"
+		    "\x03\x02\xAC\x02"
+		    "\x00\x00\x00\x00"sv;
+		test_stream stream{};
+
+		io::db_object dbo{};
+		dbo.add_handler<io::OBJECT::BRANCHES, io::handlers::branch_coverage>();
+
+		branch const line2[] = {{.taken = 1, .not_taken = 0}};
+		branch const line5[] = {{.taken = 300, .not_taken = 0},
+		                        {.taken = 0, .not_taken = 0}};
+		auto const obj = cov::branch_coverage::builder{}
+		                     .add(2, line2)
+		                     .add(4, {})
+		                     .add(5, line5)
+		                     .extract();
+		auto const result = dbo.store(obj, stream);
+		ASSERT_TRUE(result);
+		ASSERT_EQ(expected, stream.view());
+	}
+
+	TEST(branch_coverage, round_trip) {
+		static constexpr auto max = std::numeric_limits<std::uint32_t>::max();
+		std::vector<line_branches> const expected{
+		    {.line = 0, .branches = {{.taken = max, .not_taken = 127}}},
+		    {.line = 128,
+		     .branches = {{.taken = 128, .not_taken = 16384},
+		                  {.taken = 5, .not_taken = 3}}},
+		    {.line = max, .branches = {{.taken = 0, .not_taken = 1}}},
+		};
+
+		cov::branch_coverage::builder builder{};
+		for (auto const& line : expected)
+			builder.add(line.line, line.branches);
+		auto const obj = builder.extract();
+		ASSERT_EQ(3u, obj->line_count());
+		ASSERT_EQ(4u, obj->branch_count());
+
+		test_stream stream{};
+		io::db_object dbo{};
+		dbo.add_handler<io::OBJECT::BRANCHES, io::handlers::branch_coverage>();
+		ASSERT_TRUE(dbo.store(obj, stream));
+		ASSERT_EQ(0u, stream.data.size() % sizeof(std::uint32_t));
+
+		std::error_code ec{};
+		auto const result = load(stream.view(), ec);
+		ASSERT_FALSE(ec) << "   Error: " << ec.message() << " ("
+		                 << ec.category().name() << ')';
+		auto const loaded =
+		    as_a<cov::branch_coverage>(static_cast<object const*>(result.get()));
+		ASSERT_TRUE(loaded);
+		ASSERT_EQ(expected, decode(*loaded));
+		ASSERT_EQ((io::v1::stats{.relevant = 8, .visited = 7}),
+		          loaded->summary());
+	}
+}  // namespace cov::testing
@@ -7,6 +7,7 @@
 #include <cov/io/db_object.hh>
 #include <cov/io/files.hh>
 #include <cov/io/read_stream.hh>
+#include <cov/io/shared_bytes.hh>
 #include "setup.hh"
 #include "test_stream.hh"
 
@@ -428,6 +429,35 @@ namespace cov::testing {
 		ASSERT_FALSE(result);
 	}
 
+	TEST(files, partial_load_8_viewed_entries_wrap_around) {
+		// (offset + size * count) * 4 wraps around to the end of the
+		// header, so an empty payload would seem to hold 2^31 entries
+		static constexpr auto s =
+		    "list\x00\x00\x01\x00"
+
+		    // strings
+		    "\x05\x00\x00\x00"
+		    "\x00\x00\x00\x00"
+
+		    // entries
+		    "\x05\x00\x00\x00"
+		    "\x00\x00\x00\x80"
+		    "\x00\x00\x00\x80"
+		    ""sv;
+		auto const bytes = git::bytes{s.data(), s.size()};
+		auto const owner =
+		    io::shared_bytes::wrap({bytes.data(), bytes.data() + bytes.size()});
+		io::bytes_read_stream stream{owner->data(), owner};
+
+		io::db_object dbo{};
+		dbo.add_handler<io::OBJECT::FILES, io::handlers::files>();
+
+		std::error_code ec{};
+		auto const result = dbo.load(git::oid{}, stream, ec);
+		ASSERT_TRUE(ec);
+		ASSERT_FALSE(result);
+	}
+
 	TEST(files, store) {
 		static constexpr auto expected =
 		    "list\x00\x00\x01\x00"
@@ -675,4 +705,31 @@ namespace cov::testing {
 			actual.push_back(ptr->path());
 		ASSERT_EQ(expected, actual);
 	}
+
+	TEST(files, create_sorted) {
+		std::vector<std::unique_ptr<files::entry>> entries{};
+		for (auto const path : {"Gamma"sv, "Alpha"sv, "Delta"sv, "Beta"sv}) {
+			auto list_of_one =
+			    files::builder{}.add_nfo({.path = path}).release();
+			entries.push_back(std::move(list_of_one.front()));
+		}
+
+		auto const list = files::create(std::move(entries));
+		std::vector<std::string_view> expected = {"Alpha", "Beta", "Delta",
+		                                          "Gamma"};
+		std::vector<std::string_view> actual{};
+		actual.reserve(list->entries().size());
+		for (auto const& ptr : list->entries())
+			actual.push_back(ptr->path());
+		ASSERT_EQ(expected, actual);
+
+		for (auto const path : expected) {
+			auto const entry = list->by_path(path);
+			ASSERT_TRUE(entry);
+			ASSERT_EQ(path, entry->path());
+		}
+		ASSERT_FALSE(list->by_path("Aardvark"sv));
+		ASSERT_FALSE(list->by_path("Epsilon"sv));
+		ASSERT_FALSE(list->by_path("Zeta"sv));
+	}
 }  // namespace cov::testing
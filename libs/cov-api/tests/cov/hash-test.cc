@@ -4,6 +4,7 @@
 #include <gtest/gtest.h>
 #include <cov/hash/md5.hh>
 #include <cov/hash/sha1.hh>
+#include <vector>
 
 namespace hash::testing {
 	using namespace ::std::literals;
@@ -131,4 +132,53 @@ namespace hash::testing {
 	};
 	INSTANTIATE_TEST_SUITE_P(sha1, hash, ValuesIn(sha1s));
 
+	template <typename Hash>
+	void lanes_same_as_update() {
+		std::vector<std::byte> content(64 * 20 + 63);
+		unsigned seed = 0x7654321u;
+		for (auto& b : content) {
+			seed = seed * 1103515245u + 12345u;
+			b = static_cast<std::byte>(seed >> 16);
+		}
+
+		auto const lhs_data = git::bytes{content.data(), content.size()};
+		auto const rhs_data = lhs_data.subview(64 * 13 + 5);
+		for (size_t blocks = 0; blocks <= rhs_data.size() / 64; ++blocks) {
+			Hash lhs{}, rhs{};
+			Hash::update_lanes(lhs, lhs_data.data(), rhs, rhs_data.data(),
+			                   blocks);
+			lhs.update(lhs_data.subview(blocks * 64));
+			rhs.update(rhs_data.subview(blocks * 64));
+			ASSERT_EQ(Hash::once(lhs_data).str(), lhs.finalize().str())
+			    << "blocks: " << blocks;
+			ASSERT_EQ(Hash::once(rhs_data).str(), rhs.finalize().str())
+			    << "blocks: " << blocks;
+		}
+	}
+
+	TEST(hash_lanes, md5) { lanes_same_as_update<md5>(); }
+	TEST(hash_lanes, sha1) { lanes_same_as_update<sha1>(); }
+
+	TEST(sha1_kernel, same_as_portable) {
+		std::vector<std::byte> content(64 * 20 + 63);
+		unsigned seed = 0x1234567u;
+		for (auto& b : content) {
+			seed = seed * 1103515245u + 12345u;
+			b = static_cast<std::byte>(seed >> 16);
+		}
+
+		for (auto const kernel : {sha1::kernel::automatic, sha1::best_kernel(),
+		                          sha1::kernel::shani}) {
+			for (size_t length = 0; length <= content.size(); ++length) {
+				auto const data = git::bytes{content.data(), length};
+				auto const expected =
+				    sha1{sha1::kernel::portable}.update(data).finalize();
+				auto const actual = sha1{kernel}.update(data).finalize();
+				ASSERT_EQ(expected.str(), actual.str())
+				    << "kernel: " << static_cast<int>(kernel)
+				    << ", length: " << length;
+			}
+		}
+	}
+
 }  // namespace hash::testing
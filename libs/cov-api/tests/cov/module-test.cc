@@ -712,6 +712,43 @@ namespace cov::testing {
 		ASSERT_EQ(expected, buffer.str());
 	}
 
+	TEST(module_matcher, containing) {
+		module_matcher const matcher{{
+		    {"libs"s, {"libs"s}},
+		    {"cov"s, {"libs/cov/"s, "libs/cov-rt"s}},
+		    {"api"s, {"libs/cov/include"s}},
+		    {"app"s, {"apps/"s}},
+		}};
+
+		using list = std::vector<size_t>;
+		ASSERT_EQ((list{0}), matcher.containing("libs"sv));
+		ASSERT_EQ((list{0}), matcher.containing("libs/cov"sv));
+		ASSERT_EQ((list{0, 1}), matcher.containing("libs/cov/src/db.cc"sv));
+		ASSERT_EQ((list{0, 1, 2}),
+		          matcher.containing("libs/cov/include/cov/db.hh"sv));
+		ASSERT_EQ((list{0, 1}), matcher.containing("libs/cov-rt"sv));
+		ASSERT_EQ((list{0}), matcher.containing("libs/cov-api/x.cc"sv));
+		ASSERT_EQ((list{3}), matcher.containing("apps/cov/cov.cc"sv));
+		ASSERT_EQ((list{}), matcher.containing("apps"sv));
+		ASSERT_EQ((list{}), matcher.containing("libsx/file.cc"sv));
+	}
+
+	TEST(module_matcher, closest) {
+		module_matcher const matcher{{
+		    {"libs"s, {"libs"s}},
+		    {"cov"s, {"libs/cov/"s, "libs/cov-rt"s}},
+		    {"api"s, {"libs/cov"s}},
+		    {"root"s, {""s}},
+		}};
+
+		using list = std::vector<size_t>;
+		ASSERT_EQ((list{0}), matcher.closest("libs/app/main.cc"sv));
+		ASSERT_EQ((list{1, 2}), matcher.closest("libs/cov/src/db.cc"sv));
+		ASSERT_EQ((list{1, 2}), matcher.closest("libs/cov"sv));
+		ASSERT_EQ((list{1}), matcher.closest("libs/cov-rt/src/tools.cc"sv));
+		ASSERT_EQ((list{}), matcher.closest("apps/cov/cov.cc"sv));
+	}
+
 	TEST(module_mod, cleanup) {
 		static constexpr auto config_text = R"(
 ; start with a blank line
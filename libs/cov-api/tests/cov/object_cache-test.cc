@@ -0,0 +1,104 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <gtest/gtest.h>
+#include <cov/object_cache.hh>
+#include <cov/report.hh>
+
+namespace cov::testing {
+	using namespace std::literals;
+	using namespace git::literals;
+
+	namespace {
+		static constexpr auto id_1 = "2b875786ee42e4141e8004ff9a91fc212b00f1f5"sv;
+		static constexpr auto id_2 = "ed631389fc343f7ccb6e1b6a5c1bfb0a09ea4e12"sv;
+		static constexpr auto id_3 = "c1dc3ecd9aa4df73a1bd2d1fcb5a5e2c2fe0c1e9"sv;
+
+		ref_ptr<object> make_lines(size_t count) {
+			std::vector<io::v1::coverage> lines(count, {1, 0});
+			return line_coverage::create(std::move(lines));
+		}
+	}  // namespace
+
+	TEST(object_cache, hit_and_miss) {
+		object_cache cache{};
+		auto const id = git::oid::from(id_1);
+
+		ASSERT_FALSE(cache.get(id));
+		auto const lines = make_lines(10);
+		cache.put(id, lines);
+
+		auto const cached = cache.get(id);
+		ASSERT_EQ(lines.get(), cached.get());
+		ASSERT_FALSE(cache.get(git::oid::from(id_2)));
+
+		auto const stats = cache.stats();
+		ASSERT_EQ(1u, stats.hits);
+		ASSERT_EQ(2u, stats.misses);
+		ASSERT_EQ(0u, stats.evictions);
+		ASSERT_EQ(1u, stats.objects);
+		ASSERT_EQ(object_cache::cost_of(*lines), stats.bytes);
+	}
+
+	TEST(object_cache, evicts_least_recently_used) {
+		auto const first = git::oid::from(id_1);
+		auto const second = git::oid::from(id_2);
+		auto const third = git::oid::from(id_3);
+
+		object_cache cache{250};
+		cache.put(first, make_lines(1), 100);
+		cache.put(second, make_lines(1), 100);
+		// the first one is now more recent than the second
+		ASSERT_TRUE(cache.get(first));
+		cache.put(third, make_lines(1), 100);
+
+		ASSERT_TRUE(cache.get(first));
+		ASSERT_FALSE(cache.get(second));
+		ASSERT_TRUE(cache.get(third));
+
+		auto const stats = cache.stats();
+		ASSERT_EQ(1u, stats.evictions);
+		ASSERT_EQ(2u, stats.objects);
+		ASSERT_EQ(200u, stats.bytes);
+		ASSERT_EQ(250u, stats.budget);
+	}
+
+	TEST(object_cache, replace_and_resize) {
+		auto const first = git::oid::from(id_1);
+		auto const second = git::oid::from(id_2);
+
+		object_cache cache{1000};
+		cache.put(first, make_lines(1), 100);
+		cache.put(first, make_lines(2), 300);
+		cache.put(second, make_lines(3), 400);
+		ASSERT_EQ(700u, cache.stats().bytes);
+		ASSERT_EQ(2u,
+		          as_a<line_coverage>(cache.get(first))->coverage().size());
+
+		cache.resize(500);
+		ASSERT_EQ(300u, cache.stats().bytes);
+		ASSERT_TRUE(cache.get(first));
+		ASSERT_FALSE(cache.get(second));
+
+		cache.clear();
+		ASSERT_EQ(0u, cache.stats().objects);
+		ASSERT_EQ(0u, cache.stats().bytes);
+	}
+
+	TEST(object_cache, disabled) {
+		auto const id = git::oid::from(id_1);
+
+		object_cache cache{0};
+		cache.put(id, make_lines(1));
+		ASSERT_FALSE(cache.get(id));
+		ASSERT_EQ(0u, cache.stats().objects);
+
+		cache.put(id, ref_ptr<object>{});
+		ASSERT_EQ(0u, cache.stats().objects);
+	}
+
+	TEST(object_cache, cost_grows_with_contents) {
+		ASSERT_LT(object_cache::cost_of(*make_lines(1)),
+		          object_cache::cost_of(*make_lines(100)));
+	}
+}  // namespace cov::testing
@@ -0,0 +1,358 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <gtest/gtest.h>
+#include <cov/db.hh>
+#include <cov/io/pack.hh>
+#include <filesystem>
+#include <vector>
+#include "db-helper.hh"
+#include "path-utils.hh"
+
+namespace cov::testing {
+	using namespace std::literals;
+
+	namespace {
+		std::vector<line_cvg> const coverages{
+		    {{1, 1}, {2, 1}, {3, 0}},
+		    {{10, 15}, {11, 15}, {12, 10}},
+		    {{5, 0}},
+		    {{100, 1}, {101, 2}, {102, 3}, {104, 4}},
+		};
+
+		void prepare_dir(std::string_view name) {
+			std::error_code ec{};
+			path_info::op({{name, path_kind::remove_all},
+			               {name, path_kind::create_directories}},
+			              ec);
+			ASSERT_FALSE(ec) << "   Error: " << ec.message() << " ("
+			                 << ec.category().name() << ')';
+		}
+
+		void write_loose(ref_ptr<backend> const& loose,
+		                 line_cvg const& lines,
+		                 std::vector<git::oid>& ids) {
+			auto cvg_object = from_lines(lines);
+			ASSERT_TRUE(cvg_object);
+			git::oid id{};
+			ASSERT_TRUE(loose->write(id, cvg_object));
+			ids.push_back(id);
+		}
+
+		void check_packed(ref_ptr<backend> const& packed,
+		                  std::vector<git::oid> const& ids) {
+			for (size_t index = 0; index < ids.size(); ++index) {
+				auto cvg_lines = packed->lookup<cov::line_coverage>(ids[index]);
+				ASSERT_TRUE(cvg_lines) << ids[index].str();
+				unsigned finish{0};
+				ASSERT_EQ(coverages[index],
+				          from_coverage(cvg_lines->coverage(), finish));
+			}
+		}
+
+		size_t count_loose(std::filesystem::path const& root) {
+			size_t result{};
+			std::error_code ec{};
+			for (auto const& entry :
+			     std::filesystem::recursive_directory_iterator{root, ec}) {
+				if (entry.is_regular_file() &&
+				    entry.path().parent_path().filename() != "pack"sv)
+					++result;
+			}
+			return result;
+		}
+	}  // namespace
+
+	TEST(pack, repack_loose) {
+		prepare_dir("pack_loose"sv);
+		auto const root = setup::test_dir() / "pack_loose"sv;
+		auto const pack_dir = root / "pack"sv;
+
+		auto loose = backend::loose_backend(root);
+		std::vector<git::oid> ids{};
+		for (auto const& lines : coverages) {
+			write_loose(loose, lines, ids);
+		}
+
+		std::error_code ec{};
+		auto const stats = io::repack(root, pack_dir, ec);
+		ASSERT_FALSE(ec) << "   Error: " << ec.message() << " ("
+		                 << ec.category().name() << ')';
+		ASSERT_EQ(coverages.size(), stats.loose_objects);
+		ASSERT_EQ(coverages.size(), stats.packed_objects);
+		ASSERT_EQ(0u, stats.removed_packs);
+		ASSERT_EQ(0u, count_loose(root));
+		ASSERT_FALSE(loose->lookup<cov::line_coverage>(ids.front()));
+
+		auto const packs = io::open_packs(pack_dir);
+		ASSERT_EQ(1u, packs.size());
+		ASSERT_EQ(coverages.size(), packs.front().size());
+		for (size_t index = 1; index < packs.front().size(); ++index) {
+			ASSERT_LT(git_oid_cmp(&packs.front().id_at(index - 1),
+			                      &packs.front().id_at(index)),
+			          0);
+		}
+
+		auto packed = backend::pack_backend(pack_dir);
+		check_packed(packed, ids);
+
+		auto const partial =
+		    packed->lookup<cov::line_coverage>(ids.front(), GIT_OID_HEXSZ / 2);
+		ASSERT_TRUE(partial);
+		unsigned finish{0};
+		ASSERT_EQ(coverages.front(),
+		          from_coverage(partial->coverage(), finish));
+
+		git::oid unused{};
+		ASSERT_FALSE(packed->write(unused, from_lines(coverages.front())));
+	}
+
+	TEST(pack, merge_packs) {
+		prepare_dir("pack_merge"sv);
+		auto const root = setup::test_dir() / "pack_merge"sv;
+		auto const pack_dir = root / "pack"sv;
+
+		auto loose = backend::loose_backend(root);
+		std::vector<git::oid> ids{};
+		std::error_code ec{};
+
+		write_loose(loose, coverages[0], ids);
+		write_loose(loose, coverages[1], ids);
+		io::repack(root, pack_dir, ec);
+		ASSERT_FALSE(ec);
+
+		write_loose(loose, coverages[2], ids);
+		write_loose(loose, coverages[3], ids);
+		auto const stats = io::repack(root, pack_dir, ec);
+		ASSERT_FALSE(ec);
+		ASSERT_EQ(2u, stats.loose_objects);
+		ASSERT_EQ(coverages.size(), stats.packed_objects);
+		ASSERT_EQ(1u, stats.removed_packs);
+		ASSERT_EQ(1u, io::open_packs(pack_dir).size());
+
+		check_packed(backend::pack_backend(pack_dir), ids);
+	}
+
+	TEST(pack, uncompressed) {
+		prepare_dir("pack_uncompressed"sv);
+		auto const root = setup::test_dir() / "pack_uncompressed"sv;
+		auto const pack_dir = root / "pack"sv;
+
+		auto loose = backend::loose_backend(root);
+		std::vector<git::oid> ids{};
+		for (auto const& lines : coverages) {
+			write_loose(loose, lines, ids);
+		}
+
+		std::error_code ec{};
+		auto stats =
+		    io::repack(root, pack_dir, io::pack_storage::uncompressed, ec);
+		ASSERT_FALSE(ec);
+		ASSERT_EQ(coverages.size(), stats.packed_objects);
+
+		{
+			auto const packs = io::open_packs(pack_dir);
+			ASSERT_EQ(1u, packs.size());
+			for (size_t index = 0; index < packs.front().size(); ++index) {
+				auto const& entry = packs.front().entry_at(index);
+				ASSERT_EQ(io::v1::pack_entry::uncompressed, entry.flags);
+				ASSERT_EQ(0u, entry.offset() % 8);
+			}
+		}
+
+		auto packed = backend::pack_backend(pack_dir);
+		check_packed(packed, ids);
+
+		// nothing new and the storage is unchanged
+		stats = io::repack(root, pack_dir, io::pack_storage::uncompressed, ec);
+		ASSERT_FALSE(ec);
+		ASSERT_EQ(0u, stats.packed_objects);
+
+		// objects viewed from the old pack must outlive its replacement
+		auto held = packed->lookup<cov::line_coverage>(ids.back());
+		ASSERT_TRUE(held);
+		packed.reset();
+
+		stats = io::repack(root, pack_dir, io::pack_storage::compressed, ec);
+		ASSERT_FALSE(ec);
+		ASSERT_EQ(coverages.size(), stats.packed_objects);
+		unsigned finish{0};
+		ASSERT_EQ(coverages.back(), from_coverage(held->coverage(), finish));
+		check_packed(backend::pack_backend(pack_dir), ids);
+	}
+
+	TEST(pack, skip_stored_objects) {
+		prepare_dir("pack_skip"sv);
+		auto const root = setup::test_dir() / "pack_skip"sv;
+		auto const pack_dir = root / "pack"sv;
+
+		auto loose = backend::loose_backend(root);
+		std::vector<git::oid> ids{};
+		write_loose(loose, coverages[0], ids);
+		write_loose(loose, coverages[1], ids);
+		write_loose(loose, coverages[0], ids);
+		ASSERT_EQ(ids[0], ids[2]);
+		ASSERT_EQ(2u, count_loose(root));
+		ASSERT_EQ((backend_write_stats{.written = 2, .skipped = 1}),
+		          loose->write_stats());
+
+		std::error_code ec{};
+		io::repack(root, pack_dir, ec);
+		ASSERT_FALSE(ec);
+		ASSERT_EQ(0u, count_loose(root));
+
+		auto packed = backend::pack_backend(pack_dir);
+		ASSERT_TRUE(packed->contains(ids[1]));
+		ASSERT_FALSE(loose->contains(ids[1]));
+
+		git::oid id{};
+		backend const* also_in[] = {packed.get()};
+		ASSERT_TRUE(loose->write(id, from_lines(coverages[1]), also_in));
+		ASSERT_EQ(ids[1], id);
+		ASSERT_EQ(0u, count_loose(root));
+		ASSERT_EQ((backend_write_stats{.written = 2, .skipped = 2}),
+		          loose->write_stats());
+
+		// without the packs to look into, the object is stored again
+		ASSERT_TRUE(loose->write(id, from_lines(coverages[1])));
+		ASSERT_EQ(ids[1], id);
+		ASSERT_EQ(1u, count_loose(root));
+		ASSERT_EQ((backend_write_stats{.written = 3, .skipped = 2}),
+		          loose->write_stats());
+		ASSERT_EQ(backend_write_stats{}, packed->write_stats());
+	}
+
+	TEST(pack, batch) {
+		prepare_dir("pack_batch"sv);
+		auto const root = setup::test_dir() / "pack_batch"sv;
+		auto const pack_dir = root / "pack"sv;
+
+		auto loose = backend::loose_backend(root);
+		std::vector<git::oid> loose_ids{};
+		write_loose(loose, coverages[0], loose_ids);
+
+		auto batch =
+		    backend::pack_batch(pack_dir, io::pack_storage::compressed);
+		ASSERT_TRUE(batch);
+		backend const* also_in[] = {loose.get()};
+		std::vector<git::oid> ids{};
+		for (auto const& lines : coverages) {
+			git::oid id{};
+			ASSERT_TRUE(batch->write(id, from_lines(lines), also_in));
+			ids.push_back(id);
+		}
+		ASSERT_EQ(loose_ids.front(), ids.front());
+		git::oid again{};
+		ASSERT_TRUE(batch->write(again, from_lines(coverages[1]), also_in));
+		ASSERT_EQ(ids[1], again);
+
+		ASSERT_FALSE(batch->contains(ids[0]));
+		ASSERT_TRUE(batch->contains(ids[1]));
+		ASSERT_FALSE(batch->lookup<cov::line_coverage>(ids[1]));
+		ASSERT_EQ((backend_write_stats{.written = 3, .skipped = 2}),
+		          batch->write_stats());
+		ASSERT_TRUE(io::open_packs(pack_dir).empty());
+
+		ASSERT_FALSE(batch->commit());
+		auto const packs = io::open_packs(pack_dir);
+		ASSERT_EQ(1u, packs.size());
+		ASSERT_EQ(3u, packs.front().size());
+		ASSERT_FALSE(packs.front().find(ids[0]));
+
+		auto packed = backend::pack_backend(pack_dir);
+		for (size_t index = 1; index < ids.size(); ++index) {
+			auto cvg_lines = packed->lookup<cov::line_coverage>(ids[index]);
+			ASSERT_TRUE(cvg_lines) << ids[index].str();
+			unsigned finish{0};
+			ASSERT_EQ(coverages[index],
+			          from_coverage(cvg_lines->coverage(), finish));
+		}
+	}
+
+	TEST(pack, batch_rollback) {
+		prepare_dir("pack_batch_rollback"sv);
+		auto const root = setup::test_dir() / "pack_batch_rollback"sv;
+		auto const pack_dir = root / "pack"sv;
+
+		auto batch =
+		    backend::pack_batch(pack_dir, io::pack_storage::uncompressed);
+		ASSERT_TRUE(batch);
+		git::oid id{};
+		ASSERT_TRUE(batch->write(id, from_lines(coverages[0])));
+		batch->rollback();
+
+		ASSERT_EQ(backend_write_stats{}, batch->write_stats());
+		ASSERT_TRUE(io::open_packs(pack_dir).empty());
+		ASSERT_EQ(0u, count_loose(root));
+		std::error_code ec{};
+		ASSERT_TRUE(std::filesystem::is_empty(pack_dir, ec));
+
+		// nothing written, nothing to commit
+		auto empty =
+		    backend::pack_batch(pack_dir, io::pack_storage::compressed);
+		ASSERT_TRUE(empty);
+		ASSERT_FALSE(empty->commit());
+		ASSERT_TRUE(std::filesystem::is_empty(pack_dir, ec));
+	}
+
+	TEST(pack, nothing_to_pack) {
+		prepare_dir("pack_nothing"sv);
+		auto const root = setup::test_dir() / "pack_nothing"sv;
+
+		std::error_code ec{};
+		auto const stats = io::repack(root, root / "pack"sv, ec);
+		ASSERT_FALSE(ec);
+		ASSERT_EQ(0u, stats.packed_objects);
+		ASSERT_FALSE(std::filesystem::exists(root / "pack"sv));
+	}
+
+	TEST(pack, broken_index) {
+		std::error_code ec{};
+		path_info::op(
+		    make_setup(remove_all("pack_broken"sv),
+		               touch("pack_broken/pack-short.idx"sv, "pidx"sv),
+		               touch("pack_broken/pack-short.pack"sv, "pack"sv)),
+		    ec);
+		ASSERT_FALSE(ec);
+
+		auto const pack_dir = setup::test_dir() / "pack_broken"sv;
+		ASSERT_TRUE(io::open_packs(pack_dir).empty());
+
+		git::oid id{};
+		ASSERT_EQ(0, git_oid_fromstr(
+		                 &id.id, "2b875786ee42e4141e8004ff9a91fc212b00f1f5"));
+		auto packed = backend::pack_backend(pack_dir);
+		ASSERT_FALSE(packed->lookup<cov::line_coverage>(id));
+	}
+
+	TEST(pack, keep_unreadable_loose) {
+		prepare_dir("pack_unreadable"sv);
+		auto const root = setup::test_dir() / "pack_unreadable"sv;
+		auto const pack_dir = root / "pack"sv;
+
+		auto loose = backend::loose_backend(root);
+		std::vector<git::oid> ids{};
+		write_loose(loose, coverages[0], ids);
+
+		// an object, which cannot be opened, must not be removed with
+		// the ones, which were packed
+		auto const unreadable = git::oid::from(
+		    "0123456789abcdef0123456789abcdef01234567"sv);
+		auto const unreadable_path = root / unreadable.path();
+		std::error_code ec{};
+		std::filesystem::create_directories(unreadable_path.parent_path(),
+		                                    ec);
+		ASSERT_FALSE(ec);
+		std::filesystem::create_symlink(root / "missing"sv, unreadable_path,
+		                                ec);
+		if (ec) GTEST_SKIP() << "cannot create symlinks: " << ec.message();
+
+		auto const stats = io::repack(root, pack_dir, ec);
+		ASSERT_FALSE(ec) << "   Error: " << ec.message() << " ("
+		                 << ec.category().name() << ')';
+		ASSERT_EQ(1u, stats.loose_objects);
+		ASSERT_EQ(1u, stats.packed_objects);
+		ASSERT_TRUE(std::filesystem::is_symlink(unreadable_path, ec));
+		check_packed(backend::pack_backend(pack_dir), ids);
+	}
+}  // namespace cov::testing
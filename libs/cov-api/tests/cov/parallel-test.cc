@@ -0,0 +1,72 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <gtest/gtest.h>
+#include <cov/parallel.hh>
+#include <numeric>
+#include <stdexcept>
+
+namespace cov::testing {
+	TEST(parallel, each_index_once) {
+		for (unsigned jobs : {0u, 1u, 2u, 8u, 100u}) {
+			std::vector<unsigned> visits(50);
+			parallel_for(visits.size(), jobs,
+			             [&](size_t index) { ++visits[index]; });
+			for (auto count : visits)
+				ASSERT_EQ(1u, count) << "jobs: " << jobs;
+		}
+	}
+
+	TEST(parallel, results_in_order) {
+		std::vector<size_t> squares(1000);
+		parallel_for(squares.size(), 4,
+		             [&](size_t index) { squares[index] = index * index; });
+		for (size_t index = 0; index < squares.size(); ++index)
+			ASSERT_EQ(index * index, squares[index]);
+	}
+
+	TEST(parallel, nothing_to_do) {
+		bool called = false;
+		parallel_for(0, 4, [&](size_t) { called = true; });
+		ASSERT_FALSE(called);
+	}
+
+	TEST(parallel, rethrows) {
+		std::atomic<size_t> calls{0};
+		ASSERT_THROW(parallel_for(100, 4,
+		                          [&](size_t index) {
+			                          ++calls;
+			                          if (index == 10)
+				                          throw std::runtime_error{"index"};
+		                          }),
+		             std::runtime_error);
+		ASSERT_LE(11u, calls.load());
+	}
+
+	TEST(parallel, workers) {
+		for (unsigned jobs : {0u, 1u, 3u, 100u}) {
+			auto const workers = parallel_workers(50, jobs);
+			ASSERT_LE(1u, workers) << "jobs: " << jobs;
+			ASSERT_GE(50u, workers) << "jobs: " << jobs;
+
+			std::vector<std::atomic<unsigned>> busy(workers);
+			std::vector<unsigned> visits(50);
+			std::atomic<bool> shared{false};
+			parallel_for(visits.size(), jobs,
+			             [&](size_t index, unsigned worker) {
+				             if (worker >= busy.size()) {
+					             shared = true;
+					             return;
+				             }
+				             if (busy[worker]++) shared = true;
+				             ++visits[index];
+				             --busy[worker];
+			             });
+			ASSERT_FALSE(shared) << "jobs: " << jobs;
+			for (auto count : visits)
+				ASSERT_EQ(1u, count) << "jobs: " << jobs;
+		}
+	}
+
+	TEST(parallel, hardware_jobs) { ASSERT_LE(1u, hardware_jobs()); }
+}  // namespace cov::testing
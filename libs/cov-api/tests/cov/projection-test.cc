@@ -300,6 +300,10 @@ namespace cov::projection::testing {
 			auto expected = make_entries(expected_entries);
 			ASSERT_EQ(expected, actual)
 			    << loc.file_name() << ':' << loc.line() << ": see test";
+
+			auto const index = report_index{files, mods.get()};
+			ASSERT_EQ(expected, filter.project(index))
+			    << loc.file_name() << ':' << loc.line() << ": see test";
 		}
 	};
 
@@ -0,0 +1,150 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <gtest/gtest.h>
+#include <cov/io/report_graph.hh>
+#include <filesystem>
+#include <vector>
+#include "setup.hh"
+
+namespace cov::testing {
+	using namespace std::literals;
+	using namespace git::literals;
+	using io::report_graph;
+
+	namespace {
+		auto const first = "0123456789abcdef0123456789abcdef01234567"_oid;
+		auto const second = "fedcba9876543210fedcba9876543210fedcba98"_oid;
+		auto const third = "8888888888888888888888888888888888888888"_oid;
+		auto const fourth = "0000000000000000000000000000000000000001"_oid;
+		auto const missing = "4444444444444444444444444444444444444444"_oid;
+
+		report_graph::node node(git::oid const& id,
+		                        git::oid const& parent,
+		                        unsigned seconds) {
+			auto stats = io::v1::coverage_stats::init();
+			stats.lines_total = seconds * 10;
+			stats.lines = {seconds * 2, seconds};
+			return {
+			    .id = id,
+			    .parent = parent,
+			    .commit_time = sys_seconds{std::chrono::seconds{seconds}},
+			    .add_time = sys_seconds{std::chrono::seconds{seconds + 1}},
+			    .stats = stats,
+			};
+		}
+
+		std::filesystem::path graph_path(std::string_view dirname) {
+			auto const dir = setup::test_dir() / dirname;
+			std::error_code ec{};
+			std::filesystem::remove_all(dir, ec);
+			return dir / "info"sv / "report-graph"sv;
+		}
+
+		report_graph store(std::filesystem::path const& path,
+		                   report_graph&& current,
+		                   std::vector<report_graph::node> const& added) {
+			auto const contents = current.merged(added);
+			// some systems would not replace a mapped file
+			current = {};
+			auto const ec = report_graph::store(
+			    path, {contents.data(), contents.size()});
+			if (ec) return {};
+			return report_graph::open(path);
+		}
+
+		git::oid parent_id(report_graph const& graph, git::oid const& id) {
+			auto const index = graph.find(id);
+			if (!index) return missing;
+			auto const parent = graph.parent_of(*index);
+			if (!parent) return {};
+			return git::oid{graph.id_at(*parent)};
+		}
+	}  // namespace
+
+	TEST(report_graph, missing_file) {
+		auto const graph = report_graph::open(graph_path("graph_missing"sv));
+		ASSERT_FALSE(graph);
+		ASSERT_EQ(0u, graph.size());
+		ASSERT_FALSE(graph.find(first));
+	}
+
+	TEST(report_graph, store_and_find) {
+		auto const path = graph_path("graph_store"sv);
+		auto const graph = store(path, {},
+		                         {
+		                             node(third, second, 3),
+		                             node(first, {}, 1),
+		                             node(second, first, 2),
+		                         });
+		ASSERT_TRUE(graph);
+		ASSERT_EQ(3u, graph.size());
+		ASSERT_FALSE(graph.find(missing));
+
+		auto const index = graph.find(third);
+		ASSERT_TRUE(index);
+		auto const& entry = graph.entry_at(*index);
+		ASSERT_EQ(sys_seconds{3s}, entry.commit.to_seconds());
+		ASSERT_EQ(sys_seconds{4s}, entry.added.to_seconds());
+		ASSERT_EQ(30u, entry.stats.lines_total);
+		ASSERT_EQ(6u, entry.stats.lines.relevant);
+		ASSERT_EQ(3u, entry.stats.lines.visited);
+
+		ASSERT_EQ(second, parent_id(graph, third));
+		ASSERT_EQ(first, parent_id(graph, second));
+		auto const root = graph.find(first);
+		ASSERT_TRUE(root);
+		ASSERT_FALSE(graph.has_parent(*root));
+		ASSERT_FALSE(graph.parent_of(*root));
+	}
+
+	TEST(report_graph, merge_keeps_parents) {
+		auto const path = graph_path("graph_merge"sv);
+		auto graph = store(path, {},
+		                   {
+		                       node(second, first, 2),
+		                       node(first, {}, 1),
+		                   });
+		ASSERT_EQ(2u, graph.size());
+
+		// the new report sorts before both of the current ones, so all
+		// parent indices need to move
+		graph = store(path, std::move(graph),
+		              {
+		                  node(fourth, third, 4),
+		                  node(third, second, 3),
+		                  node(second, first, 2),
+		              });
+		ASSERT_TRUE(graph);
+		ASSERT_EQ(4u, graph.size());
+		ASSERT_EQ(third, parent_id(graph, fourth));
+		ASSERT_EQ(second, parent_id(graph, third));
+		ASSERT_EQ(first, parent_id(graph, second));
+		ASSERT_FALSE(graph.has_parent(*graph.find(first)));
+	}
+
+	TEST(report_graph, parent_outside) {
+		auto const path = graph_path("graph_outside"sv);
+		auto const graph = store(path, {}, {node(second, missing, 2)});
+		ASSERT_TRUE(graph);
+
+		auto const index = graph.find(second);
+		ASSERT_TRUE(index);
+		ASSERT_TRUE(graph.has_parent(*index));
+		ASSERT_FALSE(graph.parent_of(*index));
+		ASSERT_EQ(io::v1::graph_entry::outside,
+		          graph.entry_at(*index).parent);
+	}
+
+	TEST(report_graph, bad_file) {
+		auto const path = graph_path("graph_bad"sv);
+		{
+			auto const graph = store(path, {}, {node(first, {}, 1)});
+			ASSERT_TRUE(graph);
+		}
+
+		std::filesystem::resize_file(path,
+		                             std::filesystem::file_size(path) - 1);
+		ASSERT_FALSE(report_graph::open(path));
+	}
+}  // namespace cov::testing
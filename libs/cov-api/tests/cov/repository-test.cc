@@ -740,4 +740,80 @@ It has two lines.
 		ASSERT_TRUE(ec);
 		ASSERT_FALSE(blob);
 	}
+
+	TEST_F(repository, auto_repack) {
+		git::init init{};
+
+		run_setup(make_setup(
+		    remove_all("repository"sv), init_git_workspace("repository"sv),
+		    init_repo("repository/.covdata"sv, "repository/.git"sv)));
+
+		std::error_code ec{};
+		auto repo = cov::repository::open(
+		    setup::test_dir() / "sysroot"sv,
+		    setup::test_dir() / "repository/.covdata"sv, ec);
+		ASSERT_FALSE(ec);
+		ASSERT_FALSE(repo.config().set_unsigned("pack.autoPackLimit", 2));
+
+		auto const pack_dir =
+		    setup::test_dir() / "repository/.covdata/objects/coverage/pack"sv;
+
+		std::vector<git::oid> ids{};
+		for (unsigned pack = 1; pack <= 3; ++pack) {
+			ASSERT_TRUE(repo.begin_batch());
+			git::oid id{};
+			ASSERT_TRUE(repo.write(id, from_lines({{pack, pack}})));
+			ids.push_back(id);
+			ASSERT_FALSE(repo.commit_batch());
+
+			// third pack is over the limit, so all three are merged
+			ASSERT_EQ(pack < 3 ? pack : 1u,
+			          io::pack_indices(pack_dir).size());
+		}
+
+		for (auto const& id : ids) {
+			ASSERT_TRUE(repo.lookup<cov::line_coverage>(id, ec));
+			ASSERT_FALSE(ec);
+		}
+	}
+
+	TEST_F(repository, partial_in_loose_and_packed) {
+		git::init init{};
+
+		run_setup(make_setup(
+		    remove_all("repository"sv), init_git_workspace("repository"sv),
+		    init_repo("repository/.covdata"sv, "repository/.git"sv)));
+
+		std::error_code ec{};
+		auto repo = cov::repository::open(
+		    setup::test_dir() / "sysroot"sv,
+		    setup::test_dir() / "repository/.covdata"sv, ec);
+		ASSERT_FALSE(ec);
+
+		git::oid packed_id{};
+		ASSERT_TRUE(repo.write(packed_id, from_lines({{1, 1}, {2, 0}})));
+		repo.repack(ec);
+		ASSERT_FALSE(ec);
+
+		git::oid loose_id{};
+		ASSERT_TRUE(repo.write(loose_id, from_lines({{10, 15}, {11, 0}})));
+
+		// rename the loose object, so that it shares first ten characters
+		// with the packed one
+		auto const objects =
+		    setup::test_dir() / "repository/.covdata/objects/coverage"sv;
+		auto const packed_str = packed_id.str();
+		auto const twin_id = git::oid::from(packed_str.substr(0, 10) +
+		                                    loose_id.str().substr(10));
+		std::filesystem::create_directories(
+		    (objects / twin_id.path()).parent_path(), ec);
+		std::filesystem::rename(objects / loose_id.path(),
+		                        objects / twin_id.path(), ec);
+		ASSERT_FALSE(ec);
+
+		ASSERT_FALSE(repo.find_partial(packed_str.substr(0, 10)));
+		ASSERT_TRUE(is_a<cov::line_coverage>(repo.find_partial(packed_str)));
+		ASSERT_TRUE(
+		    is_a<cov::line_coverage>(repo.find_partial(twin_id.str())));
+	}
 }  // namespace cov::testing
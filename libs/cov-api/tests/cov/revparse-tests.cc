@@ -249,6 +249,35 @@ namespace cov::testing {
 		ASSERT_TRUE(ec);
 	}
 
+	TEST_F(revparse, report_graph) {
+		static constexpr std::string_view tips[] = {"T"sv, "A"sv, "I"sv,
+		                                            "P"sv};
+		for (auto const tip : tips) {
+			auto const ref = repo.refs()->dwim(tip);
+			ASSERT_TRUE(ref);
+			ASSERT_TRUE(ref->direct_target());
+			ASSERT_FALSE(repo.update_report_graph(*ref->direct_target()));
+		}
+		ASSERT_EQ(26u, repo.report_graph().size());
+
+		for (char tag = 'A'; tag <= 'Z'; ++tag) {
+			auto const ref = repo.refs()->dwim({&tag, 1});
+			ASSERT_TRUE(ref) << tag;
+			ASSERT_TRUE(ref->direct_target()) << tag;
+			auto const& id = *ref->direct_target();
+
+			std::error_code ec{};
+			auto const report = repo.lookup<cov::report>(id, ec);
+			ASSERT_FALSE(ec) << tag;
+			ASSERT_TRUE(report) << tag;
+
+			ASSERT_TRUE(revs::is_report(repo, id)) << tag;
+			auto const parent = repo.parent_report(id);
+			ASSERT_TRUE(parent) << tag;
+			ASSERT_EQ(report->parent_id(), *parent) << tag;
+		}
+	}
+
 	struct pair {
 		std::string from{}, to{};
 		bool single{};
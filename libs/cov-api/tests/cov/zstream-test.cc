@@ -81,6 +81,33 @@ namespace cov::testing {
 		run(cov::zstream::inflate, zipped, text);
 	}
 
+	TEST_P(zstream, gzip_roundtrip) {
+		auto const [_, text, zipped] = GetParam();
+		buffer_zstream out{cov::zstream::deflate, cov::zstream::gzip};
+		out.append({text.data(), text.size()});
+		auto const gzipped = out.close();
+		ASSERT_LE(2u, gzipped.data.size());
+		// gzip magic instead of zlib header
+		ASSERT_EQ(std::byte{0x1f}, gzipped.data[0]);
+		ASSERT_EQ(std::byte{0x8b}, gzipped.data[1]);
+
+		buffer_zstream in{cov::zstream::inflate, cov::zstream::gzip};
+		in.append(gzipped.bytes());
+		auto const block = in.close();
+		ASSERT_TRUE(in.complete());
+		ASSERT_EQ(text, (std::string_view{
+		                    reinterpret_cast<char const*>(block.data.data()),
+		                    block.data.size()}));
+	}
+
+	TEST_P(zstream, truncated) {
+		auto const [_, text, zipped] = GetParam();
+		buffer_zstream z{cov::zstream::inflate};
+		z.append({zipped.data(), zipped.size() - 1});
+		z.close();
+		ASSERT_FALSE(z.complete());
+	}
+
 	namespace {
 		template <size_t Length>
 		constexpr std::basic_string_view<unsigned char> span(
@@ -3,10 +3,10 @@
 
 #pragma once
 
+#include <cov/core/highlight_cache.hh>
 #include <cov/io/types.hh>
 #include <cov/report.hh>
 #include <hilite/lighter.hh>
-#include <map>
 #include <optional>
 #include <span>
 #include <string>
@@ -18,6 +18,8 @@ namespace cov::core {
 	struct view_columns {
 		size_t line_no_width;
 		size_t count_width;
+		// zero, if there are no branches in the file
+		size_t branch_width{};
 	};
 
 	struct aliased_name {
@@ -26,8 +28,15 @@ namespace cov::core {
 	};
 
 	struct cvg_info {
-		std::map<unsigned, unsigned> coverage{};
+		// stored counts have 31 bits, they never reach this value
+		static constexpr unsigned not_counted = ~0u;
+
+		// indexed by line, ends on the last counted line; lines without
+		// any code are `not_counted`
+		std::vector<unsigned> coverage{};
 		std::vector<cov::function_coverage::function> functions{};
+		// indexed by line, so printing a line does not search for it
+		std::vector<io::v1::stats> branches{};
 		std::vector<std::pair<unsigned, unsigned>> chunks{};
 		std::string_view file_text{};
 		lighter::highlights syntax{};
@@ -36,15 +45,36 @@ namespace cov::core {
 			return {functions};
 		}
 
+		// coverage reaching past `line_count` is broken and gives an empty
+		// table, instead of one as large as the broken line number
 		static cvg_info from_coverage(
-		    std::span<io::v1::coverage const> const& lines);
+		    std::span<io::v1::coverage const> const& lines,
+		    unsigned line_count);
 		void add_functions(cov::function_coverage const& functions);
+		void add_branches(cov::branch_coverage const& branches);
 		void find_chunks();
+		// highlights only the chunks, if there are any
 		void load_syntax(std::string_view text, std::string_view filename);
+		// the whole blob is tokenized once and stored in the cache; the
+		// chunks, if there are any, use the checkpoints stored for the blob
+		void load_syntax(std::string_view text,
+		                 std::string_view filename,
+		                 git::oid_view blob,
+		                 highlight_cache const& cache);
+		void use_syntax(std::string_view text, lighter::highlights&& hl);
 		view_columns column_widths() const noexcept;
 
 		std::optional<unsigned> max_count() const noexcept;
-		std::optional<unsigned> count_for(unsigned line_no) const noexcept;
+		std::optional<unsigned> count_for(unsigned line_no) const noexcept {
+			if (line_no >= coverage.size() ||
+			    coverage[line_no] == not_counted)
+				return std::nullopt;
+			return coverage[line_no];
+		}
+		io::v1::stats branches_for(unsigned line_no) const noexcept {
+			return line_no < branches.size() ? branches[line_no]
+			                                 : io::v1::stats::init();
+		}
 
 		bool has_line(size_t line_no) const noexcept {
 			return syntax.lines.size() > line_no;
@@ -0,0 +1,84 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cov/git2/oid.hh>
+#include <cstdint>
+#include <filesystem>
+#include <hilite/lighter.hh>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace cov {
+	struct repository;
+}  // namespace cov
+
+namespace cov::core {
+	// Highlights of the source blobs, kept under the cov directory, so the
+	// same contents are tokenized once and not for every report showing
+	// them. Views of chunks use the checkpoints of a blob instead, kept
+	// next to its highlights. Loading an entry touches it; storing a new
+	// one may remove the least recently touched entries, until the cache
+	// fits in its budget.
+	class highlight_cache {
+	public:
+		static constexpr std::uintmax_t default_budget = 64 * 1024 * 1024;
+
+		highlight_cache() = default;
+		highlight_cache(std::filesystem::path dir, std::uintmax_t budget)
+		    : dir_{std::move(dir)}, budget_{budget} {}
+
+		// reads core.highlightCacheSize, where zero turns the cache off
+		static highlight_cache open(cov::repository const& repo);
+
+		bool enabled() const noexcept { return budget_ && !dir_.empty(); }
+
+		std::optional<lighter::highlights> load(
+		    git::oid_view blob,
+		    std::string_view syntax,
+		    std::size_t contents_length) const;
+		std::optional<lighter::checkpoints> load_checkpoints(
+		    git::oid_view blob,
+		    std::string_view syntax,
+		    std::size_t contents_length) const;
+		void store(git::oid_view blob,
+		           std::string_view syntax,
+		           lighter::highlights const& highlights) const;
+		void store(git::oid_view blob,
+		           std::string_view syntax,
+		           lighter::checkpoints const& table) const;
+
+		// highlights of the whole blob, tokenized only if not stored yet
+		lighter::highlights highlight(git::oid_view blob,
+		                              std::string_view contents,
+		                              std::string_view filename) const;
+		// highlights of the sorted, inclusive `ranges`; stored highlights
+		// of the whole blob are used, if there are any, but a miss only
+		// tokenizes the lines around the ranges, with the checkpoints
+		// stored after the first pass over the blob
+		lighter::highlights highlight(git::oid_view blob,
+		                              std::string_view contents,
+		                              std::string_view filename,
+		                              lighter::line_ranges ranges) const;
+
+	private:
+		std::filesystem::path path_of(git::oid_view blob,
+		                              std::string_view syntax,
+		                              std::string_view ext = {}) const;
+		// the whole file, if its header matches
+		std::optional<std::vector<std::byte>> load_entry(
+		    std::filesystem::path const& path,
+		    std::uint32_t magic) const;
+		static void touch(std::filesystem::path const& path);
+		void store_entry(std::filesystem::path const& path,
+		                 std::uint32_t magic,
+		                 std::vector<std::byte> const& data) const;
+		// returns the size of what is left in the cache
+		std::uintmax_t evict() const;
+
+		std::filesystem::path dir_{};
+		std::uintmax_t budget_{};
+	};
+}  // namespace cov::core
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <cov/io/types.hh>
 #include <hilite/lighter.hh>
 #include <map>
 #include <optional>
@@ -21,4 +22,7 @@ namespace cov::core::line_printer {
 	                      bool shortened,
 	                      bool use_color,
 	                      size_t tab_size = 4);
+	std::string branch_column(io::v1::stats const& branches,
+	                          size_t width,
+	                          bool use_color);
 }  // namespace cov::core::line_printer
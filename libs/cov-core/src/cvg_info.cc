@@ -26,10 +26,29 @@ namespace cov::core {
 	}
 
 	cvg_info cvg_info::from_coverage(
-	    std::span<io::v1::coverage const> const& lines) {
+	    std::span<io::v1::coverage const> const& lines,
+	    unsigned line_count) {
 		cvg_info result{};
+
+		// first pass finds the size of the table, so it is only allocated
+		// once; null runs after the last counted line do not grow it
+		size_t size = 0;
+		{
+			size_t line = 0;
+			for (auto&& cvg : lines) {
+				if (cvg.is_null) {
+					line += cvg.value;
+					continue;
+				}
+				line++;
+				if (line > line_count) return result;
+				size = line + 1;
+			}
+		}
+
+		result.coverage.assign(size, not_counted);
 		{
-			unsigned line = 0;
+			size_t line = 0;
 			for (auto&& cvg : lines) {
 				if (cvg.is_null) {
 					line += cvg.value;
@@ -47,6 +66,27 @@ namespace cov::core {
 		functions = input.merge_aliases();
 	}
 
+	void cvg_info::add_branches(cov::branch_coverage const& input) {
+		// branches are only shown next to counted lines; this also keeps
+		// a broken line number from growing the table out of proportion
+		auto const line_count = coverage.size();
+
+		branches.clear();
+		auto cursor = input.lines();
+		while (cursor.next()) {
+			auto const line = cursor.line();
+			if (line >= line_count) break;
+			if (branches.size() <= line)
+				branches.resize(line + 1, io::v1::stats::init());
+			auto& stats = branches[line];
+			for (auto const& branch : cursor.branches()) {
+				stats.relevant = io::add_u32(stats.relevant, 2);
+				if (branch.taken) io::inc_u32(stats.visited);
+				if (branch.not_taken) io::inc_u32(stats.visited);
+			}
+		}
+	}
+
 	void cvg_info::find_chunks() {
 		chunks.clear();
 		auto fn = funcs();
@@ -67,10 +107,13 @@ namespace cov::core {
 			}
 		};
 
-		for (auto [line, count] : coverage) {
+		for (unsigned line = 0; line < coverage.size(); ++line) {
+			auto const count = coverage[line];
+			if (count == not_counted) continue;
 			fn.before(line, mark_functions);
 			fn.at(line, mark_functions);
-			if (!count) {
+			auto const missed = branches_for(line);
+			if (!count || missed.visited < missed.relevant) {
 				mark_line(line);
 			}
 		}
@@ -79,8 +122,33 @@ namespace cov::core {
 
 	void cvg_info::load_syntax(std::string_view text,
 	                           std::string_view filename) {
+		// with no chunks, the whole file is printed; the checkpoints are
+		// not kept, as a view needs them once
+		lighter::checkpoints table{};
+		use_syntax(text,
+		           chunks.empty()
+		               ? lighter::highlights::from(text, filename)
+		               : lighter::highlights::from(text, filename, chunks,
+		                                           table));
+	}
+
+	void cvg_info::load_syntax(std::string_view text,
+	                           std::string_view filename,
+	                           git::oid_view blob,
+	                           highlight_cache const& cache) {
+		if (!cache.enabled()) {
+			load_syntax(text, filename);
+			return;
+		}
+		use_syntax(text, chunks.empty()
+		                     ? cache.highlight(blob, text, filename)
+		                     : cache.highlight(blob, text, filename, chunks));
+	}
+
+	void cvg_info::use_syntax(std::string_view text,
+	                          lighter::highlights&& hl) {
 		file_text = text;
-		syntax = lighter::highlights::from(text, filename);
+		syntax = std::move(hl);
 		if (!syntax.lines.empty() && syntax.lines.back().contents.empty()) {
 			syntax.lines.pop_back();
 		}
@@ -94,10 +162,8 @@ namespace cov::core {
 
 		for (auto const& [start, stop] : chunks) {
 			for (auto line_no = start; line_no <= stop; ++line_no) {
-				auto it = coverage.find(line_no);
-				if (it != coverage.end())
-					result =
-					    result ? std::max(*result, it->second) : it->second;
+				auto const count = count_for(line_no);
+				if (count) result = result ? std::max(*result, *count) : count;
 			}
 		}
 
@@ -112,20 +178,22 @@ namespace cov::core {
 
 	view_columns cvg_info::column_widths() const noexcept {
 		auto max = max_count();
+
+		size_t branch_width{};
+		for (auto const& stats : branches) {
+			if (!stats.relevant) continue;
+			branch_width = std::max(branch_width,
+			                        column_width(stats.visited) + 1 +
+			                            column_width(stats.relevant));
+		}
+
 		return {
 		    .line_no_width = column_width(chunks.back().second + 1),
 		    .count_width = max ? column_width(*max) : 0,
+		    .branch_width = branch_width,
 		};
 	}
 
-	std::optional<unsigned> cvg_info::count_for(
-	    unsigned line_no) const noexcept {
-		std::optional<unsigned> count = std::nullopt;
-		auto it = coverage.find(line_no);
-		if (it != coverage.end()) count = it->second;
-		return count;
-	}
-
 	std::vector<aliased_name> cvg_info::soft_alias(
 	    cov::function_coverage::function const& fn) {
 		std::vector<aliased_name> result{};
@@ -153,6 +221,7 @@ namespace cov::core {
 			// GCOV_EXCL_START -- TODO: Add pty to test_driver
 			max_width -= std::min(max_width, widths.count_width);
 			max_width -= std::min(max_width, widths.line_no_width);
+			max_width -= std::min(max_width, widths.branch_width);
 			max_width -= std::min(max_width, margins);
 			max_width = std::max(max_width, MAGIC);
 			// GCOV_EXCL_STOP
@@ -179,7 +248,9 @@ namespace cov::core {
 		return fmt::format(
 		    // GCOV_EXCL_START
 		    "{} {:>{}} |{} {}", prefix, count_column,
-		    widths.line_no_width + 3 + widths.count_width + 1, suffix,
+		    widths.line_no_width + 3 + widths.count_width + 1 +
+		        (widths.branch_width ? widths.branch_width + 3 : 0),
+		    suffix,
 		    // GCOV_EXCL_STOP
 		    line_printer::to_string(total_count, name, shorten, use_color));
 	}
@@ -193,10 +264,17 @@ namespace cov::core {
 		auto const line_text = file_text.substr(line.start, length);
 
 		auto const count_column = count ? fmt::format("{}x", *count) : " "s;
+		auto const branch_column =
+		    widths.branch_width
+		        ? fmt::format(" {} |", line_printer::branch_column(
+		                                   branches_for(
+		                                       static_cast<unsigned>(line_no)),
+		                                   widths.branch_width, use_color))
+		        : ""s;
 		return fmt::format(
 		    // GCOV_EXCL_START
-		    " {:>{}} | {:>{}} | {}", line_no + 1, widths.line_no_width,
-		    count_column, widths.count_width + 1,
+		    " {:>{}} | {:>{}} |{} {}", line_no + 1, widths.line_no_width,
+		    count_column, widths.count_width + 1, branch_column,
 		    line_printer::to_string(count, line_text, line.contents,
 		                            // GCOV_EXCL_STOP
 		                            syntax.dict, use_color));
@@ -0,0 +1,253 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cov/core/highlight_cache.hh>
+#include <cov/io/file.hh>
+#include <cov/io/safe_stream.hh>
+#include <cov/io/types.hh>
+#include <cov/repository.hh>
+#include <cstring>
+#include <vector>
+
+namespace cov::core {
+	using namespace std::literals;
+
+	namespace {
+		enum : std::uint32_t {
+			HIGHLIGHTS = "hlgt"_tag,
+			CHECKPOINTS = "hlcp"_tag,
+		};
+
+		struct cache_header {
+			io::file_header file;
+			std::uint32_t lighter_version;
+		};
+
+		constexpr auto cache_dir = "highlights"sv;
+		constexpr auto checkpoints_ext = "checkpoints"sv;
+		// kept next to the entry directories, so the scans skip it
+		constexpr auto estimate_file = "size"sv;
+		// other processes may add entries without updating the estimate
+		constexpr std::uint64_t rescan_every = 64;
+
+		struct size_estimate {
+			std::uint64_t bytes;
+			std::uint64_t stores;
+		};
+
+		std::optional<size_estimate> read_estimate(
+		    std::filesystem::path const& path) {
+			auto const in = io::fopen(path, "rb");
+			if (!in) return std::nullopt;
+			auto const data = in.read();
+			size_estimate result{};
+			if (data.size() != sizeof(result)) return std::nullopt;
+			std::memcpy(&result, data.data(), sizeof(result));
+			return result;
+		}
+
+		void write_estimate(std::filesystem::path const& path,
+		                    size_estimate const& estimate) {
+			auto const out = io::fopen(path, "wb");
+			if (out) out.store(&estimate, sizeof(estimate));
+		}
+
+		bool is_temporary(std::filesystem::path const& path) {
+			// io::safe_stream writes to <stem>_tmpXXXX.<syntax> first
+			return path.stem().string().find("_tmp"sv) != std::string::npos;
+		}
+	}  // namespace
+
+	highlight_cache highlight_cache::open(cov::repository const& repo) {
+		if (repo.common_dir().empty()) return {};
+		return {repo.common_dir() / cache_dir,
+		        repo.config()
+		            .get_unsigned("core.highlightCacheSize")
+		            .value_or(default_budget)};
+	}
+
+	std::optional<lighter::highlights> highlight_cache::load(
+	    git::oid_view blob,
+	    std::string_view syntax,
+	    std::size_t contents_length) const {
+		auto const path = path_of(blob, syntax);
+		auto const data = load_entry(path, HIGHLIGHTS);
+		if (!data) return std::nullopt;
+
+		auto result = lighter::highlights::deserialize(
+		    std::span{*data}.subspan(sizeof(cache_header)), contents_length);
+		if (result) touch(path);
+		return result;
+	}
+
+	std::optional<lighter::checkpoints> highlight_cache::load_checkpoints(
+	    git::oid_view blob,
+	    std::string_view syntax,
+	    std::size_t contents_length) const {
+		auto const path = path_of(blob, syntax, checkpoints_ext);
+		auto const data = load_entry(path, CHECKPOINTS);
+		if (!data) return std::nullopt;
+
+		auto result = lighter::checkpoints::deserialize(
+		    std::span{*data}.subspan(sizeof(cache_header)), contents_length);
+		if (result) touch(path);
+		return result;
+	}
+
+	void highlight_cache::store(git::oid_view blob,
+	                            std::string_view syntax,
+	                            lighter::highlights const& highlights) const {
+		if (!enabled()) return;
+		store_entry(path_of(blob, syntax), HIGHLIGHTS,
+		            highlights.serialize());
+	}
+
+	void highlight_cache::store(git::oid_view blob,
+	                            std::string_view syntax,
+	                            lighter::checkpoints const& table) const {
+		if (!enabled()) return;
+		store_entry(path_of(blob, syntax, checkpoints_ext), CHECKPOINTS,
+		            table.serialize());
+	}
+
+	lighter::highlights highlight_cache::highlight(
+	    git::oid_view blob,
+	    std::string_view contents,
+	    std::string_view filename) const {
+		auto const syntax = lighter::syntax_of(filename);
+		if (auto cached = load(blob, syntax, contents.size()))
+			return std::move(*cached);
+
+		auto result = lighter::highlights::from(contents, filename);
+		store(blob, syntax, result);
+		return result;
+	}
+
+	lighter::highlights highlight_cache::highlight(
+	    git::oid_view blob,
+	    std::string_view contents,
+	    std::string_view filename,
+	    lighter::line_ranges ranges) const {
+		auto const syntax = lighter::syntax_of(filename);
+		if (auto cached = load(blob, syntax, contents.size()))
+			return std::move(*cached);
+
+		// partial highlights are not stored, another view could need
+		// other lines; the checkpoints of the blob are good for any of them
+		auto table = load_checkpoints(blob, syntax, contents.size())
+		                 .value_or(lighter::checkpoints{});
+		auto const had_table = !table.entries.empty();
+		auto result =
+		    lighter::highlights::from(contents, filename, ranges, table);
+		if (!had_table && !table.entries.empty()) store(blob, syntax, table);
+		return result;
+	}
+
+	std::filesystem::path highlight_cache::path_of(
+	    git::oid_view blob,
+	    std::string_view syntax,
+	    std::string_view ext) const {
+		auto name = blob.str();
+		auto const rest = name.substr(2);
+		name.erase(2);
+		if (ext.empty())
+			return dir_ / name / fmt::format("{}.{}", rest, syntax);
+		return dir_ / name / fmt::format("{}.{}.{}", rest, syntax, ext);
+	}
+
+	std::optional<std::vector<std::byte>> highlight_cache::load_entry(
+	    std::filesystem::path const& path,
+	    std::uint32_t magic) const {
+		if (!enabled()) return std::nullopt;
+
+		auto const in = io::fopen(path, "rb");
+		if (!in) return std::nullopt;
+		auto data = in.read();
+
+		cache_header hdr{};
+		if (data.size() < sizeof(hdr)) return std::nullopt;
+		std::memcpy(&hdr, data.data(), sizeof(hdr));
+		if (hdr.file.magic != magic || hdr.file.version != io::v1::VERSION ||
+		    hdr.lighter_version != lighter::version)
+			return std::nullopt;
+		return data;
+	}
+
+	void highlight_cache::touch(std::filesystem::path const& path) {
+		std::error_code ec{};
+		std::filesystem::last_write_time(
+		    path, std::filesystem::file_time_type::clock::now(), ec);
+	}
+
+	void highlight_cache::store_entry(std::filesystem::path const& path,
+	                                  std::uint32_t magic,
+	                                  std::vector<std::byte> const& data) const {
+		cache_header const hdr{
+		    .file = {.magic = magic, .version = io::v1::VERSION},
+		    .lighter_version = lighter::version,
+		};
+
+		io::safe_stream out{path};
+		if (!out.opened()) return;
+		if (!out.store(hdr) || !out.store(data)) {
+			out.rollback();
+			return;
+		}
+		if (out.commit()) return;
+
+		// the directory is only scanned, when the estimate goes over the
+		// budget, or once in a while to notice the entries stored by others
+		auto const estimate_path = dir_ / estimate_file;
+		auto estimate = read_estimate(estimate_path);
+		if (estimate) {
+			estimate->bytes += sizeof(hdr) + data.size();
+			++estimate->stores;
+		}
+		if (!estimate || estimate->bytes > budget_ ||
+		    estimate->stores >= rescan_every)
+			estimate = size_estimate{.bytes = evict(), .stores = 0};
+		write_estimate(estimate_path, *estimate);
+	}
+
+	std::uintmax_t highlight_cache::evict() const {
+		struct entry {
+			std::filesystem::file_time_type touched;
+			std::uintmax_t size;
+			std::filesystem::path path;
+		};
+
+		std::vector<entry> entries{};
+		std::uintmax_t total{};
+		std::error_code ec{};
+		for (auto it = std::filesystem::recursive_directory_iterator{dir_, ec};
+		     !ec && it != std::filesystem::recursive_directory_iterator{};
+		     it.increment(ec)) {
+			if (!it.depth()) continue;
+			std::error_code entry_ec{};
+			if (!it->is_regular_file(entry_ec) || entry_ec) continue;
+			if (is_temporary(it->path())) continue;
+			auto const size = it->file_size(entry_ec);
+			if (entry_ec) continue;
+			auto const touched = it->last_write_time(entry_ec);
+			if (entry_ec) continue;
+			entries.push_back({touched, size, it->path()});
+			total += size;
+		}
+
+		if (total <= budget_) return total;
+
+		std::sort(entries.begin(), entries.end(),
+		          [](entry const& lhs, entry const& rhs) {
+			          return lhs.touched < rhs.touched;
+		          });
+		for (auto const& item : entries) {
+			if (total <= budget_) break;
+			// another process might have removed it already
+			std::filesystem::remove(item.path, ec);
+			total -= item.size;
+		}
+		return total;
+	}
+}  // namespace cov::core
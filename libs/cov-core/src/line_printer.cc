@@ -4,6 +4,7 @@
 #include <array>
 #include <cell/tokens.hh>
 #include <cov/core/line_printer.hh>
+#include <fmt/format.h>
 #include <hilite/hilite.hh>
 #include <hilite/none.hh>
 #include <variant>
@@ -313,4 +314,28 @@ namespace cov::core::line_printer {
 
 		return ctx.result;
 	}
+
+	std::string branch_column(io::v1::stats const& branches,
+	                          size_t width,
+	                          bool use_color) {
+		if (!branches.relevant) return fmt::format("{:>{}}", "", width);
+
+		auto const mark = branches.visited < branches.relevant ? mark::bad
+		                                                       : mark::good;
+		auto const text = fmt::format(
+		    "{:>{}}", fmt::format("{}/{}", branches.visited, branches.relevant),
+		    width);
+		if (!use_color) return text;
+
+		std::map<std::uint32_t, std::string> empty{};
+		context ctx{text, empty, mark, 0, {use_color}};
+		{
+			context::color_stack paint{&ctx, ctx.find_color("text"sv)};
+			ctx.paint_color();
+			ctx.result.append(text);
+		}
+		ctx.paint_color();  // EOL reset
+
+		return ctx.result;
+	}
 }  // namespace cov::core::line_printer
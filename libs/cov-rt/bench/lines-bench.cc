@@ -0,0 +1,90 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
+#include <cov/app/report.hh>
+#include <cov/core/cvg_info.hh>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+	using clock_type = std::chrono::steady_clock;
+
+	constexpr unsigned line_count = 100'000;
+	constexpr unsigned runs = 20;
+
+	template <typename Callback>
+	double best_of(Callback&& cb) {
+		auto best = clock_type::duration::max();
+		for (unsigned run = 0; run < runs; ++run) {
+			auto const start = clock_type::now();
+			cb();
+			best = std::min(best, clock_type::now() - start);
+		}
+		return std::chrono::duration<double, std::milli>(best).count();
+	}
+
+	void measure(std::string_view label, double millis) {
+		fmt::print("  {:<26} {:>8.3f} ms\n", label, millis);
+	}
+
+	// three out of four lines have code, every tenth of them is missed
+	cov::app::report::file_info generate_file() {
+		cov::app::report::file_info result{};
+		result.line_coverage.reserve(line_count);
+		unsigned seed = 0x1234567u;
+		for (unsigned line = 1; line <= line_count; ++line) {
+			seed = seed * 1103515245u + 12345u;
+			if ((seed >> 16) % 4 == 0) continue;
+			auto const hits = (seed >> 8) % 10 ? (seed >> 20) % 1000 + 1 : 0;
+			result.line_coverage.emplace_back(line, hits);
+		}
+		return result;
+	}
+}  // namespace
+
+int main() {
+	auto const file = generate_file();
+	fmt::print("{} lines, {} counted, best of {} runs:\n", line_count,
+	           file.line_coverage.size(), runs);
+
+	size_t sink{};
+
+	// JSON and binary reports may list the lines in any order
+	auto shuffled = file;
+	std::reverse(shuffled.line_coverage.begin(),
+	             shuffled.line_coverage.end());
+	measure("sort_lines", best_of([&] {
+		        auto copy = shuffled;
+		        copy.sort_lines();
+		        sink += copy.line_coverage.size();
+	        }));
+
+	// visit_lines, twice: once to size, once to fill
+	measure("expand_coverage", best_of([&] {
+		        auto [coverage, stats] = file.expand_coverage(line_count);
+		        sink += coverage.size() + stats.lines.visited;
+	        }));
+
+	auto const [coverage, stats] = file.expand_coverage(line_count);
+	measure("cvg_info::from_coverage", best_of([&] {
+		        auto const info = cov::core::cvg_info::from_coverage(
+		            coverage, line_count);
+		        sink += info.coverage.size();
+	        }));
+
+	auto const info =
+	    cov::core::cvg_info::from_coverage(coverage, line_count);
+	measure("cvg_info::count_for", best_of([&] {
+		        for (unsigned line = 1; line <= line_count; ++line) {
+			        if (auto const count = info.count_for(line); count)
+				        sink += *count;
+		        }
+	        }));
+
+	if (sink == 1) fmt::print(" ");
+}
@@ -0,0 +1,16 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cov/app/strings/cov_gc.hh>
+#include <cov/app/tr.hh>
+
+namespace cov::app {
+	using gclng = str::cov_gc::lng;
+	using GcStrings = str::cov_gc::Strings;
+
+	template <>
+	struct lngs_traits<gclng>
+	    : base_lngs_traits<gclng, "cov_gc", GcStrings> {};
+}  // namespace cov::app
@@ -9,11 +9,14 @@
 #include <cov/io/report.hh>
 #include <cov/io/types.hh>
 #include <filesystem>
+#include <functional>
 #include <map>
+#include <span>
 #include <string>
 #include <string_view>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace cov::app::report {
@@ -51,8 +54,11 @@ namespace cov::app::report {
 		std::string name{};
 		report::digest algorithm{digest::unknown};
 		std::string digest{};
-		std::map<unsigned, unsigned> line_coverage{};
+		// sorted by line, each line listed once; a single allocation
+		// instead of a tree node per line
+		std::vector<std::pair<unsigned, unsigned>> line_coverage{};
 		std::vector<function> function_coverage{};
+		std::map<unsigned, std::vector<io::v1::branch>> branch_coverage{};
 		bool operator==(file_info const& rhs) const noexcept = default;
 		auto operator<=>(file_info const& rhs) const noexcept {
 			// without this definition, clang 16 does not like the
@@ -70,9 +76,16 @@ namespace cov::app::report {
 			    cmp != 0) {
 				return cmp;
 			}
-			return function_coverage <=> rhs.function_coverage;
+			if (auto const cmp = function_coverage <=> rhs.function_coverage;
+			    cmp != 0) {
+				return cmp;
+			}
+			return branch_coverage <=> rhs.branch_coverage;
 		}
 		coverage_info expand_coverage(size_t line_count) const;
+		// for lines appended in any order; the last count of a repeated
+		// line is kept, as with the repeated keys of a JSON object
+		void sort_lines();
 	};
 
 	struct git_info {
@@ -87,7 +100,50 @@ namespace cov::app::report {
 
 		bool operator==(report_info const&) const noexcept = default;
 		auto operator<=>(report_info const&) const noexcept = default;
+		// picks JSON or binary reader based on the magic
+		bool load(std::string_view contents);
 		bool load_from_text(std::string_view u8_encoded);
+		bool load_from_binary(std::string_view data);
+		// Reads `gcov --json-format` output, either a single file, or all
+		// the *.gcov.json.gz files found under a directory, on up to `jobs`
+		// threads. Counters of headers are summed over all translation
+		// units; files outside of the work dir are skipped. Git info is
+		// left untouched.
+		bool load_from_gcov(std::filesystem::path const& input,
+		                    std::filesystem::path const& work_dir,
+		                    unsigned jobs);
+		// Reads `llvm-cov export -format=text` output in a single pass over
+		// the mapped file; `jobs` is only used for the digests of sources.
+		// Same as above, files outside of the work dir are skipped and
+		// git info is left untouched.
+		bool load_from_llvm_cov(std::filesystem::path const& input,
+		                        std::filesystem::path const& work_dir,
+		                        unsigned jobs);
+		std::string to_binary() const;
+
+		// Sums the line, function and branch counts of the files with the
+		// same name over all the reports, on up to `jobs` threads. The git
+		// info and the digest of each file are taken from the first report
+		// having it; the files are sorted by name.
+		static report_info merge(std::span<report_info const* const> reports,
+		                         unsigned jobs);
+
+		static bool is_binary(std::string_view contents) noexcept;
+
+		using file_sink = std::function<void(file_info&&)>;
+		// Reads the report one /files[] item at a time, handing each of them
+		// to the sink as soon as it is read, without keeping the whole
+		// document in memory. On false, the files given to the sink so far
+		// should be dropped; the errors are already on stderr.
+		static bool read(std::string_view contents,
+		                 git_info& git,
+		                 file_sink const& on_file);
+		static bool read_from_text(std::string_view u8_encoded,
+		                           git_info& git,
+		                           file_sink const& on_file);
+		static bool read_from_binary(std::string_view data,
+		                             git_info& git,
+		                             file_sink const& on_file);
 	};
 
 	struct git_signature {
@@ -115,6 +171,16 @@ namespace cov::app::report {
 		                         static_cast<underlying>(rhs));
 	}
 
+	enum class matching {
+		none,
+		exactly,
+		with_different_newlines,
+	};
+
+	// compares the hex digest with the data, as-is and with either of the
+	// newline conversions (LF to CRLF or CRLF to LF) applied
+	matching match(digest type, std::string_view hash, git::bytes data);
+
 	struct blob_info {
 		text flags{text::missing};
 		git::oid existing{};
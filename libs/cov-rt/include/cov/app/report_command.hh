@@ -6,6 +6,8 @@
 #include <cov/app/cov_report_tr.hh>
 #include <cov/app/errors_tr.hh>
 #include <cov/app/report.hh>
+#include <cov/io/shared_bytes.hh>
+#include <cov/parallel.hh>
 #include <cov/repository.hh>
 #include <memory>
 #include <string>
@@ -25,20 +27,35 @@ namespace cov::app::builtin::report {
 		parser(::args::args_view const& arguments,
 		       str::translator_open_info const& langs);
 
-		struct parse_results {
-			cov::repository repo{};
+		struct input_report {
 			report_info report{};
 			std::string props{};
 		};
+
+		struct parse_results {
+			cov::repository repo{};
+			// one for each <report-file>, each becoming a separate build
+			std::vector<input_report> inputs{};
+			// line and function counts of all the inputs, summed file by
+			// file; left empty for a single input, which is its own merge
+			report_info merged{};
+
+			report_info const& report() const noexcept {
+				return inputs.size() == 1 ? inputs.front().report : merged;
+			}
+		};
 		parse_results parse();
 
 		std::string report_contents(git::repository_handle repo,
+		                            std::string const& path,
 		                            ::args::arglist args) const;
 
-		std::string_view report_path() const noexcept { return report_; }
 		std::string_view report_filter() const noexcept {
 			return filter_ ? *filter_ : std::string_view{};
 		}
+		unsigned jobs() const noexcept {
+			return jobs_ && *jobs_ ? *jobs_ : hardware_jobs();
+		}
 
 		bool store_build(git::oid& out,
 		                 cov::repository& repo,
@@ -69,6 +86,10 @@ namespace cov::app::builtin::report {
 		                         str::cov_report::Strings const& tr,
 		                         repository const& repo);
 
+		// with --verbose, tells how many objects were written to the
+		// database and how many were already there
+		void print_write_stats(repository const& repo) const;
+
 		template <typename Enum, typename... Args>
 		[[noreturn]] void data_error(Enum id, Args&&... args) const
 		    requires std::is_enum_v<Enum>
@@ -89,10 +110,52 @@ namespace cov::app::builtin::report {
 	private:
 		// isolate this from acces to force clang-format to _not_ fix it to
 		// "private : std::vector"
-		std::vector<std::byte> filter(std::vector<std::byte> const& contents,
-		                              std::string_view filter,
-		                              ::args::arglist args,
-		                              std::filesystem::path const& cwd) const;
+		struct input {
+			std::string path{};
+			// how many of the --prop values were given before this input
+			size_t first_prop{};
+		};
+
+		enum class load_status { ok, not_found, filter_failed, issues };
+
+		// an input read without a filter is mapped, not copied
+		load_status read_input(std::string const& path,
+		                       ::args::arglist args,
+		                       std::filesystem::path const& dir,
+		                       int& return_code,
+		                       ref_ptr<io::shared_bytes>& contents) const;
+		// runs the filter without exiting on its failure, leaving the
+		// message to filter_failed(); returns the exit code of the filter
+		int try_filter(std::vector<std::byte>& contents,
+		               std::string_view filter,
+		               ::args::arglist args,
+		               std::filesystem::path const& cwd) const;
+		[[noreturn]] void filter_failed(int return_code) const;
+		load_status try_load(std::string const& path,
+		                     std::filesystem::path const& dir,
+		                     git_info const& head,
+		                     unsigned jobs,
+		                     ref_ptr<io::shared_bytes>&& contents,
+		                     report_info& out) const;
+		// parses each of the inputs on a thread of its own; errors are
+		// reported in the order of the inputs
+		void load_inputs(git::repository_handle repo,
+		                 ::args::arglist args,
+		                 std::vector<input_report>& out) const;
+		// the --prop values given before the first input, followed by the
+		// ones given after this input
+		std::string input_props(size_t index) const;
+		// the "gcov" and "llvm-cov" filters are read in-process, without
+		// running any external tool; the git info is taken from the HEAD of
+		// the work tree
+		bool import_native(std::string const& path,
+		                   std::filesystem::path const& dir,
+		                   git_info const& head,
+		                   unsigned jobs,
+		                   report_info& out) const;
+		bool is_native() const noexcept {
+			return filter_ && (*filter_ == "gcov" || *filter_ == "llvm-cov");
+		}
 		// visual space
 
 		template <typename Enum1, typename Enum2, typename... Args>
@@ -114,10 +177,12 @@ namespace cov::app::builtin::report {
 
 		std::string quoted_list(std::span<std::string_view const> names);
 
-		std::string report_{};
+		std::vector<input> inputs_{};
 		std::optional<std::string> filter_{};
 		std::vector<std::string> props_{};
 		bool amend_{};
+		std::optional<unsigned> jobs_{};
+		bool verbose_{};
 		std::optional<std::string> output_{};
 	};
 
@@ -137,12 +202,35 @@ namespace cov::app::builtin::report {
 			return result;
 		}
 
+		enum class store_error { none, cannot_write, bare_git, cannot_open };
+
 		static std::vector<stored_file> from(git_commit const& commit,
 		                                     std::vector<file_info> const& info,
-		                                     parser const& p);
+		                                     parser const& p,
+		                                     unsigned jobs = 1);
+		// takes the contents of each file from the files of the merged
+		// report, which were already verified and stored
+		static std::vector<stored_file> from(
+		    std::vector<file_info> const& merged_infos,
+		    std::vector<stored_file> const& merged,
+		    std::vector<file_info> const& info);
 		void store(cov::repository& repo,
 		           file_info const& info,
 		           parser const& p);
+		// without contents, only the coverage is stored, e.g. for builds,
+		// whose files were stored with the merged report
+		static void store(cov::repository& repo,
+		                  std::vector<file_info> const& infos,
+		                  std::vector<stored_file>& files,
+		                  parser const& p,
+		                  unsigned jobs,
+		                  bool with_contents = true);
+		store_error try_store(cov::repository& repo,
+		                      file_info const& info,
+		                      bool with_contents = true);
+		static void report_error(store_error error,
+		                         file_info const& info,
+		                         parser const& p);
 
 		static bool store_tree(git::oid& id,
 		                       cov::repository& repo,
@@ -0,0 +1,322 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include "json_reader.hh"
+#include <charconv>
+
+using namespace std::literals;
+
+namespace cov::app::report {
+	namespace {
+		unsigned hex_digit(char c) noexcept {
+			if (c >= '0' && c <= '9') return static_cast<unsigned>(c - '0');
+			if (c >= 'a' && c <= 'f')
+				return static_cast<unsigned>(c - 'a' + 10);
+			if (c >= 'A' && c <= 'F')
+				return static_cast<unsigned>(c - 'A' + 10);
+			return 16;
+		}
+
+		bool is_digit(char c) noexcept { return c >= '0' && c <= '9'; }
+
+		void append_utf8(std::string& out, char32_t ch) {
+			if (ch < 0x80) {
+				out.push_back(static_cast<char>(ch));
+			} else if (ch < 0x800) {
+				out.push_back(static_cast<char>(0xC0 | (ch >> 6)));
+				out.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
+			} else if (ch < 0x10000) {
+				out.push_back(static_cast<char>(0xE0 | (ch >> 12)));
+				out.push_back(static_cast<char>(0x80 | ((ch >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
+			} else {
+				out.push_back(static_cast<char>(0xF0 | (ch >> 18)));
+				out.push_back(static_cast<char>(0x80 | ((ch >> 12) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | ((ch >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
+			}
+		}
+	}  // namespace
+
+	bool json_reader::finished() noexcept {
+		if (failed_) return false;
+		skip_ws();
+		return needs_comma_.empty() && pos_ == text_.size();
+	}
+
+	json_reader::kind json_reader::peek() noexcept {
+		if (failed_) return kind::none;
+		skip_ws();
+		switch (current()) {
+			case '{':
+				return kind::object;
+			case '[':
+				return kind::array;
+			case '"':
+				return kind::string;
+			case 't':
+			case 'f':
+				return kind::boolean;
+			case 'n':
+				return kind::null;
+			default:
+				if (current() == '-' || is_digit(current()))
+					return kind::number;
+				break;
+		}
+		return kind::none;
+	}
+
+	bool json_reader::enter_object() noexcept {
+		if (!expect('{')) return false;
+		needs_comma_.push_back(false);
+		return true;
+	}
+
+	bool json_reader::next_key(std::string& key) {
+		if (!next_in('}')) return false;
+		skip_ws();
+		key.clear();
+		if (current() != '"' || !string(&key)) return fail();
+		return expect(':');
+	}
+
+	bool json_reader::enter_array() noexcept {
+		if (!expect('[')) return false;
+		needs_comma_.push_back(false);
+		return true;
+	}
+
+	bool json_reader::next_item() noexcept { return next_in(']'); }
+
+	std::optional<std::string> json_reader::read_string() {
+		if (peek() != kind::string) {
+			skip_value();
+			return std::nullopt;
+		}
+		std::string result{};
+		if (!string(&result)) return std::nullopt;
+		return result;
+	}
+
+	std::optional<long long> json_reader::read_integer() {
+		if (peek() != kind::number) {
+			skip_value();
+			return std::nullopt;
+		}
+
+		std::string_view view{};
+		if (!number(view)) return std::nullopt;
+
+		long long result{};
+		auto const first = view.data();
+		auto const last = first + view.size();
+		auto const [ptr, ec] = std::from_chars(first, last, result);
+		if (ptr != last || ec != std::errc{}) return std::nullopt;
+		return result;
+	}
+
+	std::optional<bool> json_reader::read_boolean() {
+		if (peek() != kind::boolean) {
+			skip_value();
+			return std::nullopt;
+		}
+
+		auto const value = current() == 't';
+		if (!literal(value ? "true"sv : "false"sv)) return std::nullopt;
+		return value;
+	}
+
+	void json_reader::skip_value() {
+		switch (peek()) {
+			case kind::object: {
+				enter_object();
+				std::string key{};
+				while (next_key(key))
+					skip_value();
+				break;
+			}
+			case kind::array:
+				enter_array();
+				while (next_item())
+					skip_value();
+				break;
+			case kind::string:
+				string(nullptr);
+				break;
+			case kind::number: {
+				std::string_view ignored{};
+				number(ignored);
+				break;
+			}
+			case kind::boolean:
+				if (current() == 't')
+					literal("true"sv);
+				else
+					literal("false"sv);
+				break;
+			case kind::null:
+				literal("null"sv);
+				break;
+			case kind::none:
+				fail();
+				break;
+		}
+	}
+
+	void json_reader::skip_ws() noexcept {
+		while (pos_ < text_.size()) {
+			switch (text_[pos_]) {
+				case ' ':
+				case '\t':
+				case '\r':
+				case '\n':
+					++pos_;
+					continue;
+				default:
+					break;
+			}
+			break;
+		}
+	}
+
+	bool json_reader::expect(char c) noexcept {
+		if (failed_) return false;
+		skip_ws();
+		if (current() != c) return fail();
+		++pos_;
+		return true;
+	}
+
+	bool json_reader::next_in(char closing) noexcept {
+		if (failed_ || needs_comma_.empty()) return false;
+		skip_ws();
+		if (current() == closing) {
+			++pos_;
+			needs_comma_.pop_back();
+			return false;
+		}
+		if (needs_comma_.back() && !expect(',')) return false;
+		needs_comma_.back() = true;
+		return true;
+	}
+
+	bool json_reader::literal(std::string_view word) noexcept {
+		if (!text_.substr(pos_).starts_with(word)) return fail();
+		pos_ += word.size();
+		return true;
+	}
+
+	bool json_reader::string(std::string* out) {
+		++pos_;  // opening quote
+		while (true) {
+			auto start = pos_;
+			while (pos_ < text_.size() && text_[pos_] != '"' &&
+			       text_[pos_] != '\\' &&
+			       static_cast<unsigned char>(text_[pos_]) >= 0x20)
+				++pos_;
+			if (out) out->append(text_.substr(start, pos_ - start));
+
+			if (pos_ >= text_.size()) return fail();
+			auto const c = text_[pos_++];
+			if (c == '"') return true;
+			if (c != '\\') return fail();
+			if (pos_ >= text_.size()) return fail();
+
+			auto const escaped = text_[pos_++];
+			char simple{};
+			switch (escaped) {
+				case '"':
+				case '\\':
+				case '/':
+					simple = escaped;
+					break;
+				case 'b':
+					simple = '\b';
+					break;
+				case 'f':
+					simple = '\f';
+					break;
+				case 'n':
+					simple = '\n';
+					break;
+				case 'r':
+					simple = '\r';
+					break;
+				case 't':
+					simple = '\t';
+					break;
+				case 'u':
+					break;
+				default:
+					return fail();
+			}
+			if (simple) {
+				if (out) out->push_back(simple);
+				continue;
+			}
+
+			auto const code_unit = [this]() -> char32_t {
+				if (text_.size() - pos_ < 4) return 0x110000;
+				char32_t result{};
+				for (int index = 0; index < 4; ++index) {
+					auto const digit = hex_digit(text_[pos_++]);
+					if (digit > 15) return 0x110000;
+					result = (result << 4) | digit;
+				}
+				return result;
+			};
+
+			auto ch = code_unit();
+			if (ch > 0xFFFF) return fail();
+			if (ch >= 0xD800 && ch < 0xDC00 &&
+			    text_.substr(pos_).starts_with("\\u"sv)) {
+				auto const save = pos_;
+				pos_ += 2;
+				auto const low = code_unit();
+				if (low >= 0xDC00 && low < 0xE000)
+					ch = 0x10000 + ((ch - 0xD800) << 10) + (low - 0xDC00);
+				else
+					pos_ = save;
+			}
+			// unpaired surrogates cannot be represented in UTF-8
+			if (ch >= 0xD800 && ch < 0xE000) ch = 0xFFFD;
+			if (out) append_utf8(*out, ch);
+		}
+	}
+
+	bool json_reader::number(std::string_view& out) noexcept {
+		auto const start = pos_;
+		bool integer = true;
+
+		if (current() == '-') ++pos_;
+		if (current() == '0') {
+			++pos_;
+		} else if (is_digit(current())) {
+			while (is_digit(current()))
+				++pos_;
+		} else {
+			return fail();
+		}
+
+		if (current() == '.') {
+			integer = false;
+			++pos_;
+			if (!is_digit(current())) return fail();
+			while (is_digit(current()))
+				++pos_;
+		}
+
+		if (current() == 'e' || current() == 'E') {
+			integer = false;
+			++pos_;
+			if (current() == '+' || current() == '-') ++pos_;
+			if (!is_digit(current())) return fail();
+			while (is_digit(current()))
+				++pos_;
+		}
+
+		out = integer ? text_.substr(start, pos_ - start) : std::string_view{};
+		return integer;
+	}
+}  // namespace cov::app::report
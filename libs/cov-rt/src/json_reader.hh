@@ -0,0 +1,75 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cov::app::report {
+	// Pull reader over a JSON text. Instead of building a document, the
+	// caller walks the values in the order they appear in the text, taking
+	// out only what it needs and skipping the rest. Any syntax error turns
+	// the reader into failed state, in which every call reports there is
+	// nothing more to read.
+	class json_reader {
+	public:
+		enum class kind {
+			none,
+			object,
+			array,
+			string,
+			number,
+			boolean,
+			null,
+		};
+
+		explicit json_reader(std::string_view text) noexcept : text_{text} {}
+
+		bool failed() const noexcept { return failed_; }
+		// true, if the whole text was read without any errors
+		bool finished() noexcept;
+
+		kind peek() noexcept;
+
+		bool enter_object() noexcept;
+		// reads next member name, returns false after closing brace
+		bool next_key(std::string& key);
+
+		bool enter_array() noexcept;
+		// returns false after closing bracket
+		bool next_item() noexcept;
+
+		std::optional<std::string> read_string();
+		// nullopt for numbers, which are not integers or do not fit in
+		// long long; any other value is skipped and reported as nullopt
+		std::optional<long long> read_integer();
+		// nullopt for any value other than true or false
+		std::optional<bool> read_boolean();
+		void skip_value();
+
+	private:
+		char current() const noexcept {
+			return pos_ < text_.size() ? text_[pos_] : '\0';
+		}
+		void skip_ws() noexcept;
+		bool expect(char c) noexcept;
+		bool next_in(char closing) noexcept;
+		bool literal(std::string_view word) noexcept;
+		bool string(std::string* out);
+		bool number(std::string_view& out) noexcept;
+		bool fail() noexcept {
+			failed_ = true;
+			return false;
+		}
+
+		std::string_view text_;
+		size_t pos_{};
+		bool failed_{false};
+		// for each open object or array: was there at least one value
+		// already, so next one needs a comma?
+		std::vector<bool> needs_comma_{};
+	};
+}  // namespace cov::app::report
@@ -1,6 +1,7 @@
 // Copyright (c) 2022 Marcin Zdun
 // This code is licensed under MIT license (see LICENSE for details)
 
+#include <algorithm>
 #include <charconv>
 #include <chrono>
 #include <cov/app/path.hh>
@@ -9,18 +10,16 @@
 #include <cov/hash/md5.hh>
 #include <cov/hash/sha1.hh>
 #include <cov/io/file.hh>
-#include <json/json.hpp>
+#include <cstring>
+#include <fmt/format.h>
+#include <iterator>
+#include <optional>
+#include "json_reader.hh"
 
 namespace cov::app::report {
-	namespace {
-		std::u8string_view to_json(std::string_view str) {
-			return {reinterpret_cast<char8_t const*>(str.data()), str.size()};
-		}
-
-		std::string_view from_json(std::u8string_view str) {
-			return {reinterpret_cast<char const*>(str.data()), str.size()};
-		}
+	using namespace std::literals;
 
+	namespace {
 		struct digest_info {
 			std::string_view id;
 			digest result;
@@ -39,8 +38,7 @@ namespace cov::app::report {
 			return digest::unknown;
 		}
 
-		bool conv_rebase(std::u8string_view key, unsigned& out) {
-			auto const view = from_json(key);
+		bool conv_rebase(std::string_view view, unsigned& out) {
 			auto const first = view.data();
 			auto const last = first + view.size();
 			auto const [ptr, ec] = std::from_chars(first, last, out);
@@ -94,12 +92,6 @@ namespace cov::app::report {
 			return {.name = stored(sign.name), .mail = stored(sign.email)};
 		}
 
-		enum class matching {
-			none,
-			exactly,
-			with_different_newlines,
-		};
-
 		unsigned nybble(char c) {
 			switch (c) {
 				case '0':
@@ -132,6 +124,75 @@ namespace cov::app::report {
 			}
 		}
 
+		// Collects short runs of text (down to the single characters of
+		// newline conversions) for two digests and hashes them in larger
+		// blocks. The blocks both lanes have waiting are hashed side by
+		// side, for the digests, which can interleave two streams.
+		template <typename Digest>
+		class staged_digests {
+		public:
+			void update(size_t lane, std::string_view chunk) noexcept {
+				auto& stream = lanes_[lane];
+				while (!chunk.empty()) {
+					auto const size = std::min(
+					    chunk.size(), sizeof(stream.buffer) - stream.used);
+					std::memcpy(stream.buffer + stream.used, chunk.data(),
+					            size);
+					stream.used += size;
+					chunk = chunk.substr(size);
+					if (stream.used == sizeof(stream.buffer)) flush(lane);
+				}
+			}
+
+			auto finalize(size_t lane) noexcept {
+				flush(lane);
+				auto& stream = lanes_[lane];
+				stream.calc.update(git::bytes{stream.buffer, stream.used});
+				stream.used = 0;
+				return stream.calc.finalize();
+			}
+
+		private:
+			static constexpr auto block_size = Digest::block_byte_size;
+
+			struct stream_info {
+				Digest calc{};
+				std::byte buffer[8192];
+				size_t used{};
+			};
+
+			// hashes every whole block of the lane, taking the other one
+			// along for as many blocks as it has
+			void flush(size_t lane) noexcept {
+				auto& [lhs, rhs] = lanes_;
+				auto const common = std::min(lhs.used, rhs.used) / block_size;
+				if (common) {
+					Digest::update_lanes(lhs.calc, lhs.buffer, rhs.calc,
+					                     rhs.buffer, common);
+				}
+
+				auto& stream = lanes_[lane];
+				auto const whole = stream.used / block_size - common;
+				if (whole) {
+					stream.calc.update(
+					    git::bytes{stream.buffer + common * block_size,
+					               whole * block_size});
+				}
+
+				consume(stream, (common + whole) * block_size);
+				consume(lanes_[1 - lane], common * block_size);
+			}
+
+			static void consume(stream_info& stream, size_t size) noexcept {
+				if (!size) return;
+				std::memmove(stream.buffer, stream.buffer + size,
+				             stream.used - size);
+				stream.used -= size;
+			}
+
+			stream_info lanes_[2];
+		};
+
 		template <typename Digest>
 		matching match_(std::string_view hash, git::bytes data) {
 			using digest_type = typename Digest::digest_type;
@@ -149,62 +210,51 @@ namespace cov::app::report {
 
 			if (Digest::once(data) == expected) return matching::exactly;
 
-			{
-				// 2. replace \n with \r\n
-				Digest calc{};
-				auto chars = std::string_view{
-				    reinterpret_cast<char const*>(data.data()), data.size()};
-				auto pos = chars.find('\n');
-				while (pos != std::string_view::npos) {
-					if (!pos || chars[pos - 1] != '\r') {
-						auto const chunk = chars.substr(0, pos);
-
-						if (chunk.size()) calc.update(git::bytes{chunk});
-						calc.update(git::bytes{"\r\n"sv});
-
-						chars = chars.substr(pos + 1);
-						pos = chars.find('\n');
-						continue;
-					}
-					pos = chars.find('\n', pos + 1);
+			// Both newline conversions are computed in the same pass over
+			// the line ends; each one is only fed the runs of text between
+			// the places, where it differs from the original.
+			auto const chars = std::string_view{
+			    reinterpret_cast<char const*>(data.data()), data.size()};
+			auto pos = chars.find('\n');
+			if (pos == std::string_view::npos) return matching::none;
+
+			static constexpr size_t to_crlf = 0;
+			static constexpr size_t to_lf = 1;
+			staged_digests<Digest> digests{};
+			size_t crlf_from{}, lf_from{};
+			bool has_lf{false}, has_crlf{false};
+			for (; pos != std::string_view::npos;
+			     pos = chars.find('\n', pos + 1)) {
+				if (pos && chars[pos - 1] == '\r') {
+					// drop the \r, the \n starts next run
+					digests.update(to_lf,
+					               chars.substr(lf_from, pos - 1 - lf_from));
+					lf_from = pos;
+					has_crlf = true;
+				} else {
+					// add a \r, the \n starts next run
+					digests.update(to_crlf,
+					               chars.substr(crlf_from, pos - crlf_from));
+					digests.update(to_crlf, "\r"sv);
+					crlf_from = pos;
+					has_lf = true;
 				}
-				if (chars.size()) calc.update(git::bytes{chars});
-				if (calc.finalize() == expected)
-					return matching::with_different_newlines;
 			}
 
-			{
-				// 3. replace \r\n with \n
-				Digest calc{};
-				auto chars = std::string_view{
-				    reinterpret_cast<char const*>(data.data()), data.size()};
-				auto pos = chars.find("\r\n"sv);
-				while (pos != std::string_view::npos) {
-					auto const chunk = chars.substr(0, pos);
-
-					if (chunk.size()) calc.update(git::bytes{chunk});
-					calc.update(git::bytes{"\n"sv});
-
-					chars = chars.substr(pos + 2);
-					pos = chars.find("\r\n"sv);
-				}
-				if (chars.size()) calc.update(git::bytes{chars});
-				if (calc.finalize() == expected)
+			// if a conversion did not change anything, it would give
+			// the digest of the original, which already failed
+			if (has_lf) {
+				digests.update(to_crlf, chars.substr(crlf_from));
+				if (digests.finalize(to_crlf) == expected)
 					return matching::with_different_newlines;
 			}
 
-			return matching::none;
-		}
-
-		matching match(digest type, std::string_view hash, git::bytes data) {
-			switch (type) {
-				case digest::md5:
-					return match_<hash::md5>(hash, data);
-				case digest::sha1:
-					return match_<hash::sha1>(hash, data);
-				default:
-					break;
+			if (has_crlf) {
+				digests.update(to_lf, chars.substr(lf_from));
+				if (digests.finalize(to_lf) == expected)
+					return matching::with_different_newlines;
 			}
+
 			return matching::none;
 		}
 
@@ -218,9 +268,10 @@ namespace cov::app::report {
 			return lines;
 		}
 
-		unsigned visit_lines(std::map<unsigned, unsigned> const& line_coverage,
-		                     size_t line_count,
-		                     auto visitor) {
+		unsigned visit_lines(
+		    std::span<std::pair<unsigned, unsigned> const> line_coverage,
+		    size_t line_count,
+		    auto visitor) {
 			static constexpr auto max_u31 = (1u << 31) - 1;
 
 			unsigned prev_line = 0;
@@ -251,6 +302,18 @@ namespace cov::app::report {
 		}
 	}  // namespace
 
+	matching match(digest type, std::string_view hash, git::bytes data) {
+		switch (type) {
+			case digest::md5:
+				return match_<hash::md5>(hash, data);
+			case digest::sha1:
+				return match_<hash::sha1>(hash, data);
+			default:
+				break;
+		}
+		return matching::none;
+	}
+
 	file_info::coverage_info file_info::expand_coverage(
 	    size_t line_count) const {
 		coverage_info result{std::vector<io::v1::coverage>{},
@@ -276,177 +339,478 @@ namespace cov::app::report {
 		return result;
 	}  // GCOV_EXCL_LINE[GCC]
 
-	bool report_info::load_from_text(std::string_view u8_encoded) {
-		git = {};
-		files.clear();
+	void file_info::sort_lines() {
+		auto const by_line = [](auto const& lhs, auto const& rhs) {
+			return lhs.first < rhs.first;
+		};
+		auto const same_line = [](auto const& lhs, auto const& rhs) {
+			return lhs.first == rhs.first;
+		};
+		// reports are written in order, so this is usually the only pass
+		if (std::adjacent_find(line_coverage.begin(), line_coverage.end(),
+		                       [](auto const& lhs, auto const& rhs) {
+			                       return lhs.first >= rhs.first;
+		                       }) == line_coverage.end())
+			return;
+
+		std::stable_sort(line_coverage.begin(), line_coverage.end(), by_line);
+		// unique() keeps the first of the equal items; going backwards
+		// keeps the last one
+		auto const rend = std::unique(line_coverage.rbegin(),
+		                              line_coverage.rend(), same_line);
+		line_coverage.erase(line_coverage.begin(), rend.base());
+	}
 
-		auto const node = json::read_json(to_json(u8_encoded));
+	namespace {
+		struct function_fields {
+			std::optional<std::string> name{};
+			std::optional<std::string> demangled{};
+			std::optional<long long> count{};
+			std::optional<long long> start_line{};
+			std::optional<long long> start_column{};
+			std::optional<long long> end_line{};
+			std::optional<long long> end_column{};
+
+			bool complete() const noexcept {
+				return name && count && start_line;
+			}
 
-		auto const json_git = cast_from_json<json::map>(node, u8"git"sv);
-		auto const json_files = cast_from_json<json::array>(node, u8"files"sv);
+			file_info::function to_function() && {
+				file_info::function nfo{};
+				nfo.name = std::move(*name);
+				if (demangled) nfo.demangled_name = std::move(*demangled);
+				nfo.count = u32_from(*count);
+				nfo.start.line = u32_from(*start_line);
+				nfo.start.column = u32_from(start_column ? *start_column : 0);
+				nfo.end.line = u32_from(end_line ? *end_line : *start_line);
+				nfo.end.column = u32_from(end_column ? *end_column : 0);
+
+				// rebase line indexes
+				if (nfo.start.line > 0) --nfo.start.line;
+				if (nfo.end.line > 0) --nfo.end.line;
+				return nfo;
+			}
+		};
 
-		auto const json_git_branch =
-		    cast_from_json<json::string>(json_git, u8"branch"sv);
-		auto const json_git_head =
-		    cast_from_json<json::string>(json_git, u8"head"sv);
+		// Everything read from a single /files[] item. Keys may come in any
+		// order, so nothing is reported, before the whole object is read.
+		struct file_fields {
+			std::optional<std::string> name{};
+			std::optional<std::string> digest{};
+			bool has_line_coverage{false};
+			std::vector<std::pair<unsigned, unsigned>> line_coverage{};
+			std::optional<std::string> bad_line{};
+			std::vector<file_info::function> functions{};
+			std::optional<size_t> bad_function_index{};
+			function_fields bad_function{};
+			std::map<unsigned, std::vector<io::v1::branch>> branches{};
+			std::optional<std::string> bad_branch{};
+		};
 
-		if (!json_git_branch || !json_git_head || !json_files) {
-			if (!json_git) {
-				fmt::print(stderr, "cov report: /git: undefined\n");
-			} else {
-				if (!json_git_branch)
-					fmt::print(stderr, "cov report: /git/branch: undefined\n");
-				if (!json_git_head)
-					fmt::print(stderr, "cov report: /git/head: undefined\n");
+		class report_reader {
+		public:
+			report_reader(std::string_view text,
+			              git_info& git,
+			              report_info::file_sink const& on_file)
+			    : json_{text}, git_{git}, on_file_{on_file} {}
+
+			bool read() {
+				if (json_.peek() == json_reader::kind::object) {
+					json_.enter_object();
+					std::string key{};
+					while (json_.next_key(key)) {
+						if (key == "git"sv)
+							read_git();
+						else if (key == "files"sv)
+							read_files();
+						else
+							json_.skip_value();
+					}
+				}
+
+				if (!json_.finished()) {
+					// same as a text without any of the required values
+					has_git_ = has_branch_ = has_head_ = has_files_ = false;
+				}
+
+				if (!has_branch_ || !has_head_ || !has_files_) {
+					if (!has_git_) {
+						fmt::print(stderr, "cov report: /git: undefined\n");
+					} else {
+						if (!has_branch_)
+							fmt::print(stderr,
+							           "cov report: /git/branch: undefined\n");
+						if (!has_head_)
+							fmt::print(stderr,
+							           "cov report: /git/head: undefined\n");
+					}
+					if (!has_files_)
+						fmt::print(stderr, "cov report: /files: undefined\n");
+					return false;
+				}
+
+				if (!errors_.empty()) {
+					fmt::print(stderr, "{}", errors_);
+					return false;
+				}
+
+				return true;
+			}
+
+		private:
+			void read_git() {
+				if (json_.peek() != json_reader::kind::object) {
+					json_.skip_value();
+					has_git_ = has_branch_ = has_head_ = false;
+					return;
+				}
+
+				has_git_ = true;
+				has_branch_ = has_head_ = false;
+				json_.enter_object();
+				std::string key{};
+				while (json_.next_key(key)) {
+					if (key == "branch"sv) {
+						auto value = json_.read_string();
+						has_branch_ = !!value;
+						if (value) git_.branch = std::move(*value);
+					} else if (key == "head"sv) {
+						auto value = json_.read_string();
+						has_head_ = !!value;
+						if (value) git_.head = std::move(*value);
+					} else {
+						json_.skip_value();
+					}
+				}
 			}
-			if (!json_files)
-				fmt::print(stderr, "cov report: /files: undefined\n");
-			return false;
-		}
 
-		files.reserve(json_files->size());
-
-		auto file_index{std::numeric_limits<size_t>::max()};
-		for (auto const& file_node : *json_files) {
-			++file_index;
-
-			auto const json_file_name =
-			    cast_from_json<json::string>(file_node, u8"name"sv);
-			auto const json_file_digest =
-			    cast_from_json<json::string>(file_node, u8"digest"sv);
-			auto const json_file_line_coverage =
-			    cast_from_json<json::map>(file_node, u8"line_coverage"sv);
-			auto const json_file_functions_coverage =
-			    cast_from_json<json::array>(file_node, u8"functions"sv);
-
-			if (!json_file_name || !json_file_digest ||
-			    !json_file_line_coverage) {
-				auto const print_undefined =
-				    [file_index, json_file_name](std::string_view name) {
-					    if (json_file_name) {
-						    fmt::print(
-						        stderr,
-						        "cov report: /files[{}]/{} ({}): undefined\n",
-						        file_index, name, from_json(*json_file_name));
-					    } else {
-						    fmt::print(stderr,
-						               "cov report: /files[{}]/{}: undefined\n",
-						               file_index, name);
-					    }
-				    };
-
-				if (!json_file_name) print_undefined("name"sv);
-				if (!json_file_digest) print_undefined("digest"sv);
-				if (!json_file_line_coverage)
-					print_undefined("line_coverage"sv);
-
-				files.clear();
-				return false;
+			void read_files() {
+				if (json_.peek() != json_reader::kind::array) {
+					json_.skip_value();
+					has_files_ = false;
+					return;
+				}
+
+				has_files_ = true;
+				json_.enter_array();
+				while (json_.next_item()) {
+					++file_index_;
+					if (!errors_.empty()) {
+						// still need to know, if /git is all right
+						json_.skip_value();
+						continue;
+					}
+
+					auto fields = read_file();
+					if (json_.failed()) break;
+					if (auto file = validate(std::move(fields)); file)
+						on_file_(std::move(*file));
+				}
 			}
 
-			auto digest_view = from_json(*json_file_digest);
-			auto const pos = digest_view.find(':');
-			auto const algorithm = lookup_digest(digest_view.substr(0, pos));
-			if (pos == std::string_view::npos || algorithm == digest::unknown) {
-				fmt::print(stderr, "cov report: /file[{}]/digest ({}): '{}'\n",
-				           file_index, from_json(*json_file_name), digest_view);
-				files.clear();
-				return false;
+			file_fields read_file() {
+				file_fields result{};
+				if (json_.peek() != json_reader::kind::object) {
+					json_.skip_value();
+					return result;
+				}
+
+				json_.enter_object();
+				std::string key{};
+				while (json_.next_key(key)) {
+					if (key == "name"sv) {
+						result.name = json_.read_string();
+					} else if (key == "digest"sv) {
+						result.digest = json_.read_string();
+					} else if (key == "line_coverage"sv) {
+						read_lines(result);
+					} else if (key == "functions"sv) {
+						read_functions(result);
+					} else if (key == "branches"sv) {
+						read_branches(result);
+					} else {
+						json_.skip_value();
+					}
+				}
+				return result;
 			}
 
-			files.push_back({});
-			auto& dst = files.back();
-
-			dst.name.assign(from_json(*json_file_name));
-			dst.algorithm = algorithm;
-			dst.digest.assign(digest_view.substr(pos + 1));
-
-			for (auto const& [node_key, node_value] :
-			     json_file_line_coverage->items()) {
-				auto const hits = cast<long long>(node_value);
-
-				unsigned line{};
-				if (!hits || !conv_rebase(node_key, line)) {
-					json::string val;
-					json::write_json(val, node_value, json::concise);
-					fmt::print(stderr,
-					           "cov report: /file[{}]/line_coverage[{}]: {}\n",
-					           file_index, from_json(*json_file_name),
-					           from_json(node_key), from_json(val));
-					files.clear();
-					return false;
+			void read_lines(file_fields& result) {
+				result.line_coverage.clear();
+				result.bad_line = std::nullopt;
+				result.has_line_coverage =
+				    json_.peek() == json_reader::kind::object;
+				if (!result.has_line_coverage) {
+					json_.skip_value();
+					return;
+				}
+
+				json_.enter_object();
+				std::string key{};
+				while (json_.next_key(key)) {
+					auto const hits = json_.read_integer();
+					if (result.bad_line) continue;
+
+					unsigned line{};
+					if (!hits || !conv_rebase(key, line)) {
+						result.bad_line = key;
+						continue;
+					}
+					result.line_coverage.push_back(
+					    {line, unsigned_from(*hits)});
 				}
-				dst.line_coverage[line] = unsigned_from(*hits);
 			}
 
-			if (json_file_functions_coverage) {
-				auto& cvg = dst.function_coverage;
-				cvg.reserve(json_file_functions_coverage->size());
-
-				auto function_index{std::numeric_limits<size_t>::max()};
-				for (auto const& node_file : *json_file_functions_coverage) {
-					++function_index;
-					auto const name =
-					    cast_from_json<json::string>(node_file, u8"name"sv);
-					auto const count =
-					    cast_from_json<long long>(node_file, u8"count"sv);
-					auto const start_line =
-					    cast_from_json<long long>(node_file, u8"start_line"sv);
-
-					if (!name || !count || !start_line) {
-						auto const file_name = from_json(*json_file_name);
-						auto const print_undefined =
-						    [file_index, function_index,
-						     file_name](std::string_view name) {
-							    fmt::print(stderr,
-							               "cov report: "
-							               "/files[{}]/functions[{}]/{} ({}): "
-							               "undefined\n",
-							               file_index, function_index, name,
-							               file_name);
-						    };
-
-						if (!name) print_undefined("name"sv);
-						if (!count) print_undefined("count"sv);
-						if (!start_line) print_undefined("start_line"sv);
-
-						files.clear();
-						return false;
+			void read_functions(file_fields& result) {
+				result.functions.clear();
+				result.bad_function_index = std::nullopt;
+				if (json_.peek() != json_reader::kind::array) {
+					json_.skip_value();
+					return;
+				}
+
+				json_.enter_array();
+				size_t function_index{0};
+				for (; json_.next_item(); ++function_index) {
+					auto fields = read_function();
+					if (result.bad_function_index) continue;
+					if (!fields.complete()) {
+						result.bad_function_index = function_index;
+						result.bad_function = std::move(fields);
+						continue;
 					}
+					result.functions.push_back(
+					    std::move(fields).to_function());
+				}
+			}
 
-					auto const demangled = cast_from_json<json::string>(
-					    node_file, u8"demangled"sv);
-					auto const start_column = cast_from_json<long long>(
-					    node_file, u8"start_column"sv);
-					auto const end_line =
-					    cast_from_json<long long>(node_file, u8"end_line"sv);
-					auto const end_column =
-					    cast_from_json<long long>(node_file, u8"end_column"sv);
-
-					cvg.push_back({});
-					auto& nfo = cvg.back();
-					nfo.name.assign(from_json(*name));
-					if (demangled)
-						nfo.demangled_name.assign(from_json(*demangled));
-					nfo.count = u32_from(*count);
-					nfo.start.line = u32_from(*start_line);
-					nfo.start.column =
-					    u32_from(start_column ? *start_column : 0);
-					nfo.end.line = u32_from(end_line ? *end_line : *start_line);
-					nfo.end.column = u32_from(end_column ? *end_column : 0);
-
-					// rebase line indexes
-					if (nfo.start.line > 0) --nfo.start.line;
-					if (nfo.end.line > 0) --nfo.end.line;
+			void read_branches(file_fields& result) {
+				result.branches.clear();
+				result.bad_branch = std::nullopt;
+				if (json_.peek() != json_reader::kind::object) {
+					json_.skip_value();
+					return;
 				}
 
-				std::sort(cvg.begin(), cvg.end());
+				json_.enter_object();
+				std::string key{};
+				while (json_.next_key(key)) {
+					auto branches = read_line_branches();
+					if (result.bad_branch) continue;
+
+					unsigned line{};
+					if (!branches || !conv_rebase(key, line)) {
+						result.bad_branch = key;
+						continue;
+					}
+					if (!branches->empty())
+						result.branches[line] = std::move(*branches);
+				}
 			}
-		}
 
-		git.branch.assign(from_json(*json_git_branch));
-		git.head.assign(from_json(*json_git_head));
-		return true;
+			// [[taken, not_taken], ...]
+			std::optional<std::vector<io::v1::branch>> read_line_branches() {
+				if (json_.peek() != json_reader::kind::array) {
+					json_.skip_value();
+					return std::nullopt;
+				}
+
+				std::vector<io::v1::branch> result{};
+				bool valid{true};
+				json_.enter_array();
+				while (json_.next_item()) {
+					if (json_.peek() != json_reader::kind::array) {
+						json_.skip_value();
+						valid = false;
+						continue;
+					}
+
+					std::optional<long long> taken{}, not_taken{};
+					size_t count{};
+					json_.enter_array();
+					for (; json_.next_item(); ++count) {
+						if (count == 0)
+							taken = json_.read_integer();
+						else if (count == 1)
+							not_taken = json_.read_integer();
+						else
+							json_.skip_value();
+					}
+
+					if (count != 2 || !taken || !not_taken) {
+						valid = false;
+						continue;
+					}
+					result.push_back({.taken = u32_from(*taken),
+					                  .not_taken = u32_from(*not_taken)});
+				}
+
+				if (!valid) return std::nullopt;
+				return result;
+			}
+
+			function_fields read_function() {
+				function_fields result{};
+				if (json_.peek() != json_reader::kind::object) {
+					json_.skip_value();
+					return result;
+				}
+
+				json_.enter_object();
+				std::string key{};
+				while (json_.next_key(key)) {
+					if (key == "name"sv)
+						result.name = json_.read_string();
+					else if (key == "demangled"sv)
+						result.demangled = json_.read_string();
+					else if (key == "count"sv)
+						result.count = json_.read_integer();
+					else if (key == "start_line"sv)
+						result.start_line = json_.read_integer();
+					else if (key == "start_column"sv)
+						result.start_column = json_.read_integer();
+					else if (key == "end_line"sv)
+						result.end_line = json_.read_integer();
+					else if (key == "end_column"sv)
+						result.end_column = json_.read_integer();
+					else
+						json_.skip_value();
+				}
+				return result;
+			}
+
+			std::optional<file_info> validate(file_fields&& fields) {
+				auto out = std::back_inserter(errors_);
+
+				if (!fields.name || !fields.digest ||
+				    !fields.has_line_coverage) {
+					auto const print_undefined = [&, this](
+					                                 std::string_view name) {
+						if (fields.name) {
+							fmt::format_to(
+							    out,
+							    "cov report: /files[{}]/{} ({}): undefined\n",
+							    file_index_, name, *fields.name);
+						} else {
+							fmt::format_to(
+							    out, "cov report: /files[{}]/{}: undefined\n",
+							    file_index_, name);
+						}
+					};
+
+					if (!fields.name) print_undefined("name"sv);
+					if (!fields.digest) print_undefined("digest"sv);
+					if (!fields.has_line_coverage)
+						print_undefined("line_coverage"sv);
+					return std::nullopt;
+				}
+
+				std::string_view digest_view = *fields.digest;
+				auto const pos = digest_view.find(':');
+				auto const algorithm =
+				    lookup_digest(digest_view.substr(0, pos));
+				if (pos == std::string_view::npos ||
+				    algorithm == digest::unknown) {
+					fmt::format_to(out,
+					               "cov report: /file[{}]/digest ({}): '{}'\n",
+					               file_index_, *fields.name, digest_view);
+					return std::nullopt;
+				}
+
+				if (fields.bad_line) {
+					fmt::format_to(
+					    out, "cov report: /file[{}]/line_coverage[{}]: {}\n",
+					    file_index_, *fields.name, *fields.bad_line);
+					return std::nullopt;
+				}
+
+				if (fields.bad_function_index) {
+					auto const& function = fields.bad_function;
+					auto const print_undefined = [&, this](
+					                                 std::string_view name) {
+						fmt::format_to(out,
+						               "cov report: "
+						               "/files[{}]/functions[{}]/{} ({}): "
+						               "undefined\n",
+						               file_index_, *fields.bad_function_index,
+						               name, *fields.name);
+					};
+
+					if (!function.name) print_undefined("name"sv);
+					if (!function.count) print_undefined("count"sv);
+					if (!function.start_line) print_undefined("start_line"sv);
+					return std::nullopt;
+				}
+
+				if (fields.bad_branch) {
+					fmt::format_to(out,
+					               "cov report: /file[{}]/branches[{}]: {}\n",
+					               file_index_, *fields.name, *fields.bad_branch);
+					return std::nullopt;
+				}
+
+				file_info result{};
+				result.algorithm = algorithm;
+				result.digest.assign(digest_view.substr(pos + 1));
+				result.name = std::move(*fields.name);
+				result.line_coverage = std::move(fields.line_coverage);
+				result.sort_lines();
+				result.function_coverage = std::move(fields.functions);
+				std::sort(result.function_coverage.begin(),
+				          result.function_coverage.end());
+				result.branch_coverage = std::move(fields.branches);
+				return result;
+			}
+
+			json_reader json_;
+			git_info& git_;
+			report_info::file_sink const& on_file_;
+			std::string errors_{};
+			size_t file_index_{std::numeric_limits<size_t>::max()};
+			bool has_git_{false};
+			bool has_branch_{false};
+			bool has_head_{false};
+			bool has_files_{false};
+		};
+	}  // namespace
+
+	bool report_info::read_from_text(std::string_view u8_encoded,
+	                                 git_info& git,
+	                                 file_sink const& on_file) {
+		git = {};
+		auto const result = report_reader{u8_encoded, git, on_file}.read();
+		if (!result) git = {};
+		return result;
+	}
+
+	bool report_info::read(std::string_view contents,
+	                       git_info& git,
+	                       file_sink const& on_file) {
+		if (is_binary(contents)) return read_from_binary(contents, git, on_file);
+		return read_from_text(contents, git, on_file);
+	}
+
+	bool report_info::load(std::string_view contents) {
+		if (is_binary(contents)) return load_from_binary(contents);
+		return load_from_text(contents);
+	}
+
+	bool report_info::load_from_text(std::string_view u8_encoded) {
+		files.clear();
+		auto const result = read_from_text(
+		    u8_encoded, git,
+		    [this](file_info&& file) { files.push_back(std::move(file)); });
+		if (!result) files.clear();
+		return result;
+	}
+
+	bool report_info::load_from_binary(std::string_view data) {
+		files.clear();
+		auto const result = read_from_binary(
+		    data, git,
+		    [this](file_info&& file) { files.push_back(std::move(file)); });
+		if (!result) files.clear();
+		return result;
 	}
 
 	git_commit git_commit::load(git::repository_handle repo,
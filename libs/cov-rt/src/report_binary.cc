@@ -0,0 +1,473 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cov/app/report.hh>
+#include <limits>
+#include <map>
+#include <optional>
+
+// Layout of the binary report is described in docs/objects.md, under
+// REPORT INPUT. Unlike the objects, it is always little-endian, as it
+// travels between machines.
+
+namespace cov::app::report {
+	using namespace std::literals;
+
+	namespace {
+		static constexpr auto magic = "rpin"sv;
+		// 1.1 adds the branches; 1.0 files are still read
+		static constexpr uint32_t version = io::VERSION_v1_1;
+
+		enum : uint32_t {
+			algorithm_md5 = 1,
+			algorithm_sha1 = 2,
+		};
+
+		struct header {
+			static constexpr size_t strings = 2;
+			static constexpr size_t branch = 4;
+			static constexpr size_t head = 5;
+			static constexpr size_t files = 6;
+			static constexpr size_t functions = 9;
+			static constexpr size_t lines = 12;
+			static constexpr size_t branches = 14;
+			static constexpr size_t size_v1_0 = 14;
+			static constexpr size_t size = 16;
+		};
+
+		struct file_entry {
+			static constexpr size_t name = 0;
+			static constexpr size_t algorithm = 1;
+			static constexpr size_t digest = 2;
+			static constexpr size_t lines_offset = 3;
+			static constexpr size_t lines_count = 4;
+			static constexpr size_t functions_offset = 5;
+			static constexpr size_t functions_count = 6;
+			static constexpr size_t branches_offset = 7;
+			static constexpr size_t branches_count = 8;
+			static constexpr size_t size_v1_0 = 7;
+			static constexpr size_t size = 9;
+		};
+
+		struct function_entry {
+			static constexpr size_t name = 0;
+			static constexpr size_t demangled_name = 1;
+			static constexpr size_t count = 2;
+			static constexpr size_t start_line = 3;
+			static constexpr size_t start_column = 4;
+			static constexpr size_t end_line = 5;
+			static constexpr size_t end_column = 6;
+			static constexpr size_t size = 7;
+		};
+
+		struct branch_entry {
+			static constexpr size_t line = 0;
+			static constexpr size_t taken = 1;
+			static constexpr size_t not_taken = 2;
+			static constexpr size_t size = 3;
+		};
+
+		class binary_view {
+		public:
+			explicit binary_view(std::string_view data) noexcept
+			    : data_{data} {}
+
+			size_t size() const noexcept { return data_.size() / 4; }
+
+			uint32_t at(size_t index) const noexcept {
+				auto const ptr =
+				    reinterpret_cast<unsigned char const*>(data_.data()) +
+				    index * 4;
+				return static_cast<uint32_t>(ptr[0]) |
+				       (static_cast<uint32_t>(ptr[1]) << 8) |
+				       (static_cast<uint32_t>(ptr[2]) << 16) |
+				       (static_cast<uint32_t>(ptr[3]) << 24);
+			}
+
+			bool contains(size_t offset, size_t size) const noexcept {
+				auto const total = this->size();
+				return offset <= total && size <= total - offset;
+			}
+
+			std::string_view bytes(size_t offset, size_t size) const noexcept {
+				return data_.substr(offset * 4, size * 4);
+			}
+
+		private:
+			std::string_view data_;
+		};
+
+		class string_table {
+		public:
+			explicit string_table(std::string_view bytes) noexcept
+			    : bytes_{bytes} {}
+
+			std::optional<std::string_view> at(uint32_t offset) const noexcept {
+				if (offset >= bytes_.size()) return std::nullopt;
+				auto const rest = bytes_.substr(offset);
+				auto const length = rest.find('\0');
+				if (length == std::string_view::npos) return std::nullopt;
+				return rest.substr(0, length);
+			}
+
+		private:
+			std::string_view bytes_;
+		};
+
+		struct array_view {
+			size_t offset;
+			size_t size;
+			size_t count;
+
+			static std::optional<array_view> from(binary_view const& data,
+			                                      size_t index,
+			                                      size_t min_size) {
+				array_view result{data.at(index), data.at(index + 1),
+				                  data.at(index + 2)};
+				if (result.size < min_size) {
+					if (result.count) return std::nullopt;
+					result.size = min_size;
+				}
+				if (result.count >
+				    std::numeric_limits<size_t>::max() / result.size)
+					return std::nullopt;
+				if (!data.contains(result.offset, result.size * result.count))
+					return std::nullopt;
+				return result;
+			}
+
+			size_t item(size_t index) const noexcept {
+				return offset + index * size;
+			}
+		};
+
+		uint32_t rebased(uint32_t line) noexcept {
+			return line > 0 ? line - 1 : line;
+		}
+
+		class binary_writer {
+		public:
+			uint32_t string(std::string_view str) {
+				auto it = strings_.lower_bound(str);
+				if (it != strings_.end() && it->first == str) return it->second;
+				auto const offset = static_cast<uint32_t>(bytes_.size());
+				bytes_.append(str);
+				bytes_.push_back('\0');
+				strings_.emplace_hint(it, std::string{str}, offset);
+				return offset;
+			}
+
+			static void put(std::string& out, uint32_t value) {
+				out.push_back(static_cast<char>(value & 0xFF));
+				out.push_back(static_cast<char>((value >> 8) & 0xFF));
+				out.push_back(static_cast<char>((value >> 16) & 0xFF));
+				out.push_back(static_cast<char>((value >> 24) & 0xFF));
+			}
+
+			std::string_view strings() {
+				while (bytes_.size() % 4)
+					bytes_.push_back('\0');
+				return bytes_;
+			}
+
+		private:
+			std::string bytes_{};
+			std::map<std::string, uint32_t, std::less<>> strings_{};
+		};
+
+		void print_undefined(size_t file_index,
+		                     std::optional<std::string_view> const& name,
+		                     std::string_view field) {
+			if (name) {
+				fmt::print(stderr,
+				           "cov report: /files[{}]/{} ({}): undefined\n",
+				           file_index, field, *name);
+			} else {
+				fmt::print(stderr, "cov report: /files[{}]/{}: undefined\n",
+				           file_index, field);
+			}
+		}
+	}  // namespace
+
+	bool report_info::is_binary(std::string_view contents) noexcept {
+		return contents.starts_with(magic);
+	}
+
+	bool report_info::read_from_binary(std::string_view contents,
+	                                   git_info& git,
+	                                   file_sink const& on_file) {
+		git = {};
+
+		binary_view const data{contents};
+		if (!is_binary(contents) || contents.size() % 4 ||
+		    data.size() < header::size_v1_0 ||
+		    (data.at(1) & io::VERSION_MAJOR) != io::VERSION_v1_0) {
+			fmt::print(stderr, "cov report: not a binary report\n");
+			return false;
+		}
+
+		auto const with_branches =
+		    (data.at(1) & io::VERSION_MINOR) >=
+		    (io::VERSION_v1_1 & io::VERSION_MINOR);
+		if (with_branches && data.size() < header::size) {
+			fmt::print(stderr, "cov report: not a binary report\n");
+			return false;
+		}
+
+		auto const strings_offset = data.at(header::strings);
+		auto const strings_size = data.at(header::strings + 1);
+		auto const files = array_view::from(
+		    data, header::files,
+		    with_branches ? file_entry::size : file_entry::size_v1_0);
+		auto const functions = array_view::from(data, header::functions,
+		                                        function_entry::size);
+		auto const lines_offset = data.at(header::lines);
+		auto const lines_size = data.at(header::lines + 1);
+		auto const branches_offset =
+		    with_branches ? data.at(header::branches) : 0u;
+		auto const branches_size =
+		    with_branches ? data.at(header::branches + 1) : 0u;
+
+		if (!data.contains(strings_offset, strings_size) || !files ||
+		    !functions || !data.contains(lines_offset, lines_size) ||
+		    !data.contains(branches_offset, branches_size)) {
+			fmt::print(stderr, "cov report: not a binary report\n");
+			return false;
+		}
+
+		string_table const strings{data.bytes(strings_offset, strings_size)};
+		auto const branch = strings.at(data.at(header::branch));
+		auto const head = strings.at(data.at(header::head));
+		if (!branch || !head) {
+			if (!branch)
+				fmt::print(stderr, "cov report: /git/branch: undefined\n");
+			if (!head) fmt::print(stderr, "cov report: /git/head: undefined\n");
+			return false;
+		}
+
+		size_t const line_pairs = lines_size / 2;
+		size_t const branch_records = branches_size / branch_entry::size;
+
+		for (size_t file_index = 0; file_index < files->count; ++file_index) {
+			auto const entry = files->item(file_index);
+			auto const name = strings.at(data.at(entry + file_entry::name));
+			auto const hash = strings.at(data.at(entry + file_entry::digest));
+			auto const first_line = data.at(entry + file_entry::lines_offset);
+			auto const line_count = data.at(entry + file_entry::lines_count);
+			auto const first_function =
+			    data.at(entry + file_entry::functions_offset);
+			auto const function_count =
+			    data.at(entry + file_entry::functions_count);
+			auto const first_branch =
+			    with_branches ? data.at(entry + file_entry::branches_offset)
+			                  : 0u;
+			auto const branch_count =
+			    with_branches ? data.at(entry + file_entry::branches_count)
+			                  : 0u;
+
+			auto const has_lines = first_line <= line_pairs &&
+			                       line_count <= line_pairs - first_line;
+			auto const has_functions =
+			    first_function <= functions->count &&
+			    function_count <= functions->count - first_function;
+			auto const has_branches =
+			    first_branch <= branch_records &&
+			    branch_count <= branch_records - first_branch;
+
+			if (!name || !hash || !has_lines || !has_functions ||
+			    !has_branches) {
+				if (!name) print_undefined(file_index, name, "name"sv);
+				if (!hash) print_undefined(file_index, name, "digest"sv);
+				if (!has_lines)
+					print_undefined(file_index, name, "line_coverage"sv);
+				if (!has_functions)
+					print_undefined(file_index, name, "functions"sv);
+				if (!has_branches)
+					print_undefined(file_index, name, "branches"sv);
+				git = {};
+				return false;
+			}
+
+			file_info file{};
+			switch (data.at(entry + file_entry::algorithm)) {
+				case algorithm_md5:
+					file.algorithm = digest::md5;
+					break;
+				case algorithm_sha1:
+					file.algorithm = digest::sha1;
+					break;
+				default:
+					fmt::print(stderr,
+					           "cov report: /file[{}]/digest ({}): '{}'\n",
+					           file_index, *name, *hash);
+					git = {};
+					return false;
+			}
+
+			file.name.assign(*name);
+			file.digest.assign(*hash);
+
+			auto const lines = lines_offset + first_line * 2;
+			file.line_coverage.reserve(line_count);
+			for (size_t index = 0; index < line_count; ++index) {
+				auto const line = data.at(lines + index * 2);
+				auto const hits = data.at(lines + index * 2 + 1);
+				file.line_coverage.push_back({rebased(line), hits});
+			}
+			file.sort_lines();
+
+			file.function_coverage.reserve(function_count);
+			for (size_t index = 0; index < function_count; ++index) {
+				auto const fn = functions->item(first_function + index);
+				auto const fn_name =
+				    strings.at(data.at(fn + function_entry::name));
+				auto const demangled =
+				    strings.at(data.at(fn + function_entry::demangled_name));
+				if (!fn_name) {
+					fmt::print(stderr,
+					           "cov report: /files[{}]/functions[{}]/name "
+					           "({}): undefined\n",
+					           file_index, index, *name);
+					git = {};
+					return false;
+				}
+
+				auto const start_line = data.at(fn + function_entry::start_line);
+				auto const end_line = data.at(fn + function_entry::end_line);
+
+				file.function_coverage.push_back({});
+				auto& nfo = file.function_coverage.back();
+				nfo.name.assign(*fn_name);
+				if (demangled) nfo.demangled_name.assign(*demangled);
+				nfo.count = data.at(fn + function_entry::count);
+				nfo.start.line = rebased(start_line);
+				nfo.start.column = data.at(fn + function_entry::start_column);
+				nfo.end.line = rebased(end_line ? end_line : start_line);
+				nfo.end.column = data.at(fn + function_entry::end_column);
+			}
+			std::sort(file.function_coverage.begin(),
+			          file.function_coverage.end());
+
+			// branches of a line are kept in order of their records
+			auto const branches =
+			    branches_offset + first_branch * branch_entry::size;
+			for (size_t index = 0; index < branch_count; ++index) {
+				auto const record = branches + index * branch_entry::size;
+				auto const line = data.at(record + branch_entry::line);
+				file.branch_coverage[rebased(line)].push_back(
+				    {.taken = data.at(record + branch_entry::taken),
+				     .not_taken = data.at(record + branch_entry::not_taken)});
+			}
+
+			on_file(std::move(file));
+		}
+
+		git.branch.assign(*branch);
+		git.head.assign(*head);
+		return true;
+	}
+
+	std::string report_info::to_binary() const {
+		binary_writer writer{};
+		auto const branch = writer.string(git.branch);
+		auto const head = writer.string(git.head);
+
+		std::string file_entries{};
+		std::string function_entries{};
+		std::string line_entries{};
+		std::string branch_entries{};
+		uint32_t function_count{};
+		uint32_t line_count{};
+		uint32_t branch_count{};
+
+		file_entries.reserve(files.size() * file_entry::size * 4);
+		for (auto const& file : files) {
+			auto const algorithm = file.algorithm == digest::md5
+			                           ? algorithm_md5
+			                       : file.algorithm == digest::sha1
+			                           ? algorithm_sha1
+			                           : 0u;
+
+			binary_writer::put(file_entries, writer.string(file.name));
+			binary_writer::put(file_entries, algorithm);
+			binary_writer::put(file_entries, writer.string(file.digest));
+			binary_writer::put(file_entries, line_count);
+			binary_writer::put(file_entries,
+			                   io::clip_u32(file.line_coverage.size()));
+			binary_writer::put(file_entries, function_count);
+			binary_writer::put(file_entries,
+			                   io::clip_u32(file.function_coverage.size()));
+			auto const first_branch = branch_count;
+			for (auto const& [line, branches] : file.branch_coverage) {
+				for (auto const& branch : branches) {
+					binary_writer::put(branch_entries, line + 1);
+					binary_writer::put(branch_entries, branch.taken);
+					binary_writer::put(branch_entries, branch.not_taken);
+					++branch_count;
+				}
+			}
+			binary_writer::put(file_entries, first_branch);
+			binary_writer::put(file_entries, branch_count - first_branch);
+
+			for (auto const& [line, hits] : file.line_coverage) {
+				binary_writer::put(line_entries, line + 1);
+				binary_writer::put(line_entries, hits);
+				++line_count;
+			}
+
+			for (auto const& fn : file.function_coverage) {
+				binary_writer::put(function_entries, writer.string(fn.name));
+				binary_writer::put(function_entries,
+				                   writer.string(fn.demangled_name));
+				binary_writer::put(function_entries, fn.count);
+				binary_writer::put(function_entries, fn.start.line + 1);
+				binary_writer::put(function_entries, fn.start.column);
+				binary_writer::put(function_entries, fn.end.line + 1);
+				binary_writer::put(function_entries, fn.end.column);
+				++function_count;
+			}
+		}
+
+		auto const strings = writer.strings();
+		auto const strings_offset = static_cast<uint32_t>(header::size);
+		auto const strings_size = static_cast<uint32_t>(strings.size() / 4);
+		auto const files_offset = strings_offset + strings_size;
+		auto const functions_offset =
+		    files_offset + static_cast<uint32_t>(file_entries.size() / 4);
+		auto const lines_offset =
+		    functions_offset +
+		    static_cast<uint32_t>(function_entries.size() / 4);
+		auto const branches_offset =
+		    lines_offset + static_cast<uint32_t>(line_entries.size() / 4);
+
+		std::string result{};
+		result.reserve(header::size * 4 + strings.size() + file_entries.size() +
+		               function_entries.size() + line_entries.size() +
+		               branch_entries.size());
+		result.append(magic);
+		binary_writer::put(result, version);
+		binary_writer::put(result, strings_offset);
+		binary_writer::put(result, strings_size);
+		binary_writer::put(result, branch);
+		binary_writer::put(result, head);
+		binary_writer::put(result, files_offset);
+		binary_writer::put(result, static_cast<uint32_t>(file_entry::size));
+		binary_writer::put(result, io::clip_u32(files.size()));
+		binary_writer::put(result, functions_offset);
+		binary_writer::put(result, static_cast<uint32_t>(function_entry::size));
+		binary_writer::put(result, function_count);
+		binary_writer::put(result, lines_offset);
+		binary_writer::put(result, line_count * 2);
+		binary_writer::put(result, branches_offset);
+		binary_writer::put(result, io::clip_u32(branch_count *
+		                                        branch_entry::size));
+		result.append(strings);
+		result.append(file_entries);
+		result.append(function_entries);
+		result.append(line_entries);
+		result.append(branch_entries);
+		return result;
+	}
+}  // namespace cov::app::report
@@ -1,12 +1,14 @@
 // Copyright (c) 2022 Marcin Zdun
 // This code is licensed under MIT license (see LICENSE for details)
 
+#include <algorithm>
 #include <cov/app/path.hh>
 #include <cov/app/report_command.hh>
 #include <cov/app/rt_path.hh>
 #include <cov/app/tools.hh>
 #include <cov/format.hh>
 #include <cov/io/file.hh>
+#include <git2/refs.h>
 #include <json/json.hpp>
 
 namespace cov::app::builtin::report {
@@ -50,17 +52,42 @@ namespace cov::app::builtin::report {
 
 			return left_data == right_data;
 		}
+
+		std::filesystem::path work_dir_of(git::repository_handle repo) {
+			auto dir = repo.work_dir();
+			if (!dir) dir = repo.common_dir();
+			return make_u8path(*dir);
+		}
+
+		git_info head_of(git::repository_handle repo) {
+			git_info result{};
+			std::error_code ec{};
+			if (auto const head = repo.head(ec); !ec && head) {
+				if (auto const branch = git_reference_shorthand(head.raw()))
+					result.branch = branch;
+				auto const resolved = head.resolve(ec);
+				auto const target =
+				    ec ? nullptr : git_reference_target(resolved.raw());
+				if (target) result.head = git::oid_view{*target}.str();
+			}
+			return result;
+		}
 	}  // namespace
 
 	parser::parser(::args::args_view const& arguments,
 	               str::translator_open_info const& langs)
 	    : base_parser<errlng, replng>{langs, arguments} {
 		static constexpr std::string_view filters[] = {
-		    "cobertura"sv, "coveralls"sv, "strip-excludes"sv};
+		    "cobertura"sv, "coveralls"sv, "gcov"sv, "llvm-cov"sv,
+		    "strip-excludes"sv};
 
-		parser_.arg(report_)
+		parser_
+		    .custom([this](std::string const& path) {
+			    inputs_.push_back({.path = path, .first_prop = props_.size()});
+		    })
 		    .meta(tr_(replng::REPORT_FILE_META))
-		    .help(tr_(replng::REPORT_FILE_DESCRIPTION));
+		    .help(tr_(replng::REPORT_FILE_DESCRIPTION))
+		    .multi();
 		parser_.arg(filter_, "f", "filter")
 		    .meta(tr_(replng::FILTER_META))
 		    .help(tr_.format(replng::FILTER_DESCRIPTION, quoted_list(filters)));
@@ -71,6 +98,13 @@ namespace cov::app::builtin::report {
 		parser_.set<std::true_type>(amend_, "amend")
 		    .help(tr_(replng::AMEND_DESCRIPTION))
 		    .opt();
+		parser_.arg(jobs_, "j", "jobs")
+		    .meta(tr_(replng::JOBS_META))
+		    .help(tr_(replng::JOBS_DESCRIPTION))
+		    .opt();
+		parser_.set<std::true_type>(verbose_, "v", "verbose")
+		    .help(tr_(replng::VERBOSE_DESCRIPTION))
+		    .opt();
 		parser_.arg(output_, "o", "out").opt();
 	}
 
@@ -92,10 +126,12 @@ namespace cov::app::builtin::report {
 		if (output_) {
 			if (!filter_) error("--out requires --filter");
 			if (amend_) error("--out cannot be used with --amend");
+			if (inputs_.size() > 1) error("--out requires a single report");
 
-			auto const text = report_contents(result.repo.git(), rest);
+			auto const text = report_contents(result.repo.git(),
+			                                  inputs_.front().path, rest);
 			if (*output_ == "-") {
-				fputs(text.c_str(), stdout);
+				fwrite(text.data(), 1, text.size(), stdout);
 			} else {
 				auto filename = make_u8path(*output_);
 				auto dirname = filename.parent_path();
@@ -109,41 +145,205 @@ namespace cov::app::builtin::report {
 			std::exit(0);
 		}  // GCOV_EXCL_LINE[GCC, MSVC]
 
-		if (!result.report.load_from_text(
-		        report_contents(result.repo.git(), rest))) {
-			if (filter_) {
-				simple_error(tr_, parser_.program(),
-				             tr_.format(replng::ERROR_FILTERED_REPORT_ISSUES,
-				                        report_, *filter_));
-			} else {  // GCOV_EXCL_LINE[WIN32]
-				simple_error(tr_, parser_.program(),
-				             tr_.format(replng::ERROR_REPORT_ISSUES, report_));
-			}
+		load_inputs(result.repo.git(), rest, result.inputs);
+		if (result.inputs.size() > 1) {
+			std::vector<report_info const*> reports{};
+			reports.reserve(result.inputs.size());
+			for (auto const& input : result.inputs)
+				reports.push_back(&input.report);
+			result.merged = report_info::merge(reports, jobs());
 		}
-		result.props = cov::report::builder::properties(props_);
 		return result;
 	}  // GCOV_EXCL_LINE[GCC] -- and now it wants to throw something...
 
 	std::string parser::report_contents(git::repository_handle repo,
+	                                    std::string const& path,
 	                                    ::args::arglist args) const {
-		auto source = io::fopen(make_u8path(report_));
-		if (!source) error(tr_.format(str::args::lng::FILE_NOT_FOUND, report_));
+		auto const dir = work_dir_of(repo);
 
-		auto content = source.read();
-		if (filter_) {
-			auto dir = repo.work_dir();
-			if (!dir) dir = repo.common_dir();
-			content = filter(content, *filter_, args, make_u8path(*dir));
+		if (is_native()) {
+			std::error_code ec{};
+			if (!std::filesystem::exists(make_u8path(path), ec))
+				error(tr_.format(str::args::lng::FILE_NOT_FOUND, path));
+
+			report_info report{};
+			if (!import_native(path, dir, head_of(repo), jobs(), report)) {
+				simple_error(tr_, parser_.program(),
+				             tr_.format(replng::ERROR_FILTERED_REPORT_ISSUES,
+				                        path, *filter_));
+			}
+			return report.to_binary();
 		}
 
-		return {reinterpret_cast<char const*>(content.data()), content.size()};
+		int return_code{};
+		ref_ptr<io::shared_bytes> content{};
+		switch (read_input(path, args, dir, return_code, content)) {
+			case load_status::not_found:
+				error(tr_.format(str::args::lng::FILE_NOT_FOUND, path));
+			case load_status::filter_failed:
+				filter_failed(return_code);
+			default:
+				break;
+		}
+
+		auto const bytes = content->data();
+		return {reinterpret_cast<char const*>(bytes.data()), bytes.size()};
 	}
 
-	std::vector<std::byte> parser::filter(
-	    std::vector<std::byte> const& contents,
-	    std::string_view filter,
+	parser::load_status parser::read_input(
+	    std::string const& path,
 	    ::args::arglist args,
-	    std::filesystem::path const& cwd) const {
+	    std::filesystem::path const& dir,
+	    int& return_code,
+	    ref_ptr<io::shared_bytes>& contents) const {
+		auto const input = make_u8path(path);
+		auto source = io::fopen(input);
+		if (!source) return load_status::not_found;
+
+		// the report is parsed straight from the mapped file, so only the
+		// files read from it take up the memory; empty files cannot be
+		// mapped
+		if (!filter_) {
+			contents = io::shared_bytes::map(input);
+			if (!contents) contents = io::shared_bytes::wrap(source.read());
+			return load_status::ok;
+		}
+
+		auto bytes = source.read();
+		return_code = try_filter(bytes, *filter_, args, dir);
+		if (return_code) return load_status::filter_failed;
+		contents = io::shared_bytes::wrap(std::move(bytes));
+		return load_status::ok;
+	}
+
+	parser::load_status parser::try_load(std::string const& path,
+	                                     std::filesystem::path const& dir,
+	                                     git_info const& head,
+	                                     unsigned jobs,
+	                                     ref_ptr<io::shared_bytes>&& contents,
+	                                     report_info& out) const {
+		if (is_native()) {
+			std::error_code ec{};
+			if (!std::filesystem::exists(make_u8path(path), ec))
+				return load_status::not_found;
+			return import_native(path, dir, head, jobs, out)
+			           ? load_status::ok
+			           : load_status::issues;
+		}
+
+		// each file is taken from the reader, as soon as it is complete
+		auto const bytes = contents->data();
+		out.files.clear();
+		auto const loaded = report_info::read(
+		    {reinterpret_cast<char const*>(bytes.data()), bytes.size()},
+		    out.git, [&files = out.files](file_info&& file) {
+			    files.push_back(std::move(file));
+		    });
+		contents = {};
+		if (!loaded) out.files.clear();
+		return loaded ? load_status::ok : load_status::issues;
+	}
+
+	void parser::load_inputs(git::repository_handle repo,
+	                         ::args::arglist args,
+	                         std::vector<input_report>& out) const {
+		auto const dir = work_dir_of(repo);
+		auto const head = is_native() ? head_of(repo) : git_info{};
+		auto const count = inputs_.size();
+
+		// filters are separate processes, run one after another; only the
+		// parsing below is spread over the threads
+		std::vector<ref_ptr<io::shared_bytes>> contents(count);
+		if (!is_native()) {
+			for (size_t index = 0; index < count; ++index) {
+				auto const& path = inputs_[index].path;
+				int return_code{};
+				auto const status =
+				    read_input(path, args, dir, return_code, contents[index]);
+				if (status == load_status::not_found)
+					error(tr_.format(str::args::lng::FILE_NOT_FOUND, path));
+				if (status == load_status::filter_failed)
+					filter_failed(return_code);
+			}
+		}
+
+		// a single input, like the gcov directory, gets all the threads
+		// for itself
+		auto const input_jobs = count > 1 ? 1u : jobs();
+		std::vector<load_status> status(count);
+		out.resize(count);
+		parallel_for(count, jobs(), [&](size_t index) {
+			status[index] =
+			    try_load(inputs_[index].path, dir, head, input_jobs,
+			             std::move(contents[index]), out[index].report);
+		});
+
+		// report in the order of the inputs, no matter which thread
+		// finished first
+		for (size_t index = 0; index < count; ++index) {
+			auto const& path = inputs_[index].path;
+			if (status[index] == load_status::not_found)
+				error(tr_.format(str::args::lng::FILE_NOT_FOUND, path));
+			if (status[index] != load_status::ok) {
+				if (filter_) {
+					simple_error(
+					    tr_, parser_.program(),
+					    tr_.format(replng::ERROR_FILTERED_REPORT_ISSUES, path,
+					               *filter_));
+				}  // GCOV_EXCL_LINE[WIN32]
+				simple_error(tr_, parser_.program(),
+				             tr_.format(replng::ERROR_REPORT_ISSUES, path));
+			}
+			out[index].props = input_props(index);
+		}
+
+		// the builds go into a single report, so they need to describe the
+		// same commit and be told apart by their properties
+		auto const& first = out.front().report.git.head;
+		for (size_t index = 1; index < count; ++index) {
+			if (out[index].report.git.head != first) {
+				data_error(replng::ERROR_DIFFERENT_COMMITS,
+				           inputs_[index].path, inputs_.front().path);
+			}
+			for (size_t prev = 0; prev < index; ++prev) {
+				if (out[index].props == out[prev].props) {
+					data_error(replng::ERROR_SAME_PROPERTIES,
+					           inputs_[index].path, inputs_[prev].path);
+				}
+			}
+		}
+	}
+
+	std::string parser::input_props(size_t index) const {
+		auto const at = [this](size_t first_prop) {
+			return props_.begin() + static_cast<ptrdiff_t>(first_prop);
+		};
+		auto const last = index + 1 < inputs_.size()
+		                      ? at(inputs_[index + 1].first_prop)
+		                      : props_.end();
+
+		std::vector<std::string> propset{props_.begin(),
+		                                 at(inputs_.front().first_prop)};
+		propset.insert(propset.end(), at(inputs_[index].first_prop), last);
+		return cov::report::builder::properties(propset);
+	}
+
+	bool parser::import_native(std::string const& path,
+	                           std::filesystem::path const& dir,
+	                           git_info const& head,
+	                           unsigned jobs,
+	                           report_info& out) const {
+		auto const input = make_u8path(path);
+		out.git = head;
+		if (*filter_ == "llvm-cov"sv)
+			return out.load_from_llvm_cov(input, dir, jobs);
+		return out.load_from_gcov(input, dir, jobs);
+	}
+
+	int parser::try_filter(std::vector<std::byte>& contents,
+	                       std::string_view filter,
+	                       ::args::arglist args,
+	                       std::filesystem::path const& cwd) const {
 		auto output = platform::run_filter(
 		    platform::sys_root() / directory_info::share / "filters"sv, cwd,
 		    filter, args, contents);
@@ -151,7 +351,10 @@ namespace cov::app::builtin::report {
 		if (!output.error.empty())
 			fwrite(output.error.data(), 1, output.error.size(), stderr);
 
-		if (!output.output.empty()) {
+		if (!output.output.empty() &&
+		    !report_info::is_binary(
+		        {reinterpret_cast<char const*>(output.output.data()),
+		         output.output.size()})) {
 			const auto value = json::read_json(
 			    {reinterpret_cast<char8_t const*>(output.output.data()),
 			     output.output.size()},
@@ -162,15 +365,16 @@ namespace cov::app::builtin::report {
 			}
 		}
 
-		if (output.return_code) {
-			if (output.return_code == -ENOENT)
-				data_error(replng::ERROR_FILTER_NOENT, filter);
-			if (output.return_code == -EACCES)
-				data_error(replng::ERROR_FILTER_ACCESS, filter);
-			data_error(replng::ERROR_FILTER_FAILED, filter, output.return_code);
-		}
+		contents = std::move(output.output);
+		return output.return_code;
+	}
 
-		return std::move(output.output);
+	void parser::filter_failed(int return_code) const {
+		if (return_code == -ENOENT)
+			data_error(replng::ERROR_FILTER_NOENT, *filter_);
+		if (return_code == -EACCES)
+			data_error(replng::ERROR_FILTER_ACCESS, *filter_);
+		data_error(replng::ERROR_FILTER_FAILED, *filter_, return_code);
 	}
 
 	bool parser::store_build(git::oid& out,
@@ -242,6 +446,10 @@ namespace cov::app::builtin::report {
 				data_error(replng::ERROR_CANNOT_WRITE_TO_DB);
 			}  // GCOV_EXCL_STOP
 
+			// the graph only speeds up walking the history; without it,
+			// the reports are still there to be read
+			repo.update_report_graph(result.tip);
+
 			if (repo.update_current_head(result.tip, HEAD)) {
 				size_t size = HEAD.branch.size();
 				for (auto const c : HEAD.branch)
@@ -335,6 +543,22 @@ namespace cov::app::builtin::report {
 		std::fputs(message.c_str(), stdout);
 	}
 
+	void parser::print_write_stats(repository const& repo) const {
+		if (!verbose_) return;
+
+		using str::cov_report::counted;
+		auto const stats = repo.write_stats();
+		auto const written = fmt::format(
+		    fmt::runtime(tr_(counted::MESSAGE_OBJECTS_WRITTEN,
+		                     static_cast<intmax_t>(stats.written))),
+		    stats.written);
+		auto const skipped = fmt::format(
+		    fmt::runtime(tr_(counted::MESSAGE_OBJECTS_SKIPPED,
+		                     static_cast<intmax_t>(stats.skipped))),
+		    stats.skipped);
+		fmt::print("{}, {}\n", written, skipped);
+	}
+
 	std::string parser::quoted_list(std::span<std::string_view const> names) {
 		auto begin = std::begin(names);
 		auto end = std::next(std::end(names), -1);
@@ -355,33 +579,86 @@ namespace cov::app::builtin::report {
 	std::vector<stored_file> stored_file::from(
 	    git_commit const& commit,
 	    std::vector<file_info> const& info,
-	    parser const& p) {
-		std::vector<stored_file> result{};
-		result.reserve(info.size());
-
+	    parser const& p,
+	    unsigned jobs) {
+		std::vector<stored_file> result(info.size());
+		parallel_for(info.size(), jobs, [&](size_t index) {
+			result[index] = from(commit, info[index]);
+		});
+
+		// report in the order of the files, no matter which thread
+		// finished first
+		auto it = result.begin();
 		for (auto const& file : info) {
-			result.push_back(from(commit, file));
+			auto const& stored = *it++;
 
-			if (result.back().stg.flags == text::missing)
+			if (stored.stg.flags == text::missing)
 				p.data_error(replng::ERROR_CANNOT_FIND_FILE, file.name);
 
-			if ((result.back().stg.flags & text::mismatched) ==
-			    text::mismatched)
+			if ((stored.stg.flags & text::mismatched) == text::mismatched)
 				p.data_warning(replng::WARNING_FILE_MODIFIED, file.name);
 		}
 
 		return result;
 	}  // GCOV_EXCL_LINE[GCC]
 
+	std::vector<stored_file> stored_file::from(
+	    std::vector<file_info> const& merged_infos,
+	    std::vector<stored_file> const& merged,
+	    std::vector<file_info> const& info) {
+		std::map<std::string_view, blob_info const*> verified{};
+		for (size_t index = 0; index < merged_infos.size(); ++index)
+			verified[merged_infos[index].name] = &merged[index].stg;
+
+		std::vector<stored_file> result(info.size());
+		for (size_t index = 0; index < info.size(); ++index) {
+			// every file of a build is also in the merged report
+			result[index].stg = *verified.at(info[index].name);
+		}
+		return result;
+	}
+
 	void stored_file::store(cov::repository& repo,
 	                        file_info const& info,
 	                        parser const& p) {
+		report_error(try_store(repo, info), info, p);
+	}
+
+	void stored_file::store(cov::repository& repo,
+	                        std::vector<file_info> const& infos,
+	                        std::vector<stored_file>& files,
+	                        parser const& p,
+	                        unsigned jobs,
+	                        bool with_contents) {
+		std::vector<store_error> errors(infos.size());
+		parallel_for(infos.size(), jobs, [&](size_t index) {
+			errors[index] =
+			    files[index].try_store(repo, infos[index], with_contents);
+		});
+
+		// any error below ends the command, so the objects of this report
+		// would never be used
+		if (std::ranges::any_of(errors, [](store_error error) {
+			    return error != store_error::none;
+		    }))
+			repo.rollback_batch();
+
+		for (size_t index = 0; index < infos.size(); ++index) {
+			report_error(errors[index], infos[index], p);
+		}
+	}
+
+	stored_file::store_error stored_file::try_store(cov::repository& repo,
+	                                                file_info const& info,
+	                                                bool with_contents) {
 		if (!store_coverage(repo, info)) {
 			// GCOV_EXCL_START
 			[[unlikely]];
-			p.data_error(replng::ERROR_CANNOT_WRITE_TO_DB);
+			return store_error::cannot_write;
 		}  // GCOV_EXCL_STOP
 
+		if (!with_contents) return store_error::none;
+
 		if ((stg.flags & text::in_repo) != text::in_repo ||
 		    (stg.flags & text::mismatched) == text::mismatched) {
 			auto const work_dir = repo.git_work_dir();
@@ -393,7 +670,7 @@ namespace cov::app::builtin::report {
 				// allow this to happen and yet failed here seems
 				// infeasible
 				[[unlikely]];
-				p.data_error(replng::ERROR_BARE_GIT);
+				return store_error::bare_git;
 			}  // GCOV_EXCL_STOP
 
 			auto const opened =
@@ -402,16 +679,35 @@ namespace cov::app::builtin::report {
 				// GCOV_EXCL_START
 				// same here: we read this file once already...
 				[[unlikely]];
-				p.data_error(replng::ERROR_CANNOT_OPEN_FILE, info.name);
+				return store_error::cannot_open;
 			}  // GCOV_EXCL_STOP
 
 			auto bytes = opened.read();
 			if (!store_contents(repo, {bytes.data(), bytes.size()})) {
 				// GCOV_EXCL_START
 				[[unlikely]];
-				p.data_error(replng::ERROR_CANNOT_WRITE_TO_DB);
+				return store_error::cannot_write;
 			}  // GCOV_EXCL_STOP
 		}
+
+		return store_error::none;
+	}
+
+	void stored_file::report_error(store_error error,
+	                               file_info const& info,
+	                               parser const& p) {
+		switch (error) {
+			case store_error::none:
+				break;
+			// GCOV_EXCL_START
+			case store_error::cannot_write:
+				p.data_error(replng::ERROR_CANNOT_WRITE_TO_DB);
+			case store_error::bare_git:
+				p.data_error(replng::ERROR_BARE_GIT);
+			case store_error::cannot_open:
+				p.data_error(replng::ERROR_CANNOT_OPEN_FILE, info.name);
+				// GCOV_EXCL_STOP
+		}
 	}
 
 	bool stored_file::store_coverage(cov::repository& repo,
@@ -435,8 +731,20 @@ namespace cov::app::builtin::report {
 			if (fun.count) ++stats.functions.visited;
 		}
 
-		return repo.write(lines_id, obj_cvg) &&
-		       repo.write(functions_id, obj_functions);
+		if (!repo.write(lines_id, obj_cvg) ||
+		    !repo.write(functions_id, obj_functions))
+			return false;
+
+		// files without branches do not get an object at all, so the
+		// files::entry of such file stays the same as before
+		if (info.branch_coverage.empty()) return true;
+
+		cov::branch_coverage::builder branches{};
+		for (auto const& [line, line_branches] : info.branch_coverage)
+			branches.add(line, line_branches);
+		auto const obj_branches = branches.extract();
+		stats.branches = obj_branches->summary();
+		return repo.write(branches_id, obj_branches);
 	}
 
 	bool stored_file::store_contents(cov::repository& repo,
@@ -0,0 +1,285 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <algorithm>
+#include <cov/app/path.hh>
+#include <cov/app/report.hh>
+#include <cov/io/file.hh>
+#include <cov/parallel.hh>
+#include <cov/zstream.hh>
+#include <fmt/format.h>
+#include <optional>
+#include <utility>
+#include "json_reader.hh"
+#include "report_import.hh"
+
+namespace cov::app::report {
+	using namespace std::literals;
+
+	namespace {
+		using namespace import;
+
+		using named_sources =
+		    std::vector<std::pair<std::string, source_counters>>;
+
+		// Reads one intermediate JSON document, as written by
+		// `gcov --json-format`. Files are kept with the names gcov gave
+		// them, since the working directory may come after them.
+		class gcov_reader {
+		public:
+			explicit gcov_reader(std::string_view text) : json_{text} {}
+
+			bool read(std::string& cwd, named_sources& files) {
+				if (json_.peek() != json_reader::kind::object) return false;
+
+				bool has_files{false};
+				json_.enter_object();
+				std::string key{};
+				while (json_.next_key(key)) {
+					if (key == "current_working_directory"sv) {
+						auto value = json_.read_string();
+						if (!value) return false;
+						cwd = std::move(*value);
+					} else if (key == "files"sv) {
+						has_files = true;
+						if (!read_files(files)) return false;
+					} else {
+						json_.skip_value();
+					}
+				}
+
+				return has_files && json_.finished();
+			}
+
+		private:
+			bool read_files(named_sources& files) {
+				if (json_.peek() != json_reader::kind::array) return false;
+
+				json_.enter_array();
+				while (json_.next_item()) {
+					if (json_.peek() != json_reader::kind::object)
+						return false;
+
+					std::optional<std::string> name{};
+					source_counters file{};
+					json_.enter_object();
+					std::string key{};
+					while (json_.next_key(key)) {
+						if (key == "file"sv) {
+							name = json_.read_string();
+						} else if (key == "lines"sv) {
+							if (!read_lines(file)) return false;
+						} else if (key == "functions"sv) {
+							if (!read_functions(file)) return false;
+						} else {
+							json_.skip_value();
+						}
+					}
+
+					if (!name) return false;
+					files.emplace_back(std::move(*name), std::move(file));
+				}
+				return !json_.failed();
+			}
+
+			bool read_lines(source_counters& file) {
+				if (json_.peek() != json_reader::kind::array) return false;
+
+				json_.enter_array();
+				while (json_.next_item()) {
+					if (json_.peek() != json_reader::kind::object)
+						return false;
+
+					std::optional<long long> line{}, count{};
+					json_.enter_object();
+					std::string key{};
+					while (json_.next_key(key)) {
+						if (key == "line_number"sv)
+							line = json_.read_integer();
+						else if (key == "count"sv)
+							count = json_.read_integer();
+						else
+							json_.skip_value();
+					}
+
+					if (!line || !count) return false;
+					// a line is listed again for each function defined on it
+					file.add_line(rebased(*line), count_from(*count));
+				}
+				return !json_.failed();
+			}
+
+			bool read_functions(source_counters& file) {
+				if (json_.peek() != json_reader::kind::array) return false;
+
+				json_.enter_array();
+				while (json_.next_item()) {
+					if (json_.peek() != json_reader::kind::object)
+						return false;
+
+					std::optional<std::string> name{}, demangled{};
+					std::optional<long long> count{}, start_line{},
+					    start_column{}, end_line{}, end_column{};
+					json_.enter_object();
+					std::string key{};
+					while (json_.next_key(key)) {
+						if (key == "name"sv)
+							name = json_.read_string();
+						else if (key == "demangled_name"sv)
+							demangled = json_.read_string();
+						else if (key == "execution_count"sv)
+							count = json_.read_integer();
+						else if (key == "start_line"sv)
+							start_line = json_.read_integer();
+						else if (key == "start_column"sv)
+							start_column = json_.read_integer();
+						else if (key == "end_line"sv)
+							end_line = json_.read_integer();
+						else if (key == "end_column"sv)
+							end_column = json_.read_integer();
+						else
+							json_.skip_value();
+					}
+
+					if (!name || !count || !start_line) return false;
+
+					function_counters function{};
+					if (demangled)
+						function.demangled_name = std::move(*demangled);
+					function.count = count_from(*count);
+					function.start.line = rebased(*start_line);
+					function.start.column =
+					    clamped(count_from(start_column.value_or(0)));
+					function.end.line = rebased(end_line.value_or(*start_line));
+					function.end.column =
+					    clamped(count_from(end_column.value_or(0)));
+
+					file.add_function(std::move(*name), std::move(function));
+				}
+				return !json_.failed();
+			}
+
+			json_reader json_;
+		};
+
+		// State of a single thread: its share of the counters and the names
+		// it already resolved against the work dir.
+		class gcov_worker {
+		public:
+			explicit gcov_worker(std::filesystem::path const& work_dir)
+			    : names_{work_dir} {}
+
+			sources files{};
+
+			bool load(std::filesystem::path const& input) {
+				auto source = io::fopen(input);
+				if (!source) return false;
+				auto const contents = source.read();
+
+				std::string text{};
+				if (is_gzip(contents)) {
+					buffer_zstream z{zstream::inflate, zstream::gzip};
+					if (z.append({contents.data(), contents.size()}) !=
+					    contents.size())
+						return false;
+					auto const block = z.close();
+					if (!z.complete()) return false;
+					text.assign(
+					    reinterpret_cast<char const*>(block.data.data()),
+					    block.data.size());
+				} else {
+					text.assign(reinterpret_cast<char const*>(contents.data()),
+					            contents.size());
+				}
+
+				std::string cwd{};
+				named_sources document{};
+				if (!gcov_reader{text}.read(cwd, document)) return false;
+
+				for (auto& [name, file] : document) {
+					auto const& resolved = names_.resolve(cwd, name);
+					// system headers, build directory and the like
+					if (!resolved) continue;
+					files[*resolved].merge(std::move(file));
+				}
+				return true;
+			}
+
+		private:
+			static bool is_gzip(std::vector<std::byte> const& contents) {
+				return contents.size() > 1 &&
+				       contents[0] == std::byte{0x1f} &&
+				       contents[1] == std::byte{0x8b};
+			}
+
+			source_names names_;
+		};
+
+		std::vector<std::filesystem::path> gcov_inputs(
+		    std::filesystem::path const& input) {
+			std::vector<std::filesystem::path> result{};
+			std::error_code ec{};
+			if (!std::filesystem::is_directory(input, ec)) {
+				result.push_back(input);
+				return result;
+			}
+
+			static constexpr auto suffix = ".gcov.json.gz"sv;
+			for (auto const& entry :
+			     std::filesystem::recursive_directory_iterator{input, ec}) {
+				if (!entry.is_regular_file(ec)) continue;
+				auto const filename = generic_u8path(entry.path().filename());
+				if (filename.ends_with(suffix)) result.push_back(entry.path());
+			}
+			// the order of the directory listing depends on the filesystem
+			std::sort(result.begin(), result.end());
+			return result;
+		}
+	}  // namespace
+
+	bool report_info::load_from_gcov(std::filesystem::path const& input,
+	                                 std::filesystem::path const& work_dir,
+	                                 unsigned jobs) {
+		files.clear();
+
+		auto const inputs = gcov_inputs(input);
+		if (inputs.empty()) {
+			fmt::print(stderr, "cov report: {}: no gcov JSON files\n",
+			           get_u8path(input));
+			return false;
+		}
+
+		std::error_code ec{};
+		auto const root = std::filesystem::weakly_canonical(work_dir, ec);
+		if (ec) return false;
+
+		std::vector<gcov_worker> workers(parallel_workers(inputs.size(), jobs),
+		                                 gcov_worker{root});
+		std::vector<char> loaded(inputs.size());
+		parallel_for(inputs.size(), jobs, [&](size_t index, unsigned worker) {
+			loaded[index] = workers[worker].load(inputs[index]);
+		});
+
+		bool ok = true;
+		for (size_t index = 0; index < inputs.size(); ++index) {
+			if (loaded[index]) continue;
+			fmt::print(stderr, "cov report: {}: not a gcov JSON file\n",
+			           get_u8path(inputs[index]));
+			ok = false;
+		}
+		if (!ok) return false;
+
+		auto& merged = workers.front().files;
+		for (size_t index = 1; index < workers.size(); ++index) {
+			for (auto& [name, file] : workers[index].files)
+				merged[name].merge(std::move(file));
+		}
+
+		files.reserve(merged.size());
+		for (auto& [name, file] : merged)
+			files.push_back(to_file_info(name, std::move(file)));
+
+		digest_sources(files, root, jobs);
+		return true;
+	}
+}  // namespace cov::app::report
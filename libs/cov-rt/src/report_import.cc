@@ -0,0 +1,142 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include "report_import.hh"
+#include <algorithm>
+#include <cov/app/path.hh>
+#include <cov/hash/sha1.hh>
+#include <cov/io/file.hh>
+#include <cov/parallel.hh>
+#include <fmt/format.h>
+
+namespace cov::app::report::import {
+	using namespace std::literals;
+
+	void source_counters::add_function(std::string&& name,
+	                                   function_counters&& function) {
+		auto const line = function.start.line;
+		auto [it, inserted] = functions.try_emplace({line, std::move(name)},
+		                                            std::move(function));
+		if (!inserted) it->second.count += function.count;
+	}
+
+	void source_counters::add_branch(unsigned line,
+	                                 size_t index,
+	                                 branch_counters const& branch) {
+		auto& known = branches[line];
+		if (known.size() <= index) known.resize(index + 1);
+		known[index].taken += branch.taken;
+		known[index].not_taken += branch.not_taken;
+	}
+
+	void source_counters::merge(source_counters&& other) {
+		lines.insert(lines.end(), other.lines.begin(), other.lines.end());
+		for (auto& [key, function] : other.functions) {
+			auto [it, inserted] =
+			    functions.try_emplace(key, std::move(function));
+			if (!inserted) it->second.count += function.count;
+		}
+		for (auto const& [line, line_branches] : other.branches) {
+			for (size_t index = 0; index < line_branches.size(); ++index)
+				add_branch(line, index, line_branches[index]);
+		}
+	}
+
+	file_info to_file_info(std::string const& name, source_counters&& file) {
+		file_info result{};
+		result.name = name;
+		auto const by_line = [](auto const& lhs, auto const& rhs) {
+			return lhs.first < rhs.first;
+		};
+		// lines from a single input are usually in order already
+		if (!std::is_sorted(file.lines.begin(), file.lines.end(), by_line))
+			std::sort(file.lines.begin(), file.lines.end(), by_line);
+		result.line_coverage.reserve(file.lines.size());
+		for (auto it = file.lines.begin(); it != file.lines.end();) {
+			auto const line = it->first;
+			count_type count{};
+			for (; it != file.lines.end() && it->first == line; ++it)
+				count += it->second;
+			result.line_coverage.push_back({line, clamped(count)});
+		}
+		result.function_coverage.reserve(file.functions.size());
+		for (auto& [key, function] : file.functions) {
+			result.function_coverage.push_back({
+			    .name = std::move(key.second),
+			    .demangled_name = std::move(function.demangled_name),
+			    .count = clamped(function.count),
+			    .start = function.start,
+			    .end = function.end,
+			});
+		}
+		std::sort(result.function_coverage.begin(),
+		          result.function_coverage.end());
+		for (auto const& [line, line_branches] : file.branches) {
+			auto& out = result.branch_coverage[line];
+			out.reserve(line_branches.size());
+			for (auto const& branch : line_branches) {
+				out.push_back({.taken = clamped(branch.taken),
+				               .not_taken = clamped(branch.not_taken)});
+			}
+		}
+		return result;
+	}
+
+	std::string generic_u8path(std::filesystem::path const& path) {
+		auto u8 = path.generic_u8string();
+		return {reinterpret_cast<char const*>(u8.data()), u8.size()};
+	}
+
+	std::optional<std::string> const& source_names::resolve(
+	    std::string const& cwd,
+	    std::string const& name) {
+		auto key = cwd;
+		key.push_back('\0');
+		key.append(name);
+		auto it = resolved_.lower_bound(key);
+		if (it != resolved_.end() && it->first == key) return it->second;
+
+		std::optional<std::string> result{};
+		auto path = make_u8path(name);
+		if (path.is_relative()) path = make_u8path(cwd) / path;
+		std::error_code ec{};
+		path = std::filesystem::weakly_canonical(path, ec);
+		if (!ec) {
+			auto relative = generic_u8path(path.lexically_relative(work_dir_));
+			auto const outside = relative.empty() || relative == ".."sv ||
+			                     relative.starts_with("../"sv);
+			if (!outside) result = std::move(relative);
+		}
+
+		return resolved_.emplace_hint(it, std::move(key), result)->second;
+	}
+
+	void digest_sources(std::vector<file_info>& files,
+	                    std::filesystem::path const& work_dir,
+	                    unsigned jobs) {
+		std::vector<char> found(files.size());
+		parallel_for(files.size(), jobs, [&](size_t index) {
+			auto& file = files[index];
+			auto source = io::fopen(work_dir / make_u8path(file.name));
+			if (!source) return;
+			auto const contents = source.read();
+			file.algorithm = digest::sha1;
+			file.digest =
+			    hash::sha1::once({contents.data(), contents.size()}).str();
+			found[index] = true;
+		});
+
+		auto out = files.begin();
+		for (size_t index = 0; index < files.size(); ++index) {
+			if (!found[index]) {
+				fmt::print(stderr, "cov report: {}: cannot read the source\n",
+				           files[index].name);
+				continue;
+			}
+			if (out != files.begin() + static_cast<ptrdiff_t>(index))
+				*out = std::move(files[index]);
+			++out;
+		}
+		files.erase(out, files.end());
+	}
+}  // namespace cov::app::report::import
@@ -0,0 +1,96 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#pragma once
+
+#include <cov/app/report.hh>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cov::app::report::import {
+	using count_type = unsigned long long;
+
+	inline unsigned clamped(count_type value) {
+		static constexpr count_type max_value =
+		    std::numeric_limits<unsigned>::max();
+		return static_cast<unsigned>(std::min(value, max_value));
+	}
+
+	inline count_type count_from(long long value) {
+		return value < 0 ? 0 : static_cast<count_type>(value);
+	}
+
+	// one-based line from the coverage tool to the zero-based report line
+	inline unsigned rebased(long long line) {
+		auto const result = clamped(count_from(line));
+		return result ? result - 1 : 0;
+	}
+
+	struct function_counters {
+		std::string demangled_name{};
+		count_type count{};
+		io::v1::text_pos start{0, 0};
+		io::v1::text_pos end{0, 0};
+	};
+
+	struct branch_counters {
+		count_type taken{};
+		count_type not_taken{};
+	};
+
+	// Counters of a single source file, before they are clamped into the
+	// report. Line hits are only appended here, in any order and with
+	// repeats, and summed up once in to_file_info(), so building the report
+	// does not need a second map. Functions are keyed by their start line
+	// and linkage name, so the same function seen in many translation units
+	// is counted once. Branches are matched by their order on a line.
+	struct source_counters {
+		std::vector<std::pair<unsigned, count_type>> lines{};
+		std::map<std::pair<unsigned, std::string>, function_counters>
+		    functions{};
+		std::map<unsigned, std::vector<branch_counters>> branches{};
+
+		void add_line(unsigned line, count_type count) {
+			lines.emplace_back(line, count);
+		}
+		void add_function(std::string&& name, function_counters&& function);
+		void add_branch(unsigned line,
+		                size_t index,
+		                branch_counters const& branch);
+		void merge(source_counters&& other);
+	};
+
+	using sources = std::map<std::string, source_counters, std::less<>>;
+
+	file_info to_file_info(std::string const& name, source_counters&& file);
+
+	std::string generic_u8path(std::filesystem::path const& path);
+
+	// Names of the sources, as they are stored in the report: relative to
+	// the work dir, with forward slashes. Names already resolved are kept,
+	// since the same headers come up in most of the inputs.
+	class source_names {
+	public:
+		explicit source_names(std::filesystem::path const& work_dir)
+		    : work_dir_{work_dir} {}
+
+		// nullopt for files outside of the work dir
+		std::optional<std::string> const& resolve(std::string const& cwd,
+		                                          std::string const& name);
+
+	private:
+		std::filesystem::path const& work_dir_;
+		std::map<std::string, std::optional<std::string>> resolved_{};
+	};
+
+	// Coverage tools do not know the digests of the sources, so they are
+	// taken from the work dir; files, which cannot be read, are removed
+	// from the list with a warning.
+	void digest_sources(std::vector<file_info>& files,
+	                    std::filesystem::path const& work_dir,
+	                    unsigned jobs);
+}  // namespace cov::app::report::import
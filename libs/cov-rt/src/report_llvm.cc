@@ -0,0 +1,425 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <algorithm>
+#include <array>
+#include <cov/app/path.hh>
+#include <cov/app/report.hh>
+#include <cov/io/shared_bytes.hh>
+#include <fmt/format.h>
+#include <optional>
+#include <span>
+#include <utility>
+#include "json_reader.hh"
+#include "report_import.hh"
+
+namespace cov::app::report {
+	using namespace std::literals;
+
+	namespace {
+		using namespace import;
+
+		// [line, column, count, has_count, is_region_entry, is_gap_region]
+		struct segment {
+			long long line{};
+			long long count{};
+			bool has_count{};
+			bool region_entry{};
+			bool gap{};
+
+			bool starts_region() const noexcept {
+				return !gap && has_count && region_entry;
+			}
+		};
+
+		// [line_start, column_start, line_end, column_end, count, file_id,
+		//  expanded_file_id, kind]
+		struct region {
+			static constexpr size_t line_start = 0;
+			static constexpr size_t column_start = 1;
+			static constexpr size_t line_end = 2;
+			static constexpr size_t column_end = 3;
+			static constexpr size_t file_id = 5;
+			static constexpr size_t kind = 7;
+			static constexpr size_t size = 8;
+
+			// other kinds are expansions, skipped code and branches
+			static constexpr long long code_region = 0;
+		};
+		using region_values = std::array<long long, region::size>;
+
+		// [line_start, column_start, line_end, column_end, true_count,
+		//  false_count, file_id, expanded_file_id, kind]
+		struct branch_region {
+			long long line{};
+			long long column{};
+			long long true_count{};
+			long long false_count{};
+
+			auto operator<=>(branch_region const& rhs) const noexcept {
+				if (auto const cmp = line <=> rhs.line; cmp != 0) return cmp;
+				return column <=> rhs.column;
+			}
+		};
+
+		// branches of a line are numbered by their columns, so the same
+		// branch has the same index in every translation unit
+		void count_branches(std::vector<branch_region>& branches,
+		                    source_counters& file) {
+			std::stable_sort(branches.begin(), branches.end());
+			size_t index = 0;
+			for (auto it = branches.begin(); it != branches.end(); ++it) {
+				if (it != branches.begin() && std::prev(it)->line != it->line)
+					index = 0;
+				file.add_branch(rebased(it->line), index++,
+				                {
+				                    .taken = count_from(it->true_count),
+				                    .not_taken = count_from(it->false_count),
+				                });
+			}
+		}
+
+		// Same as the line counts of `llvm-cov show`: a line is counted,
+		// if a region starts on it, or a region from the lines above is
+		// still open over it; the count is the highest one of them.
+		void count_lines(std::span<segment const> segments,
+		                 source_counters& file) {
+			segment const* wrapped = nullptr;
+			size_t pos = 0;
+			for (auto line = segments.empty() ? 0 : segments.front().line;
+			     pos < segments.size(); ++line) {
+				auto const first = pos;
+				while (pos < segments.size() && segments[pos].line <= line)
+					++pos;
+				auto const here = segments.subspan(first, pos - first);
+
+				auto const starts = std::count_if(
+				    here.begin(), here.end(),
+				    [](segment const& seg) { return seg.starts_region(); });
+				auto const skipped = !here.empty() &&
+				                     !here.front().has_count &&
+				                     here.front().region_entry;
+				auto const mapped =
+				    !skipped && ((wrapped && wrapped->has_count) || starts);
+
+				if (mapped) {
+					auto count = wrapped ? count_from(wrapped->count) : 0;
+					for (auto const& seg : here) {
+						if (seg.starts_region())
+							count = std::max(count, count_from(seg.count));
+					}
+					file.add_line(rebased(line), count);
+				}
+
+				if (!here.empty()) wrapped = &here.back();
+			}
+		}
+
+		// Mangled names of functions with internal linkage are prefixed
+		// with the name of the file they come from.
+		std::string linkage_name(std::string&& name) {
+			auto const pos = name.rfind(':');
+			if (pos != std::string::npos) name.erase(0, pos + 1);
+			return std::move(name);
+		}
+
+		// Reads `llvm-cov export -format=text` output in a single pass, as
+		// each of the /data[]/files[] and /data[]/functions[] items is
+		// translated to counters as soon as it is read.
+		class llvm_reader {
+		public:
+			llvm_reader(std::string_view text,
+			            std::string const& work_dir,
+			            source_names& names,
+			            sources& out)
+			    : json_{text}, work_dir_{work_dir}, names_{names}, out_{out} {}
+
+			bool read() {
+				if (json_.peek() != json_reader::kind::object) return false;
+
+				bool has_data{false};
+				json_.enter_object();
+				std::string key{};
+				while (json_.next_key(key)) {
+					if (key == "data"sv) {
+						has_data = true;
+						if (!read_exports()) return false;
+					} else if (key == "type"sv) {
+						auto const type = json_.read_string();
+						if (type != "llvm.coverage.json.export"sv)
+							return false;
+					} else {
+						json_.skip_value();
+					}
+				}
+
+				return has_data && json_.finished();
+			}
+
+		private:
+			bool read_exports() {
+				if (json_.peek() != json_reader::kind::array) return false;
+
+				json_.enter_array();
+				while (json_.next_item()) {
+					if (json_.peek() != json_reader::kind::object)
+						return false;
+
+					json_.enter_object();
+					std::string key{};
+					while (json_.next_key(key)) {
+						if (key == "files"sv) {
+							if (!read_files()) return false;
+						} else if (key == "functions"sv) {
+							if (!read_functions()) return false;
+						} else {
+							json_.skip_value();
+						}
+					}
+				}
+				return !json_.failed();
+			}
+
+			bool read_files() {
+				if (json_.peek() != json_reader::kind::array) return false;
+
+				json_.enter_array();
+				while (json_.next_item()) {
+					if (json_.peek() != json_reader::kind::object)
+						return false;
+
+					std::optional<std::string> filename{};
+					segments_.clear();
+					branches_.clear();
+					json_.enter_object();
+					std::string key{};
+					while (json_.next_key(key)) {
+						if (key == "filename"sv) {
+							filename = json_.read_string();
+						} else if (key == "segments"sv) {
+							if (!read_segments()) return false;
+						} else if (key == "branches"sv) {
+							if (!read_branches()) return false;
+						} else {
+							json_.skip_value();
+						}
+					}
+
+					if (!filename) return false;
+					auto const& resolved =
+					    names_.resolve(work_dir_, *filename);
+					if (!resolved) continue;
+					auto& file = out_[*resolved];
+					count_lines(segments_, file);
+					count_branches(branches_, file);
+				}
+				return !json_.failed();
+			}
+
+			bool read_segments() {
+				if (json_.peek() != json_reader::kind::array) return false;
+
+				json_.enter_array();
+				while (json_.next_item()) {
+					if (json_.peek() != json_reader::kind::array)
+						return false;
+
+					json_.enter_array();
+					std::optional<long long> line{}, count{};
+					std::optional<bool> has_count{}, entry{}, gap{false};
+					if (json_.next_item()) line = json_.read_integer();
+					if (json_.next_item()) json_.skip_value();  // column
+					if (json_.next_item()) count = json_.read_integer();
+					if (json_.next_item()) has_count = json_.read_boolean();
+					if (json_.next_item()) entry = json_.read_boolean();
+					// older exports do not have gap regions
+					if (json_.next_item()) gap = json_.read_boolean();
+					while (json_.next_item())
+						json_.skip_value();
+
+					if (!line || !count || !has_count || !entry || !gap)
+						return false;
+					segments_.push_back({
+					    .line = *line,
+					    .count = *count,
+					    .has_count = *has_count,
+					    .region_entry = *entry,
+					    .gap = *gap,
+					});
+				}
+				return !json_.failed();
+			}
+
+			bool read_branches() {
+				if (json_.peek() != json_reader::kind::array) return false;
+
+				json_.enter_array();
+				while (json_.next_item()) {
+					if (json_.peek() != json_reader::kind::array)
+						return false;
+
+					std::array<long long, 6> values{};
+					size_t index = 0;
+					json_.enter_array();
+					for (; json_.next_item(); ++index) {
+						if (index >= values.size()) {
+							json_.skip_value();
+							continue;
+						}
+						auto const value = json_.read_integer();
+						if (!value) return false;
+						values[index] = *value;
+					}
+					if (index < values.size()) return false;
+
+					branches_.push_back({
+					    .line = values[0],
+					    .column = values[1],
+					    .true_count = values[4],
+					    .false_count = values[5],
+					});
+				}
+				return !json_.failed();
+			}
+
+			bool read_functions() {
+				if (json_.peek() != json_reader::kind::array) return false;
+
+				json_.enter_array();
+				while (json_.next_item()) {
+					if (json_.peek() != json_reader::kind::object)
+						return false;
+
+					std::optional<std::string> name{};
+					std::optional<long long> count{};
+					std::optional<region_values> body{};
+					std::vector<std::string> filenames{};
+					json_.enter_object();
+					std::string key{};
+					while (json_.next_key(key)) {
+						if (key == "name"sv) {
+							name = json_.read_string();
+						} else if (key == "count"sv) {
+							count = json_.read_integer();
+						} else if (key == "regions"sv) {
+							if (!read_regions(body)) return false;
+						} else if (key == "filenames"sv) {
+							if (!read_filenames(filenames)) return false;
+						} else {
+							json_.skip_value();
+						}
+					}
+
+					if (!name || !count) return false;
+					// a function without any code, nothing to show
+					if (!body) continue;
+
+					auto const file_id = (*body)[region::file_id];
+					if (file_id < 0 ||
+					    static_cast<size_t>(file_id) >= filenames.size())
+						return false;
+					auto const& resolved = names_.resolve(
+					    work_dir_, filenames[static_cast<size_t>(file_id)]);
+					if (!resolved) continue;
+
+					function_counters function{};
+					function.count = count_from(*count);
+					function.start = {
+					    rebased((*body)[region::line_start]),
+					    clamped(count_from((*body)[region::column_start])),
+					};
+					function.end = {
+					    rebased((*body)[region::line_end]),
+					    clamped(count_from((*body)[region::column_end])),
+					};
+					out_[*resolved].add_function(
+					    linkage_name(std::move(*name)), std::move(function));
+				}
+				return !json_.failed();
+			}
+
+			// keeps the first code region, which spans the function body
+			bool read_regions(std::optional<region_values>& body) {
+				if (json_.peek() != json_reader::kind::array) return false;
+
+				json_.enter_array();
+				while (json_.next_item()) {
+					if (json_.peek() != json_reader::kind::array)
+						return false;
+
+					region_values values{};
+					size_t index = 0;
+					json_.enter_array();
+					for (; json_.next_item(); ++index) {
+						if (index >= values.size()) {
+							json_.skip_value();
+							continue;
+						}
+						auto const value = json_.read_integer();
+						if (!value) return false;
+						values[index] = *value;
+					}
+					if (index <= region::file_id) return false;
+
+					if (!body && values[region::kind] == region::code_region)
+						body = values;
+				}
+				return !json_.failed();
+			}
+
+			bool read_filenames(std::vector<std::string>& filenames) {
+				if (json_.peek() != json_reader::kind::array) return false;
+
+				json_.enter_array();
+				while (json_.next_item()) {
+					auto filename = json_.read_string();
+					if (!filename) return false;
+					filenames.push_back(std::move(*filename));
+				}
+				return !json_.failed();
+			}
+
+			json_reader json_;
+			std::string const& work_dir_;
+			source_names& names_;
+			sources& out_;
+			// kept between the files, so the memory is only allocated for
+			// the longest list
+			std::vector<segment> segments_{};
+			std::vector<branch_region> branches_{};
+		};
+	}  // namespace
+
+	bool report_info::load_from_llvm_cov(std::filesystem::path const& input,
+	                                     std::filesystem::path const& work_dir,
+	                                     unsigned jobs) {
+		files.clear();
+
+		std::error_code ec{};
+		auto const root = std::filesystem::weakly_canonical(work_dir, ec);
+		if (ec) return false;
+		auto const root_name = generic_u8path(root);
+
+		// exports go into gigabytes; map them instead of reading
+		auto const contents = io::shared_bytes::map(input);
+		auto const bytes = contents ? contents->data() : git::bytes{};
+		std::string_view const text{
+		    reinterpret_cast<char const*>(bytes.data()), bytes.size()};
+
+		sources collected{};
+		source_names names{root};
+		if (!contents ||
+		    !llvm_reader{text, root_name, names, collected}.read()) {
+			fmt::print(stderr, "cov report: {}: not an llvm-cov export\n",
+			           get_u8path(input));
+			return false;
+		}
+
+		files.reserve(collected.size());
+		for (auto& [name, file] : collected)
+			files.push_back(to_file_info(name, std::move(file)));
+
+		digest_sources(files, root, jobs);
+		return true;
+	}
+}  // namespace cov::app::report
@@ -0,0 +1,72 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <cov/app/report.hh>
+#include <cov/parallel.hh>
+#include "report_import.hh"
+
+namespace cov::app::report {
+	report_info report_info::merge(
+	    std::span<report_info const* const> reports,
+	    unsigned jobs) {
+		report_info result{};
+		if (reports.empty()) return result;
+		result.git = reports.front()->git;
+
+		// only pointers are moved around here; the counters are summed
+		// below, one file per task
+		std::map<std::string_view, std::vector<file_info const*>> by_name{};
+		for (auto const* report : reports) {
+			for (auto const& file : report->files)
+				by_name[file.name].push_back(&file);
+		}
+
+		std::vector<std::vector<file_info const*> const*> groups{};
+		groups.reserve(by_name.size());
+		for (auto const& [_, group] : by_name)
+			groups.push_back(&group);
+
+		result.files.resize(groups.size());
+		parallel_for(groups.size(), jobs, [&](size_t index) {
+			auto const& group = *groups[index];
+			auto& merged = result.files[index];
+			if (group.size() == 1) {
+				merged = *group.front();
+				return;
+			}
+
+			import::source_counters counters{};
+			for (auto const* file : group) {
+				for (auto const& [line, count] : file->line_coverage)
+					counters.add_line(line, count);
+				for (auto const& fun : file->function_coverage) {
+					counters.add_function(std::string{fun.name},
+					                      {
+					                          .demangled_name =
+					                              fun.demangled_name,
+					                          .count = fun.count,
+					                          .start = fun.start,
+					                          .end = fun.end,
+					                      });
+				}
+				for (auto const& [line, branches] : file->branch_coverage) {
+					for (size_t index = 0; index < branches.size(); ++index) {
+						counters.add_branch(
+						    line, index,
+						    {
+						        .taken = branches[index].taken,
+						        .not_taken = branches[index].not_taken,
+						    });
+					}
+				}
+			}
+
+			auto const& first = *group.front();
+			merged = import::to_file_info(first.name, std::move(counters));
+			merged.algorithm = first.algorithm;
+			merged.digest = first.digest;
+		});
+
+		return result;
+	}
+}  // namespace cov::app::report
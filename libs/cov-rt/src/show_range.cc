@@ -202,17 +202,24 @@ namespace cov::app {
 	              cov::revs const& range,
 	              std::optional<unsigned> max_count,
 	              OnIter&& on_iter) {
+		// the history is walked through the report graph, only the reports
+		// to be printed are loaded
+		std::vector<git::oid> ids{};
 		auto id = range.to;
 		while (!id.is_zero() && id != range.from &&
 		       (!max_count || *max_count)) {
 			if (max_count) --*max_count;
 
-			auto facade = placeholder::object_facade::present_oid(id, repo);
-			if (!facade) break;
+			ids.push_back(id);
+			auto parent = repo.parent_report(id);
+			id = parent ? *parent : git::oid{};
+		}
 
+		for (auto const& report_id : ids) {
+			auto facade =
+			    placeholder::object_facade::present_oid(report_id, repo);
+			if (!facade) break;
 			on_iter(facade.get());
-			auto parent = facade->parent_id();
-			id = parent ? *parent : git::oid{};
 		}
 	}
 
@@ -4,6 +4,8 @@
 #include <gtest/gtest.h>
 #include <cov/app/report.hh>
 #include <cov/git2/global.hh>
+#include <cov/hash/md5.hh>
+#include <cov/hash/sha1.hh>
 #include <json/json.hpp>
 #include "setup.hh"
 
@@ -428,6 +430,51 @@ namespace cov::app::testing {
 	                                        {18, just_right()},
 	                                    }}}},
 	    },
+	    {
+	        .text =
+	            R"({"files": [
+	{"line_coverage": {"2": 5}, "extra": [1, {"a": null}, true],
+	 "digest": "md5:value", "name": "dir\/A \u00e9"}
+], "version": 1.5, "git": {"head": "hash", "branch": "main"}})"sv,
+	        .expected = {.git = {.branch = "main", .head = "hash"},
+	                     .files = {{.name = "dir/A \xC3\xA9",
+	                                .algorithm = app::report::digest::md5,
+	                                .digest = "value",
+	                                .line_coverage = {{1, 5}}}}},
+	    },
+	    {
+	        .text =
+	            R"({"git": {"branch": "main", "head": "hash"}, "files": [
+	{"name": "A", "digest": "md5:value",
+	 "line_coverage": {"7": 1, "2": 0, "7": 3, "4": 2}}
+]})"sv,
+	        .expected = {.git = {.branch = "main", .head = "hash"},
+	                     .files = {{.name = "A",
+	                                .algorithm = app::report::digest::md5,
+	                                .digest = "value",
+	                                .line_coverage = {{1, 0},
+	                                                  {3, 2},
+	                                                  {6, 3}}}}},
+	    },
+	    {
+	        .text =
+	            R"({"git": {"branch": "main", "head": "hash"}, "files": [
+	{"name": "A", "digest": "md5:value", "line_coverage": {"3": 1},
+	 "branches": {"3": [[1, 0], [0, -2]], "5": []}}
+]})"sv,
+	        .expected = {.git = {.branch = "main", .head = "hash"},
+	                     .files = {{.name = "A",
+	                                .algorithm = app::report::digest::md5,
+	                                .digest = "value",
+	                                .line_coverage = {{2, 1}},
+	                                .branch_coverage = {{2,
+	                                                     {
+	                                                         {.taken = 1,
+	                                                          .not_taken = 0},
+	                                                         {.taken = 0,
+	                                                          .not_taken = 0},
+	                                                     }}}}}},
+	    },
 	};
 
 	INSTANTIATE_TEST_SUITE_P(good, report, ::testing::ValuesIn(good));
@@ -448,6 +495,9 @@ namespace cov::app::testing {
 	         R"({"git": {"branch": "main", "head": "hash"}, "files": {}})"sv,
 	     .succeeds = false,
 	     .standard_error = "cov report: /files: undefined\n"sv},
+	    {.text = R"({"files": [{"name": "A"}]})"sv,
+	     .succeeds = false,
+	     .standard_error = "cov report: /git: undefined\n"sv},
 	    {.text = R"({"git": {"head": "hash"}, "files": []})"sv,
 	     .succeeds = false,
 	     .standard_error = "cov report: /git/branch: undefined\n"sv},
@@ -584,10 +634,132 @@ namespace cov::app::testing {
 	         "cov report: /files[0]/functions[0]/name (A): undefined\n"
 	         "cov report: /files[0]/functions[0]/count (A): undefined\n"
 	         "cov report: /files[0]/functions[0]/start_line (A): undefined\n"sv},
+	    {.text = R"({
+"git": {"branch": "main", "head": "hash"},
+"files": [
+	{
+		"name": "A",
+		"digest": "md5:value",
+		"line_coverage": {},
+		"branches": {
+			"15": [[1, 0], [1]]
+		}
+	}
+]})"sv,
+	     .succeeds = false,
+	     .standard_error = "cov report: /file[0]/branches[A]: 15\n"sv},
 	};
 
 	INSTANTIATE_TEST_SUITE_P(bad, report, ::testing::ValuesIn(bad));
 
+	TEST(report, read_from_text) {
+		static constexpr auto text = R"({"git": {"branch": "main", "head": "hash"}, "files": [
+	{"name": "A", "digest": "md5:value", "line_coverage": {"1": 1}},
+	{"name": "B", "digest": "sha1:value", "line_coverage": {}}
+]})"sv;
+
+		app::report::git_info git{};
+		std::vector<std::string> names{};
+		auto const result = app::report::report_info::read_from_text(
+		    text, git, [&](app::report::file_info&& file) {
+			    names.push_back(std::move(file.name));
+		    });
+		ASSERT_TRUE(result);
+		ASSERT_EQ("main"sv, git.branch);
+		ASSERT_EQ("hash"sv, git.head);
+		ASSERT_EQ((std::vector<std::string>{"A"s, "B"s}), names);
+	}
+
+	namespace {
+		app::report::report_info binary_report() {
+			using app::report::digest;
+			return {
+			    .git = {.branch = "main", .head = "hash"},
+			    .files =
+			        {
+			            {.name = "A",
+			             .algorithm = digest::md5,
+			             .digest = "value",
+			             .line_coverage = {{0, 1}, {15, 156}, {16, 0}},
+			             .function_coverage = {{.name = "_Z1fv",
+			                                    .demangled_name = "f()",
+			                                    .count = 3,
+			                                    .start = {14, 1},
+			                                    .end = {17, 2}}},
+			             .branch_coverage = {{15, {{1, 0}, {0, 2}}},
+			                                 {16, {{0, 0}}}}},
+			            {.name = "B",
+			             .algorithm = digest::sha1,
+			             .digest = "value",
+			             .line_coverage = {}},
+			        },
+			};
+		}
+	}  // namespace
+
+	TEST(report, binary_roundtrip) {
+		auto const expected = binary_report();
+		auto const data = expected.to_binary();
+		ASSERT_TRUE(app::report::report_info::is_binary(data));
+		ASSERT_FALSE(app::report::report_info::is_binary(json_text()));
+
+		app::report::report_info actual{};
+		ASSERT_TRUE(actual.load(data));
+		ASSERT_EQ(expected, actual);
+	}
+
+	TEST(report, binary_v1_0) {
+		// 14-uint header, 7-uint file entries and no branches
+		static constexpr uint32_t header[] = {
+		    0x0001'0000,  // 1.0
+		    14, 5,        // strings
+		    0,  5,        // branch, head
+		    19, 7,  1,    // files
+		    26, 7,  0,    // functions
+		    26, 2,        // lines
+		};
+		static constexpr uint32_t entries[] = {
+		    10, 1, 12, 0, 1, 0, 0,  // "A", md5, "value", one line
+		    1,  5,                  // line 1, 5 hits
+		};
+		auto const put = [](std::string& out, uint32_t value) {
+			for (size_t byte = 0; byte < 4; ++byte)
+				out.push_back(static_cast<char>((value >> (byte * 8)) & 0xFF));
+		};
+
+		std::string data{"rpin"sv};
+		for (auto value : header)
+			put(data, value);
+		data.append("main\0hash\0A\0value\0\0\0"sv);
+		for (auto value : entries)
+			put(data, value);
+
+		app::report::report_info const expected{
+		    .git = {.branch = "main", .head = "hash"},
+		    .files = {{.name = "A",
+		               .algorithm = app::report::digest::md5,
+		               .digest = "value",
+		               .line_coverage = {{0, 5}}}},
+		};
+
+		app::report::report_info actual{};
+		ASSERT_TRUE(actual.load(data));
+		ASSERT_EQ(expected, actual);
+	}
+
+	TEST(report, binary_truncated) {
+		auto data = binary_report().to_binary();
+		data.resize(data.size() - 4);
+
+		app::report::report_info actual{};
+		::testing::internal::CaptureStderr();
+		auto const result = actual.load(data);
+		auto const error = ::testing::internal::GetCapturedStderr();
+		ASSERT_FALSE(result);
+		ASSERT_EQ(app::report::report_info{}, actual);
+		ASSERT_EQ("cov report: not a binary report\n"sv, error);
+	}
+
 	static verify_test const files[] = {
 #include "verify-test.inc"
 	};
@@ -624,4 +796,126 @@ namespace cov::app::testing {
 	INSTANTIATE_TEST_SUITE_P(not_hex,
 	                         report_verify,
 	                         ::testing::ValuesIn(not_hex));
+
+	struct digest_test {
+		std::string_view title;
+		std::string text;
+
+		friend std::ostream& operator<<(std::ostream& out,
+		                                digest_test const& test) {
+			return out << test.title;
+		}
+	};
+
+	class report_digest : public ::testing::TestWithParam<digest_test> {
+	protected:
+		// the conversions, as they were applied before both were
+		// computed in one pass
+		static std::string lf_to_crlf(std::string_view chars) {
+			std::string result{};
+			auto pos = chars.find('\n');
+			while (pos != std::string_view::npos) {
+				if (!pos || chars[pos - 1] != '\r') {
+					result.append(chars.substr(0, pos));
+					result.append("\r\n"sv);
+					chars = chars.substr(pos + 1);
+					pos = chars.find('\n');
+					continue;
+				}
+				pos = chars.find('\n', pos + 1);
+			}
+			result.append(chars);
+			return result;
+		}
+
+		static std::string crlf_to_lf(std::string_view chars) {
+			std::string result{};
+			auto pos = chars.find("\r\n"sv);
+			while (pos != std::string_view::npos) {
+				result.append(chars.substr(0, pos));
+				result.push_back('\n');
+				chars = chars.substr(pos + 2);
+				pos = chars.find("\r\n"sv);
+			}
+			result.append(chars);
+			return result;
+		}
+
+		template <typename Digest>
+		static std::string hex_of(std::string_view text) {
+			return Digest::once(git::bytes{text}).str();
+		}
+
+		template <typename Digest>
+		static app::report::matching reference(std::string_view hash,
+		                                        std::string_view text) {
+			using app::report::matching;
+			if (hex_of<Digest>(text) == hash) return matching::exactly;
+			if (hex_of<Digest>(lf_to_crlf(text)) == hash ||
+			    hex_of<Digest>(crlf_to_lf(text)) == hash)
+				return matching::with_different_newlines;
+			return matching::none;
+		}
+
+		template <typename Digest>
+		void check(app::report::digest algorithm) {
+			auto const& text = GetParam().text;
+			std::string const candidates[] = {
+			    text,
+			    lf_to_crlf(text),
+			    crlf_to_lf(text),
+			    text + "\n"s,
+			};
+			for (auto const& candidate : candidates) {
+				auto const hash = hex_of<Digest>(candidate);
+				EXPECT_EQ(reference<Digest>(hash, text),
+				          app::report::match(algorithm, hash,
+				                             git::bytes{std::string_view{text}}))
+				    << "Hash: " << hash;
+			}
+		}
+	};
+
+	TEST_P(report_digest, md5) {
+		check<hash::md5>(app::report::digest::md5);
+	}
+
+	TEST_P(report_digest, sha1) {
+		check<hash::sha1>(app::report::digest::sha1);
+	}
+
+	static std::string repeat(std::string_view line, size_t count) {
+		std::string result{};
+		result.reserve(line.size() * count);
+		for (size_t index = 0; index < count; ++index)
+			result.append(line);
+		return result;
+	}
+
+	static digest_test const digests[] = {
+	    {"empty"sv, ""s},
+	    {"LF only"sv, "line 1\nline 2\n\nline 4\n"s},
+	    {"CRLF only"sv, "line 1\r\nline 2\r\n\r\nline 4\r\n"s},
+	    {"mixed"sv, "line 1\r\nline 2\nline 3\r\n\nline 5\n"s},
+	    {"LF, no last newline"sv, "line 1\nline 2"s},
+	    {"CRLF, no last newline"sv, "line 1\r\nline 2"s},
+	    {"no newlines"sv, "line 1"s},
+	    {"lone CR"sv, "\r"s},
+	    {"lone CR inside"sv, "line\r1\nline 2\r"s},
+	    {"CR before CRLF"sv, "\r\r\nline\r\r\n"s},
+	    {"starts with LF"sv, "\nline 2\r\n"s},
+	    {"starts with CRLF"sv, "\r\nline 2\r\n"s},
+	    {"long runs"sv, repeat("x"sv, 20000) + "\n"s + repeat("y"sv, 9000) +
+	                        "\r\n"s + repeat("z"sv, 8191) + "\n"s},
+	    {"many LF lines"sv, repeat("ab\n"sv, 5000)},
+	    {"many CRLF lines"sv, repeat("ab\r\n"sv, 5000)},
+	    {"many mixed lines"sv, repeat("ab\r\ncd\n\n"sv, 3000)},
+	    {"mixed, long lines"sv,
+	     repeat(repeat("x"sv, 100) + "\r\n"s + repeat("y"sv, 37) + "\n"s,
+	            500)},
+	};
+
+	INSTANTIATE_TEST_SUITE_P(newlines,
+	                         report_digest,
+	                         ::testing::ValuesIn(digests));
 }  // namespace cov::app::testing
@@ -0,0 +1,232 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <gtest/gtest.h>
+#include <cov/app/report.hh>
+#include <cov/hash/sha1.hh>
+#include <cov/io/file.hh>
+#include <cov/zstream.hh>
+#include "setup.hh"
+
+namespace cov::app::testing {
+	using namespace ::std::literals;
+	using app::report::digest;
+	using app::report::file_info;
+	using app::report::report_info;
+
+	namespace {
+		constexpr auto lib_hh = "inline int lib() { return 1; }\n"sv;
+		constexpr auto a_cc = "int a() { return lib(); }\n"sv;
+		constexpr auto b_cc = "int b() { return lib(); }\n"sv;
+
+		constexpr auto a_json = R"x({
+  "format_version": "1",
+  "current_working_directory": "$WORK/build",
+  "data_file": "a.gcda",
+  "files": [
+    {"file": "../src/a.cc",
+     "functions": [{"blocks": 2, "end_column": 1, "start_line": 1,
+                    "name": "_Z1av", "blocks_executed": 2,
+                    "execution_count": 3, "demangled_name": "a()",
+                    "start_column": 5, "end_line": 1}],
+     "lines": [{"line_number": 1, "function_name": "_Z1av", "count": 3,
+                "unexecuted_block": false, "branches": []}]},
+    {"file": "../src/lib.hh",
+     "functions": [{"blocks": 2, "end_column": 1, "start_line": 1,
+                    "name": "_Z3libv", "blocks_executed": 2,
+                    "execution_count": 3, "demangled_name": "lib()",
+                    "start_column": 12, "end_line": 1}],
+     "lines": [{"line_number": 1, "count": 3, "branches": []}]},
+    {"file": "/usr/include/c++/13/vector",
+     "functions": [],
+     "lines": [{"line_number": 10, "count": 1, "branches": []}]}
+  ]
+})x"sv;
+
+		// no working directory before the files, different TU for the
+		// header, names relative to the work dir
+		constexpr auto b_json = R"x({
+  "format_version": "1",
+  "files": [
+    {"file": "src/lib.hh",
+     "functions": [{"start_line": 1, "end_line": 1, "name": "_Z3libv",
+                    "execution_count": 4, "demangled_name": "lib()",
+                    "start_column": 12, "end_column": 1}],
+     "lines": [{"line_number": 1, "count": 4},
+               {"line_number": 1, "count": 1}]},
+    {"file": "src/b.cc",
+     "functions": [{"start_line": 1, "end_line": 1, "name": "_Z1bv",
+                    "execution_count": 0, "demangled_name": "b()",
+                    "start_column": 5, "end_column": 1}],
+     "lines": [{"line_number": 1, "count": 0}]}
+  ],
+  "current_working_directory": "$WORK"
+})x"sv;
+
+		std::string expand(std::string_view text,
+		                   std::filesystem::path const& work) {
+			static constexpr auto var = "$WORK"sv;
+			auto const u8 = work.generic_u8string();
+			std::string_view const dir{
+			    reinterpret_cast<char const*>(u8.data()), u8.size()};
+
+			std::string result{};
+			auto pos = text.find(var);
+			while (pos != std::string_view::npos) {
+				result.append(text.substr(0, pos));
+				result.append(dir);
+				text = text.substr(pos + var.size());
+				pos = text.find(var);
+			}
+			result.append(text);
+			return result;
+		}
+
+		void write(std::filesystem::path const& path, std::string_view text) {
+			std::filesystem::create_directories(path.parent_path());
+			auto file = io::fopen(path, "wb");
+			ASSERT_TRUE(file);
+			file.store(text.data(), text.size());
+		}
+
+		void write_gz(std::filesystem::path const& path,
+		              std::string_view text) {
+			buffer_zstream z{zstream::deflate, zstream::gzip};
+			z.append({reinterpret_cast<std::byte const*>(text.data()),
+			          text.size()});
+			auto const block = z.close();
+			write(path, {reinterpret_cast<char const*>(block.data.data()),
+			             block.data.size()});
+		}
+
+		std::string sha1(std::string_view text) {
+			return hash::sha1::once(
+			           {reinterpret_cast<std::byte const*>(text.data()),
+			            text.size()})
+			    .str();
+		}
+
+		std::filesystem::path prepare(std::string_view dirname) {
+			auto const work = setup::test_dir() / dirname;
+			std::error_code ec{};
+			std::filesystem::remove_all(work, ec);
+			write(work / "src/lib.hh"sv, lib_hh);
+			write(work / "src/a.cc"sv, a_cc);
+			write(work / "src/b.cc"sv, b_cc);
+			return work;
+		}
+	}  // namespace
+
+	TEST(report_gcov, merges_translation_units) {
+		auto const work = prepare("gcov_merge"sv);
+		write_gz(work / "build/a.gcov.json.gz"sv, expand(a_json, work));
+		write_gz(work / "build/sub/b.gcov.json.gz"sv, expand(b_json, work));
+		// not a name gcov would use, so it is not picked up
+		write(work / "build/c.json"sv, "not JSON"sv);
+
+		for (unsigned jobs : {1u, 2u}) {
+			report_info actual{};
+			::testing::internal::CaptureStderr();
+			auto const result =
+			    actual.load_from_gcov(work / "build"sv, work, jobs);
+			auto const error = ::testing::internal::GetCapturedStderr();
+			ASSERT_TRUE(result) << "jobs: " << jobs;
+			ASSERT_EQ(""sv, error) << "jobs: " << jobs;
+
+			std::vector<file_info> const expected{
+			    {
+			        .name = "src/a.cc"s,
+			        .algorithm = digest::sha1,
+			        .digest = sha1(a_cc),
+			        .line_coverage = {{0, 3}},
+			        .function_coverage = {{.name = "_Z1av"s,
+			                               .demangled_name = "a()"s,
+			                               .count = 3,
+			                               .start = {0, 5},
+			                               .end = {0, 1}}},
+			    },
+			    {
+			        .name = "src/b.cc"s,
+			        .algorithm = digest::sha1,
+			        .digest = sha1(b_cc),
+			        .line_coverage = {{0, 0}},
+			        .function_coverage = {{.name = "_Z1bv"s,
+			                               .demangled_name = "b()"s,
+			                               .count = 0,
+			                               .start = {0, 5},
+			                               .end = {0, 1}}},
+			    },
+			    {
+			        .name = "src/lib.hh"s,
+			        .algorithm = digest::sha1,
+			        .digest = sha1(lib_hh),
+			        .line_coverage = {{0, 8}},
+			        .function_coverage = {{.name = "_Z3libv"s,
+			                               .demangled_name = "lib()"s,
+			                               .count = 7,
+			                               .start = {0, 12},
+			                               .end = {0, 1}}},
+			    },
+			};
+			ASSERT_EQ(expected, actual.files) << "jobs: " << jobs;
+		}
+	}
+
+	TEST(report_gcov, single_plain_file) {
+		auto const work = prepare("gcov_plain"sv);
+		write(work / "a.gcov.json"sv, expand(a_json, work));
+
+		report_info actual{};
+		ASSERT_TRUE(actual.load_from_gcov(work / "a.gcov.json"sv, work, 4));
+		ASSERT_EQ(2u, actual.files.size());
+		ASSERT_EQ("src/a.cc"sv, actual.files[0].name);
+		ASSERT_EQ("src/lib.hh"sv, actual.files[1].name);
+		ASSERT_EQ((std::vector<std::pair<unsigned, unsigned>>{{0, 3}}),
+		          actual.files[1].line_coverage);
+	}
+
+	TEST(report_gcov, truncated) {
+		auto const work = prepare("gcov_truncated"sv);
+		auto const path = work / "a.gcov.json.gz"sv;
+		write_gz(path, expand(a_json, work));
+		std::filesystem::resize_file(path,
+		                             std::filesystem::file_size(path) / 2);
+
+		report_info actual{};
+		::testing::internal::CaptureStderr();
+		auto const result = actual.load_from_gcov(path, work, 1);
+		auto const error = ::testing::internal::GetCapturedStderr();
+		ASSERT_FALSE(result);
+		ASSERT_TRUE(actual.files.empty());
+		ASSERT_NE(std::string::npos, error.find("not a gcov JSON file"sv))
+		    << error;
+	}
+
+	TEST(report_gcov, missing_source) {
+		auto const work = prepare("gcov_missing"sv);
+		write(work / "a.gcov.json"sv, expand(a_json, work));
+		std::filesystem::remove(work / "src/a.cc"sv);
+
+		report_info actual{};
+		::testing::internal::CaptureStderr();
+		auto const result =
+		    actual.load_from_gcov(work / "a.gcov.json"sv, work, 1);
+		auto const error = ::testing::internal::GetCapturedStderr();
+		ASSERT_TRUE(result);
+		ASSERT_EQ(1u, actual.files.size());
+		ASSERT_EQ("src/lib.hh"sv, actual.files[0].name);
+		ASSERT_EQ("cov report: src/a.cc: cannot read the source\n"sv, error);
+	}
+
+	TEST(report_gcov, empty_directory) {
+		auto const work = prepare("gcov_empty"sv);
+
+		report_info actual{};
+		::testing::internal::CaptureStderr();
+		auto const result = actual.load_from_gcov(work / "src"sv, work, 1);
+		auto const error = ::testing::internal::GetCapturedStderr();
+		ASSERT_FALSE(result);
+		ASSERT_NE(std::string::npos, error.find("no gcov JSON files"sv))
+		    << error;
+	}
+}  // namespace cov::app::testing
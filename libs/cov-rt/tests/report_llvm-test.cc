@@ -0,0 +1,229 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <gtest/gtest.h>
+#include <cov/app/report.hh>
+#include <cov/hash/sha1.hh>
+#include <cov/io/file.hh>
+#include "setup.hh"
+
+namespace cov::app::testing {
+	using namespace ::std::literals;
+	using app::report::digest;
+	using app::report::file_info;
+	using app::report::report_info;
+
+	namespace {
+		constexpr auto a_cc =
+		    "int a(int x) {\n"
+		    "  if (x)\n"
+		    "    return 1;\n"
+		    "  return 0;\n"
+		    "}\n"sv;
+		constexpr auto b_cc =
+		    "#if 0\n"
+		    "static int b() {\n"
+		    "}\n"sv;
+
+		// keys are sorted, the same way llvm-cov writes them
+		constexpr auto export_json = R"x({
+  "data": [
+    {
+      "files": [
+        {
+          "branches": [[2, 7, 2, 8, 1, 2, 0, 0, 4]],
+          "expansions": [],
+          "filename": "$WORK/src/a.cc",
+          "segments": [
+            [1, 14, 3, true, true, false],
+            [3, 5, 1, true, true, false],
+            [3, 13, 2, true, false, true],
+            [4, 3, 2, true, true, false],
+            [5, 2, 0, false, false, false]
+          ],
+          "summary": {"lines": {"count": 5, "covered": 5}}
+        },
+        {
+          "filename": "$WORK/src/b.cc",
+          "segments": [
+            [1, 1, 0, false, true, false],
+            [2, 1, 5, true, true, false],
+            [3, 1, 0, false, false, false]
+          ]
+        },
+        {
+          "filename": "/usr/include/outside.h",
+          "segments": [[1, 1, 7, true, true, false]]
+        }
+      ],
+      "functions": [
+        {
+          "branches": [],
+          "count": 3,
+          "filenames": ["$WORK/src/a.cc"],
+          "name": "_Z1ai",
+          "regions": [
+            [1, 14, 5, 2, 3, 0, 0, 0],
+            [3, 5, 3, 13, 1, 0, 0, 0]
+          ]
+        },
+        {
+          "count": 5,
+          "filenames": ["$WORK/src/b.cc"],
+          "name": "$WORK/src/b.cc:_ZL1bv",
+          "regions": [
+            [1, 1, 1, 6, 0, 0, 0, 2],
+            [2, 16, 3, 2, 5, 0, 0, 0]
+          ]
+        },
+        {
+          "count": 7,
+          "filenames": ["/usr/include/outside.h"],
+          "name": "_Z7outsidev",
+          "regions": [[1, 1, 1, 9, 7, 0, 0, 0]]
+        }
+      ],
+      "totals": {}
+    },
+    {
+      "files": [
+        {
+          "filename": "src/a.cc",
+          "segments": [
+            [1, 14, 1, true, true, false],
+            [5, 2, 0, false, false, false]
+          ]
+        }
+      ],
+      "functions": [
+        {
+          "count": 1,
+          "filenames": ["src/a.cc"],
+          "name": "_Z1ai",
+          "regions": [[1, 14, 5, 2, 1, 0, 0, 0]]
+        }
+      ]
+    }
+  ],
+  "type": "llvm.coverage.json.export",
+  "version": "2.0.1"
+})x"sv;
+
+		std::string expand(std::string_view text,
+		                   std::filesystem::path const& work) {
+			static constexpr auto var = "$WORK"sv;
+			auto const u8 = work.generic_u8string();
+			std::string_view const dir{
+			    reinterpret_cast<char const*>(u8.data()), u8.size()};
+
+			std::string result{};
+			auto pos = text.find(var);
+			while (pos != std::string_view::npos) {
+				result.append(text.substr(0, pos));
+				result.append(dir);
+				text = text.substr(pos + var.size());
+				pos = text.find(var);
+			}
+			result.append(text);
+			return result;
+		}
+
+		void write(std::filesystem::path const& path, std::string_view text) {
+			std::filesystem::create_directories(path.parent_path());
+			auto file = io::fopen(path, "wb");
+			ASSERT_TRUE(file);
+			file.store(text.data(), text.size());
+		}
+
+		std::string sha1(std::string_view text) {
+			return hash::sha1::once(
+			           {reinterpret_cast<std::byte const*>(text.data()),
+			            text.size()})
+			    .str();
+		}
+
+		std::filesystem::path prepare(std::string_view dirname) {
+			auto const work = setup::test_dir() / dirname;
+			std::error_code ec{};
+			std::filesystem::remove_all(work, ec);
+			write(work / "src/a.cc"sv, a_cc);
+			write(work / "src/b.cc"sv, b_cc);
+			return work;
+		}
+
+		bool load(report_info& report,
+		          std::filesystem::path const& work,
+		          std::string_view text,
+		          std::string& error) {
+			auto const path = work / "build/coverage.json"sv;
+			write(path, text);
+			::testing::internal::CaptureStderr();
+			auto const result = report.load_from_llvm_cov(path, work, 2);
+			error = ::testing::internal::GetCapturedStderr();
+			return result;
+		}
+	}  // namespace
+
+	TEST(report_llvm, segments_and_functions) {
+		auto const work = prepare("llvm_export"sv);
+
+		report_info actual{};
+		std::string error{};
+		ASSERT_TRUE(load(actual, work, expand(export_json, work), error));
+		ASSERT_EQ(""sv, error);
+
+		std::vector<file_info> const expected{
+		    {
+		        .name = "src/a.cc"s,
+		        .algorithm = digest::sha1,
+		        .digest = sha1(a_cc),
+		        // both exports summed; line 3 keeps the count of the body,
+		        // since it is higher than the count of the `if`
+		        .line_coverage = {{0, 4}, {1, 4}, {2, 4}, {3, 3}, {4, 3}},
+		        .function_coverage = {{.name = "_Z1ai"s,
+		                               .count = 4,
+		                               .start = {0, 14},
+		                               .end = {4, 2}}},
+		        .branch_coverage = {{1, {{.taken = 1, .not_taken = 2}}}},
+		    },
+		    {
+		        .name = "src/b.cc"s,
+		        .algorithm = digest::sha1,
+		        .digest = sha1(b_cc),
+		        // first line is skipped by the preprocessor
+		        .line_coverage = {{1, 5}, {2, 5}},
+		        .function_coverage = {{.name = "_ZL1bv"s,
+		                               .count = 5,
+		                               .start = {1, 16},
+		                               .end = {2, 2}}},
+		    },
+		};
+		ASSERT_EQ(expected, actual.files);
+	}
+
+	TEST(report_llvm, not_an_export) {
+		auto const work = prepare("llvm_other"sv);
+
+		report_info actual{};
+		std::string error{};
+		ASSERT_FALSE(load(actual, work,
+		                  R"({"data": [], "type": "llvm.something.else"})"sv,
+		                  error));
+		ASSERT_TRUE(actual.files.empty());
+		ASSERT_NE(std::string::npos, error.find("not an llvm-cov export"sv))
+		    << error;
+	}
+
+	TEST(report_llvm, truncated) {
+		auto const work = prepare("llvm_truncated"sv);
+		auto const text = expand(export_json, work);
+
+		report_info actual{};
+		std::string error{};
+		ASSERT_FALSE(
+		    load(actual, work, std::string_view{text}.substr(0, 400), error));
+		ASSERT_TRUE(actual.files.empty());
+		ASSERT_NE(std::string::npos, error.find("not an llvm-cov export"sv))
+		    << error;
+	}
+}  // namespace cov::app::testing
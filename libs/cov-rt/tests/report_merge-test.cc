@@ -0,0 +1,131 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <gtest/gtest.h>
+#include <cov/app/report.hh>
+
+namespace cov::app::testing {
+	using namespace ::std::literals;
+	using app::report::digest;
+	using app::report::report_info;
+
+	namespace {
+		report_info linux_report() {
+			return {
+			    .git = {.branch = "main"s, .head = "1234567890abcdef"s},
+			    .files =
+			        {
+			            {
+			                .name = "src/a.cc"s,
+			                .algorithm = digest::md5,
+			                .digest = "aaaa"s,
+			                .line_coverage = {{0, 1}, {1, 0}, {4, 2}},
+			                .function_coverage = {{.name = "_Z1av"s,
+			                                       .demangled_name = "a()"s,
+			                                       .count = 1,
+			                                       .start = {0, 5},
+			                                       .end = {4, 1}}},
+			                .branch_coverage = {{1, {{1, 0}}}},
+			            },
+			            {
+			                .name = "src/linux.cc"s,
+			                .algorithm = digest::md5,
+			                .digest = "cccc"s,
+			                .line_coverage = {{2, 3}},
+			            },
+			        },
+			};
+		}
+
+		report_info windows_report() {
+			return {
+			    .git = {.branch = "feature"s, .head = "1234567890abcdef"s},
+			    .files =
+			        {
+			            {
+			                .name = "src/a.cc"s,
+			                .algorithm = digest::sha1,
+			                .digest = "bbbb"s,
+			                .line_coverage = {{1, 4}, {3, 0}, {4, 0xFFFF'FFFF}},
+			                .function_coverage =
+			                    {
+			                        {.name = "_Z1av"s,
+			                         .demangled_name = "a()"s,
+			                         .count = 2,
+			                         .start = {0, 5},
+			                         .end = {4, 1}},
+			                        {.name = "_Z1bv"s,
+			                         .demangled_name = "b()"s,
+			                         .count = 0,
+			                         .start = {3, 5},
+			                         .end = {3, 9}},
+			                    },
+			                .branch_coverage = {{1, {{0, 2}, {3, 0}}},
+			                                    {3, {{0, 0}}}},
+			            },
+			            {
+			                .name = "src/b.cc"s,
+			                .algorithm = digest::sha1,
+			                .digest = "dddd"s,
+			                .line_coverage = {{0, 0}},
+			            },
+			        },
+			};
+		}
+	}  // namespace
+
+	TEST(report_merge, sums_files_by_name) {
+		auto const on_linux = linux_report();
+		auto const on_windows = windows_report();
+		report_info const* reports[] = {&on_linux, &on_windows};
+
+		report_info const expected{
+		    .git = on_linux.git,
+		    .files =
+		        {
+		            {
+		                .name = "src/a.cc"s,
+		                .algorithm = digest::md5,
+		                .digest = "aaaa"s,
+		                // the last line is clamped, not wrapped around
+		                .line_coverage = {{0, 1},
+		                                  {1, 4},
+		                                  {3, 0},
+		                                  {4, 0xFFFF'FFFF}},
+		                .function_coverage =
+		                    {
+		                        {.name = "_Z1av"s,
+		                         .demangled_name = "a()"s,
+		                         .count = 3,
+		                         .start = {0, 5},
+		                         .end = {4, 1}},
+		                        {.name = "_Z1bv"s,
+		                         .demangled_name = "b()"s,
+		                         .count = 0,
+		                         .start = {3, 5},
+		                         .end = {3, 9}},
+		                    },
+		                .branch_coverage = {{1, {{1, 2}, {3, 0}}},
+		                                    {3, {{0, 0}}}},
+		            },
+		            on_windows.files[1],
+		            on_linux.files[1],
+		        },
+		};
+
+		for (unsigned jobs : {1u, 3u}) {
+			auto const actual = report_info::merge(reports, jobs);
+			ASSERT_EQ(expected, actual) << "jobs: " << jobs;
+		}
+	}
+
+	TEST(report_merge, single_report) {
+		auto const on_linux = linux_report();
+		report_info const* reports[] = {&on_linux};
+		ASSERT_EQ(on_linux, report_info::merge(reports, 2));
+	}
+
+	TEST(report_merge, no_reports) {
+		ASSERT_EQ(report_info{}, report_info::merge({}, 2));
+	}
+}  // namespace cov::app::testing
@@ -86,5 +86,8 @@ namespace hl {
 		virtual void on_line(std::size_t start,
 		                     std::size_t length,
 		                     const tokens& highlights) = 0;
+		// called before on_line, if no token from the lines above reaches
+		// this line; the tokenizer could have started from here instead
+		virtual void on_checkpoint(std::size_t start);
 	};
 }  // namespace hl
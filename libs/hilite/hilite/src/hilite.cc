@@ -56,15 +56,33 @@ namespace hl {
 
 			return out;
 		}
+
+		// a line is a checkpoint, if all the tokens started above it end
+		// before the newline separating it from the line above
+		std::vector<bool> find_checkpoints(endlines const& lines,
+		                                   tokens const& toks) {
+			std::vector<bool> result(lines.size());
+			auto it = toks.begin();
+			size_t furthest{};
+			for (size_t index = 0; index < lines.size(); ++index) {
+				auto const newline = lines[index].offset - lines[index].size;
+				for (; it != toks.end() && it->start < newline; ++it)
+					furthest = std::max(furthest, it->stop);
+				result[index] = furthest <= newline;
+			}
+			return result;
+		}
 	}  // namespace
 
 	callback::~callback() = default;
 	callback::callback() = default;
+	void callback::on_checkpoint(std::size_t) {}
 
 	void grammar_result::produce_lines(callback& cb, size_t contents_length) {
 		sort_uniq(endlines_);
 		sort_uniq(tokens_);
 
+		auto const checkpoints = find_checkpoints(endlines_, tokens_);
 		auto broken = break_lines(std::begin(endlines_), std::end(endlines_),
 		                          std::begin(tokens_), std::end(tokens_));
 		std::stable_sort(std::begin(broken), std::end(broken));
@@ -84,8 +102,10 @@ namespace hl {
 
 		auto it = std::begin(broken);
 		auto const end = std::end(broken);
+		auto checkpoint = checkpoints.begin();
 		for (auto const& endline : endlines_) {
 			auto const eol = endline.offset + endline.size;
+			if (*checkpoint++) cb.on_checkpoint(endline.offset);
 
 			auto saved_pos = it;
 			size_t token_count = 0;
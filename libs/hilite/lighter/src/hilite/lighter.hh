@@ -6,6 +6,8 @@
 #include <algorithm>
 #include <cstdint>
 #include <map>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -13,6 +15,10 @@
 #include <vector>
 
 namespace lighter {
+	// changes, whenever the same text could be highlighted differently, so
+	// highlights stored by older versions are known to be stale
+	inline constexpr std::uint32_t version = 1;
+
 	struct text_span {
 		std::size_t begin;
 		std::size_t end;
@@ -101,6 +107,30 @@ namespace lighter {
 		items.erase(it, items.end());
 	}
 
+	// Lines, at which the tokenizer can start over without changing the
+	// highlights of the lines below; only one line in `stride` is kept.
+	struct checkpoints {
+		static constexpr unsigned stride = 32;
+
+		struct entry {
+			unsigned line;
+			std::size_t offset;
+			bool operator==(entry const&) const noexcept = default;
+		};
+
+		std::vector<entry> entries;
+		bool operator==(checkpoints const&) const noexcept = default;
+
+		std::vector<std::byte> serialize() const;
+		// nullopt, if the data is damaged, or the entries would reach past
+		// the end of the contents they were taken from
+		static std::optional<checkpoints> deserialize(
+		    std::span<std::byte const> data,
+		    std::size_t contents_length);
+	};
+
+	using line_ranges = std::span<std::pair<unsigned, unsigned> const>;
+
 	struct highlights {
 		struct line {
 			std::size_t start;
@@ -114,5 +144,23 @@ namespace lighter {
 
 		static highlights from(std::string_view contents,
 		                       std::string_view as_filename);
+		// Only lines inside the sorted, inclusive `ranges` are highlighted,
+		// all other lines are plain text. An empty `table` is filled with
+		// a full pass over the `contents`, a filled one lets the tokenizer
+		// skip to the lines around the ranges.
+		static highlights from(std::string_view contents,
+		                       std::string_view as_filename,
+		                       line_ranges ranges,
+		                       checkpoints& table);
+
+		std::vector<std::byte> serialize() const;
+		// nullopt, if the data is damaged, or the lines would reach past
+		// the end of the contents they are supposed to highlight
+		static std::optional<highlights> deserialize(
+		    std::span<std::byte const> data,
+		    std::size_t contents_length);
 	};
+
+	// name of the tokenizer picked for the file name, "none" for plain text
+	std::string_view syntax_of(std::string_view as_filename);
 }  // namespace lighter
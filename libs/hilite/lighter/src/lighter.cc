@@ -7,6 +7,7 @@
 #include <cell/tokens.hh>
 #include <hilite/hilite.hh>
 #include <hilite/none.hh>
+#include <optional>
 #include <stack>
 #include <unordered_set>
 
@@ -28,6 +29,8 @@
 #endif
 
 namespace lighter {
+	using namespace std::literals;
+
 	namespace {
 #define LIST_TOKENS(x) hl::x,
 		constexpr auto max_token_kind = std::max({HILITE_TOKENS(LIST_TOKENS)});
@@ -35,6 +38,7 @@ namespace lighter {
 		struct hl_iface {
 			void (*tokenize)(std::string_view const&, hl::callback&);
 			std::string_view (*to_string)(unsigned) noexcept;
+			std::string_view name;
 		};
 
 		struct key_t {
@@ -58,12 +62,14 @@ namespace lighter {
 		// GCOV_EXCL_STOP
 
 #ifdef HAS_CXX
-		constexpr hl_iface cxx{hl::cxx::tokenize, hl::cxx::token_to_string};
+		constexpr hl_iface cxx{hl::cxx::tokenize, hl::cxx::token_to_string,
+		                       "cxx"sv};
 #endif
 #ifdef HAS_PY3
-		constexpr hl_iface python{hl::py3::tokenize, hl::py3::token_to_string};
+		constexpr hl_iface python{hl::py3::tokenize, hl::py3::token_to_string,
+		                          "py3"sv};
 #endif
-		constexpr hl_iface none{hl::none::tokenize, none_to_string};
+		constexpr hl_iface none{hl::none::tokenize, none_to_string, "none"sv};
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -218,14 +224,68 @@ namespace lighter {
 			}
 		};
 
-		highlights tokenize(std::string_view contents, hl_iface const& iface) {
+		// keeps track of the ranges, as the lines come in order
+		class range_filter {
+		public:
+			explicit range_filter(line_ranges ranges) : ranges_{ranges} {}
+
+			bool contains(unsigned line) noexcept {
+				while (!ranges_.empty() && ranges_.front().second < line)
+					ranges_ = ranges_.subspan(1);
+				return !ranges_.empty() && ranges_.front().first <= line;
+			}
+
+		private:
+			line_ranges ranges_;
+		};
+
+		highlighted_line plain(std::size_t length) {
+			if (!length) return {};
+			return {text_span{.begin = 0, .end = length}};
+		}
+
+		struct tokenize_options {
+			std::optional<range_filter> filter{};
+			checkpoints* table{nullptr};
+			unsigned first_line{0};
+			std::size_t first_offset{0};
+		};
+
+		highlights tokenize(std::string_view contents,
+		                    hl_iface const& iface,
+		                    tokenize_options&& options = {}) {
 			struct callback : hl::callback {
 				highlights& result;
+				tokenize_options& options;
 				std::unordered_set<unsigned> dict{};
-				callback(highlights& result) : result{result} {}
+				bool at_checkpoint{false};
+
+				callback(highlights& result, tokenize_options& options)
+				    : result{result}, options{options} {}
+
+				void on_checkpoint(std::size_t) final { at_checkpoint = true; }
+
 				void on_line(std::size_t start,
 				             std::size_t length,
 				             hl::tokens const& tokens) final {
+					auto const line =
+					    options.first_line +
+					    static_cast<unsigned>(result.lines.size());
+					start += options.first_offset;
+					if (at_checkpoint && options.table) {
+						auto& entries = options.table->entries;
+						if (entries.empty() ||
+						    line - entries.back().line >= checkpoints::stride)
+							entries.push_back({.line = line, .offset = start});
+					}
+					at_checkpoint = false;
+
+					if (options.filter && !options.filter->contains(line)) {
+						result.lines.push_back(
+						    {.start = start, .contents = plain(length)});
+						return;
+					}
+
 					result.lines.push_back({
 					    .start = start,
 					    .contents = node::from(tokens, length).spans(),
@@ -238,7 +298,7 @@ namespace lighter {
 			};
 
 			highlights result{};
-			callback returned{result};
+			callback returned{result, options};
 			iface.tokenize(contents, returned);
 			for (auto kind : returned.dict) {
 				auto name = iface.to_string(kind);
@@ -248,10 +308,94 @@ namespace lighter {
 			}
 			return result;
 		}
+
+		// same line breaks, as the ones from cell::eol
+		std::vector<highlights::line> plain_lines(std::string_view contents) {
+			std::vector<highlights::line> result{};
+			std::size_t start = 0;
+			for (std::size_t pos = 0; pos < contents.size(); ++pos) {
+				auto const c = contents[pos];
+				if (c != '\r' && c != '\n') continue;
+				result.push_back(
+				    {.start = start, .contents = plain(pos - start)});
+				if (c == '\r' && pos + 1 < contents.size() &&
+				    contents[pos + 1] == '\n')
+					++pos;
+				start = pos + 1;
+			}
+			result.push_back({.start = start,
+			                  .contents = plain(contents.size() - start)});
+			return result;
+		}
 	}  // namespace
 
+	std::string_view syntax_of(std::string_view as_filename) {
+		return locate_lighter(as_filename).name;
+	}
+
 	highlights highlights::from(std::string_view contents,
 	                            std::string_view as_filename) {
 		return tokenize(contents, locate_lighter(as_filename));
 	}
+
+	highlights highlights::from(std::string_view contents,
+	                            std::string_view as_filename,
+	                            line_ranges ranges,
+	                            checkpoints& table) {
+		auto const& iface = locate_lighter(as_filename);
+		if (table.entries.empty()) {
+			return tokenize(contents, iface,
+			                {.filter = range_filter{ranges}, .table = &table});
+		}
+
+		highlights result{};
+		result.lines = plain_lines(contents);
+
+		auto const& entries = table.entries;
+		auto const line_after = [&](unsigned line) {
+			return std::upper_bound(
+			    entries.begin(), entries.end(), line,
+			    [](unsigned value, auto const& entry) {
+				    return value < entry.line;
+			    });
+		};
+
+		while (!ranges.empty()) {
+			auto from = line_after(ranges.front().first);
+			if (from != entries.begin()) --from;
+			auto to = line_after(ranges.front().second);
+
+			// ranges sharing the lines between two checkpoints are
+			// tokenized together
+			size_t count = 1;
+			while (count < ranges.size() &&
+			       (to == entries.end() || ranges[count].first < to->line)) {
+				to = line_after(ranges[count].second);
+				++count;
+			}
+
+			auto const stop =
+			    to == entries.end() ? contents.size() : to->offset;
+			auto const stop_line = to == entries.end()
+			                           ? result.lines.size()
+			                           : size_t{to->line};
+			auto part = tokenize(
+			    contents.substr(from->offset, stop - from->offset), iface,
+			    {
+			        .filter = range_filter{ranges.first(count)},
+			        .first_line = from->line,
+			        .first_offset = from->offset,
+			    });
+			ranges = ranges.subspan(count);
+
+			auto line = from->line;
+			for (auto& item : part.lines) {
+				if (line >= stop_line) break;
+				result.lines[line++] = std::move(item);
+			}
+			result.dict.merge(part.dict);
+		}
+
+		return result;
+	}
 }  // namespace lighter
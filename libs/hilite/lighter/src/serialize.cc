@@ -0,0 +1,239 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <hilite/lighter.hh>
+
+#include <limits>
+
+// All numbers are LEB128 varints:
+//
+//   highlights: dict-count (kind name-length name-bytes)*
+//               line-count (start-delta node-count node*)*
+//   node:       0 begin length
+//             | 1 kind node-count node*
+//   checkpoints: entry-count (line-delta offset-delta)*
+//
+// Line starts are stored as a distance from the previous line start, the
+// checkpoints as a distance from the previous checkpoint.
+
+namespace lighter {
+	namespace {
+		// the spans follow the tokens, which never nest this deep; a deeper
+		// tree only comes from damaged data
+		constexpr unsigned max_depth = 64;
+
+		class writer {
+		public:
+			std::vector<std::byte> result{};
+
+			void put(std::uint64_t value) {
+				while (value >= 0x80) {
+					result.push_back(
+					    static_cast<std::byte>((value & 0x7F) | 0x80));
+					value >>= 7;
+				}
+				result.push_back(static_cast<std::byte>(value));
+			}
+
+			void put(std::string_view text) {
+				put(text.size());
+				auto const bytes =
+				    reinterpret_cast<std::byte const*>(text.data());
+				result.insert(result.end(), bytes, bytes + text.size());
+			}
+
+			void put(highlighted_line const& items) {
+				put(items.size());
+				for (auto const& item : items) {
+					auto const text = std::get_if<text_span>(&item.base());
+					if (text) {
+						put(0u);
+						put(text->begin);
+						put(text->end - text->begin);
+						continue;
+					}
+
+					auto const& nested = std::get<span>(item.base());
+					put(1u);
+					put(nested.kind);
+					put(nested.contents);
+				}
+			}
+		};
+
+		class reader {
+		public:
+			explicit reader(std::span<std::byte const> data) : data_{data} {}
+
+			bool finished() const noexcept { return data_.empty(); }
+
+			bool get(std::uint64_t& value) {
+				value = 0;
+				for (unsigned shift = 0; !data_.empty() && shift < 64;
+				     shift += 7) {
+					auto const byte = std::to_integer<std::uint64_t>(data_[0]);
+					data_ = data_.subspan(1);
+					value |= (byte & 0x7F) << shift;
+					if (!(byte & 0x80)) return true;
+				}
+				return false;
+			}
+
+			template <typename Int>
+			bool get(Int& value) {
+				std::uint64_t wide{};
+				if (!get(wide) || wide > std::numeric_limits<Int>::max())
+					return false;
+				value = static_cast<Int>(wide);
+				return true;
+			}
+
+			bool get(std::string& text) {
+				size_t length{};
+				if (!get(length) || length > data_.size()) return false;
+				text.assign(reinterpret_cast<char const*>(data_.data()),
+				            length);
+				data_ = data_.subspan(length);
+				return true;
+			}
+
+			// each node takes at least two bytes, which keeps a damaged
+			// count from reserving more than the data could hold
+			bool get_count(size_t& count) {
+				return get(count) && count <= data_.size() / 2;
+			}
+
+			// `pos` is the end of the previous item; the items must not
+			// overlap, so the last of them is the furthest one
+			bool get(highlighted_line& items, size_t& pos, unsigned depth) {
+				if (depth > max_depth) return false;
+
+				size_t count{};
+				if (!get_count(count)) return false;
+				items.reserve(count);
+				for (size_t index = 0; index < count; ++index) {
+					unsigned tag{};
+					if (!get(tag)) return false;
+
+					if (tag == 0) {
+						size_t begin{}, length{};
+						if (!get(begin) || !get(length) || begin < pos ||
+						    length > std::numeric_limits<size_t>::max() - begin)
+							return false;
+						pos = begin + length;
+						items.push_back(text_span{.begin = begin, .end = pos});
+						continue;
+					}
+
+					unsigned kind{};
+					highlighted_line contents{};
+					if (tag != 1 || !get(kind) ||
+					    !get(contents, pos, depth + 1))
+						return false;
+					items.push_back(span{kind, std::move(contents)});
+				}
+				return true;
+			}
+
+		private:
+			std::span<std::byte const> data_;
+		};
+	}  // namespace
+
+	std::vector<std::byte> highlights::serialize() const {
+		writer out{};
+
+		out.put(dict.size());
+		for (auto const& [kind, name] : dict) {
+			out.put(kind);
+			out.put(std::string_view{name});
+		}
+
+		out.put(lines.size());
+		size_t prev{};
+		for (auto const& line : lines) {
+			out.put(line.start - prev);
+			out.put(line.contents);
+			prev = line.start;
+		}
+
+		return std::move(out.result);
+	}
+
+	std::optional<highlights> highlights::deserialize(
+	    std::span<std::byte const> data,
+	    std::size_t contents_length) {
+		reader in{data};
+		highlights result{};
+
+		size_t count{};
+		if (!in.get_count(count)) return std::nullopt;
+		for (size_t index = 0; index < count; ++index) {
+			unsigned kind{};
+			std::string name{};
+			if (!in.get(kind) || !in.get(name)) return std::nullopt;
+			result.dict[kind] = std::move(name);
+		}
+
+		if (!in.get_count(count)) return std::nullopt;
+		result.lines.reserve(count);
+		size_t start{};
+		for (size_t index = 0; index < count; ++index) {
+			size_t distance{};
+			if (!in.get(distance) || distance > contents_length - start)
+				return std::nullopt;
+			start += distance;
+
+			size_t end{};
+			highlighted_line contents{};
+			if (!in.get(contents, end, 0) || end > contents_length - start)
+				return std::nullopt;
+			result.lines.push_back({.start = start,
+			                        .contents = std::move(contents)});
+		}
+
+		if (!in.finished()) return std::nullopt;
+		return result;
+	}
+
+	std::vector<std::byte> checkpoints::serialize() const {
+		writer out{};
+
+		out.put(entries.size());
+		entry prev{.line = 0, .offset = 0};
+		for (auto const& item : entries) {
+			out.put(item.line - prev.line);
+			out.put(item.offset - prev.offset);
+			prev = item;
+		}
+
+		return std::move(out.result);
+	}
+
+	std::optional<checkpoints> checkpoints::deserialize(
+	    std::span<std::byte const> data,
+	    std::size_t contents_length) {
+		reader in{data};
+		checkpoints result{};
+
+		size_t count{};
+		if (!in.get_count(count)) return std::nullopt;
+		result.entries.reserve(count);
+		entry prev{.line = 0, .offset = 0};
+		for (size_t index = 0; index < count; ++index) {
+			unsigned line_delta{};
+			size_t offset_delta{};
+			if (!in.get(line_delta) || !in.get(offset_delta) ||
+			    (index && !line_delta) ||
+			    line_delta > std::numeric_limits<unsigned>::max() - prev.line ||
+			    offset_delta > contents_length - prev.offset)
+				return std::nullopt;
+			prev = {.line = prev.line + line_delta,
+			        .offset = prev.offset + offset_delta};
+			result.entries.push_back(prev);
+		}
+
+		if (!in.finished()) return std::nullopt;
+		return result;
+	}
+}  // namespace lighter
@@ -0,0 +1,133 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <gtest/gtest.h>
+#include <string>
+#include "support.hh"
+
+#ifdef __has_include
+#if __has_include("hilite/syntax/cxx.hh")
+#define HAS_CXX 1
+#endif
+#endif
+
+namespace lighter::testing {
+	using namespace std::literals;
+	using line_range = std::pair<unsigned, unsigned>;
+
+	namespace {
+		bool in_ranges(unsigned line, std::span<line_range const> ranges) {
+			for (auto const& [first, last] : ranges) {
+				if (first <= line && line <= last) return true;
+			}
+			return false;
+		}
+
+		void expect_same_lines(highlights const& full,
+		                       highlights const& partial,
+		                       std::span<line_range const> ranges) {
+			ASSERT_EQ(full.lines.size(), partial.lines.size());
+			for (unsigned line = 0; line < full.lines.size(); ++line) {
+				auto const& expected = full.lines[line];
+				auto const& actual = partial.lines[line];
+				EXPECT_EQ(expected.start, actual.start) << "line: " << line;
+				if (in_ranges(line, ranges)) {
+					EXPECT_EQ(expected.contents, actual.contents)
+					    << "line: " << line;
+					continue;
+				}
+				auto const length = length_of(expected.contents);
+				auto const plain =
+				    length ? highlighted_line{text_span{0, length}}
+				           : highlighted_line{};
+				EXPECT_EQ(plain, actual.contents) << "line: " << line;
+			}
+		}
+	}  // namespace
+
+	TEST(checkpoints, none) {
+		static constexpr auto text = "first\r\nsecond\rthird\n\nlast"sv;
+		static constexpr line_range ranges[] = {{1, 2}};
+
+		auto const full = highlights::from(text, "text.txt"sv);
+
+		checkpoints table{};
+		auto const first = highlights::from(text, "text.txt"sv, ranges, table);
+		expect_same_lines(full, first, ranges);
+		ASSERT_EQ((std::vector<checkpoints::entry>{{0, 0}}), table.entries);
+
+		auto const second =
+		    highlights::from(text, "text.txt"sv, ranges, table);
+		expect_same_lines(full, second, ranges);
+	}
+
+#ifdef HAS_CXX
+	namespace {
+		std::vector<std::size_t> line_starts(std::string_view text) {
+			std::vector<std::size_t> result{0};
+			for (std::size_t pos = 0; pos < text.size(); ++pos) {
+				if (text[pos] == '\n') result.push_back(pos + 1);
+			}
+			return result;
+		}
+
+		// lines 31-36 are inside a block comment and lines 69-71 are
+		// inside a raw string, the tokenizer cannot start on any of them
+		std::string cxx_source() {
+			std::string result{};
+			for (unsigned line = 0; line < 100; ++line) {
+				if (line == 30)
+					result.append("/* comment");
+				else if (line > 30 && line < 36)
+					result.append("   comment");
+				else if (line == 36)
+					result.append("   comment */ int b = 0;");
+				else if (line == 68)
+					result.append("auto s = R\"(");
+				else if (line > 68 && line < 71)
+					result.append("   raw string");
+				else if (line == 71)
+					result.append(")\";");
+				else
+					result.append("int a = ").append(std::to_string(line));
+				result.push_back('\n');
+			}
+			return result;
+		}
+	}  // namespace
+
+	TEST(checkpoints, cxx_table) {
+		auto const text = cxx_source();
+		auto const starts = line_starts(text);
+		static constexpr line_range ranges[] = {{0, 1}};
+
+		checkpoints table{};
+		highlights::from(text, "file.cc"sv, ranges, table);
+
+		std::vector<checkpoints::entry> const expected{
+		    {.line = 0, .offset = starts[0]},
+		    {.line = 37, .offset = starts[37]},
+		    {.line = 72, .offset = starts[72]},
+		};
+		ASSERT_EQ(expected, table.entries);
+	}
+
+	TEST(checkpoints, cxx_ranges) {
+		auto const text = cxx_source();
+		static constexpr line_range ranges[] = {
+		    {3, 5}, {33, 40}, {45, 46}, {70, 99}};
+
+		auto const full = highlights::from(text, "file.cc"sv);
+
+		checkpoints table{};
+		auto const first = highlights::from(text, "file.cc"sv, ranges, table);
+		expect_same_lines(full, first, ranges);
+		ASSERT_EQ(full.dict, first.dict);
+
+		auto const second =
+		    highlights::from(text, "file.cc"sv, ranges, table);
+		expect_same_lines(full, second, ranges);
+		ASSERT_EQ(full.dict, second.dict);
+	}
+#endif
+}  // namespace lighter::testing
@@ -0,0 +1,111 @@
+// Copyright (c) 2024 Marcin Zdun
+// This code is licensed under MIT license (see LICENSE for details)
+
+#include <gtest/gtest.h>
+#include "support.hh"
+
+namespace lighter::testing {
+	using namespace std::literals;
+
+	namespace {
+		constexpr auto text = R"(#include <iostream>
+
+/* a comment
+   over two lines */
+int main() {
+    std::cout << "Hello, World!\n";
+})"sv;
+	}  // namespace
+
+	TEST(serialize, round_trip) {
+		for (auto const filename : {"hello.cc"sv, "hello.txt"sv}) {
+			auto const expected = highlights::from(text, filename);
+			auto const data = expected.serialize();
+			auto const actual = highlights::deserialize(data, text.size());
+			ASSERT_TRUE(actual) << filename;
+			ASSERT_EQ(expected, *actual) << filename;
+		}
+	}
+
+	TEST(serialize, empty) {
+		highlights const expected{};
+		auto const data = expected.serialize();
+		auto const actual = highlights::deserialize(data, 0);
+		ASSERT_TRUE(actual);
+		ASSERT_EQ(expected, *actual);
+	}
+
+	TEST(serialize, truncated) {
+		auto const data = highlights::from(text, "hello.cc"sv).serialize();
+		for (size_t size = 0; size < data.size(); ++size) {
+			auto const actual = highlights::deserialize(
+			    std::span{data}.first(size), text.size());
+			ASSERT_FALSE(actual) << "size: " << size;
+		}
+	}
+
+	TEST(serialize, trailing_bytes) {
+		auto data = highlights::from(text, "hello.cc"sv).serialize();
+		data.push_back(std::byte{0});
+		ASSERT_FALSE(highlights::deserialize(data, text.size()));
+	}
+
+	TEST(serialize, other_contents) {
+		auto const data = highlights::from(text, "hello.cc"sv).serialize();
+		ASSERT_FALSE(highlights::deserialize(data, text.size() - 1));
+	}
+
+	TEST(serialize, overlapping_spans) {
+		// one line, two text spans: [0, 5) and [3, 5)
+		static constexpr std::byte data[] = {
+		    std::byte{0}, std::byte{1}, std::byte{0}, std::byte{2},
+		    std::byte{0}, std::byte{0}, std::byte{5}, std::byte{0},
+		    std::byte{3}, std::byte{2},
+		};
+		ASSERT_FALSE(highlights::deserialize(data, 10));
+	}
+
+	TEST(serialize, checkpoints_round_trip) {
+		checkpoints const expected{
+		    .entries = {{.line = 0, .offset = 0},
+		                {.line = 32, .offset = 700},
+		                {.line = 70, .offset = 1500}},
+		};
+		auto const data = expected.serialize();
+		auto const actual = checkpoints::deserialize(data, 1500);
+		ASSERT_TRUE(actual);
+		ASSERT_EQ(expected, *actual);
+
+		for (size_t size = 0; size < data.size(); ++size) {
+			ASSERT_FALSE(
+			    checkpoints::deserialize(std::span{data}.first(size), 1500))
+			    << "size: " << size;
+		}
+		ASSERT_FALSE(checkpoints::deserialize(data, 1499));
+	}
+
+	TEST(serialize, checkpoints_same_line) {
+		// line 3 at 10, then line 3 again at 15
+		static constexpr std::byte once[] = {
+		    std::byte{1},
+		    std::byte{3},
+		    std::byte{10},
+		};
+		static constexpr std::byte twice[] = {
+		    std::byte{2}, std::byte{3}, std::byte{10},
+		    std::byte{0}, std::byte{5},
+		};
+		ASSERT_TRUE(checkpoints::deserialize(once, 20));
+		ASSERT_FALSE(checkpoints::deserialize(twice, 20));
+	}
+
+	TEST(serialize, syntax_of) {
+		ASSERT_EQ("none"sv, syntax_of("README"sv));
+		ASSERT_EQ("none"sv, syntax_of("dir.cc/README"sv));
+#ifdef __has_include
+#if __has_include("hilite/syntax/cxx.hh")
+		ASSERT_EQ("cxx"sv, syntax_of("src/main.cc"sv));
+#endif
+#endif
+	}
+}  // namespace lighter::testing